@@ -18,6 +18,7 @@
 #include "backend/Backend.h"
 #include "backend/LocaleUtils.h"
 #include "backend/platform/TerminalKbd.h"
+#include "backend/utils/Tracing.h"
 
 #include <QCommandLineParser>
 #include <QGuiApplication>
@@ -49,8 +50,13 @@ int main(int argc, char *argv[])
     backend::CliArgs cli_args = handle_cli_args(app);
     cli_args.portable |= portable_txt_present();
 
+    if (!cli_args.trace_path.isEmpty())
+        tracing::enable(cli_args.trace_path);
+
+    tracing::Span startup_span("main");
     backend::Backend backend(cli_args);
     backend.start();
+    startup_span.end();
 
     return app.exec();
 }
@@ -115,7 +121,18 @@ backend::CliArgs handle_cli_args(QGuiApplication& app)
                "automatically based on a list of known devices. Unfortunately this doesn't seem "
                "to work perfectly with some platforms and devices (eg. arcades), in which case "
                "you can disable this feature here."));
-			   
+
+
+    const QCommandLineOption arg_input_latency = add_cli_option(argparser,
+        QStringLiteral("measure-input-latency"),
+        tr_log("Logs the time between a gamepad button press and the next frame drawn after it"));
+
+    const QCommandLineOption arg_trace(QStringLiteral("trace"),
+        tr_log("Records the timeline of the startup, and saves it to the selected file "
+               "in the Chrome trace format (for chrome://tracing or Perfetto)"),
+        tr_log("file"));
+    argparser.addOption(arg_trace);
+
     argparser.addHelpOption();
     argparser.addVersionOption();
     argparser.process(app); // may quit!
@@ -127,5 +144,7 @@ backend::CliArgs handle_cli_args(QGuiApplication& app)
     args.enable_menu_reboot = !(argparser.isSet(arg_menu_kiosk) || argparser.isSet(arg_menu_reboot));
     args.enable_menu_settings = !(argparser.isSet(arg_menu_kiosk) || argparser.isSet(arg_menu_settings));
     args.enable_gamepad_autoconfig = !argparser.isSet(arg_gamepad_autoconfig);
+    args.measure_input_latency = argparser.isSet(arg_input_latency);
+    args.trace_path = argparser.value(arg_trace);
     return args;
 }
\ No newline at end of file
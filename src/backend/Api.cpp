@@ -17,7 +17,28 @@
 
 #include "Api.h"
 
+#include "AppSettings.h"
 #include "LocaleUtils.h"
+#include "utils/Tracing.h"
+
+
+namespace {
+// The artwork most likely shown in grids and lists
+QStringList primary_artwork(const QVector<model::Game*>& games)
+{
+    QStringList urls;
+    urls.reserve(games.size() * 3);
+
+    for (const model::Game* const game : games) {
+        const model::Assets& assets = game->assets();
+        for (const QString* const url : { &assets.boxFront(), &assets.screenshot(), &assets.logo() }) {
+            if (!url->isEmpty())
+                urls.append(*url);
+        }
+    }
+    return urls;
+}
+} // namespace
 
 
 ApiObject::ApiObject(const backend::CliArgs& args, QObject* parent)
@@ -39,6 +60,8 @@ ApiObject::ApiObject(const backend::CliArgs& args, QObject* parent)
             this, &ApiObject::onThemeChanged);
     connect(&m_internal.settings(), &model::Settings::providerReloadingRequested,
             this, &ApiObject::startScanning);
+    connect(&m_internal.system(), &model::System::appCloseRequested,
+            this, &ApiObject::onAppCloseRequested);
 
     connect(&m_providerman, &ProviderManager::gameCountChanged,
             &m_internal.meta(), &model::Meta::onGameCountUpdate);
@@ -49,6 +72,10 @@ ApiObject::ApiObject(const backend::CliArgs& args, QObject* parent)
     connect(&m_providerman, &ProviderManager::staticDataReady,
             this, &ApiObject::onStaticDataLoaded);
 
+    // the last step of the loading
+    connect(&m_providerman, &ProviderManager::dynamicDataReady,
+            this, []{ tracing::milestone("dynamic data ready"); });
+
     onThemeChanged();
 }
 
@@ -59,12 +86,16 @@ void ApiObject::startScanning()
 
     m_collections->clear();
     m_allGames->clear();
+    m_facets.clear();
+    m_thumbnail_pregen.stop();
 
-    m_providerman.startStaticSearch(m_providerman_collections, m_providerman_games);
+    m_providerman.startStaticSearch(m_providerman_collections, m_providerman_games, m_providerman_facets);
 }
 
 void ApiObject::onStaticDataLoaded()
 {
+    const tracing::Span span("ApiObject::onStaticDataLoaded");
+
     for (model::Game* const game : qAsConst(m_providerman_games)) {
         Q_ASSERT(game->parent() == nullptr);
         game->setParent(this);
@@ -94,9 +125,17 @@ void ApiObject::onStaticDataLoaded()
     std::swap(m_providerman_collections, coll_vec);
     m_collections->append(std::move(coll_vec));
 
+    model::FacetIndex facets;
+    std::swap(m_providerman_facets, facets);
+    m_facets.setIndex(std::move(facets));
+
     m_internal.meta().onUiReady();
     qInfo().noquote() << tr_log("%1 games found").arg(m_allGames->count());
 
+    m_thumbnail_pregen.setImages(primary_artwork(m_allGames->asList()));
+    if (AppSettings::general.pregen_thumbnails)
+        m_thumbnail_pregen.start();
+
     m_providerman.startDynamicSearch(m_allGames->asList(), m_collections->asList());
 }
 
@@ -112,6 +151,10 @@ void ApiObject::onGameFileLaunchRequested()
         return;
 
     m_launch_game_file = static_cast<model::GameFile*>(QObject::sender());
+
+    // the theme settings should not wait for the game to end
+    m_memory.flush();
+
     emit launchGameFile(m_launch_game_file);
 }
 
@@ -119,6 +162,9 @@ void ApiObject::onGameLaunchOk()
 {
     Q_ASSERT(m_launch_game_file);
     m_providerman.onGameLaunched(m_launch_game_file);
+
+    // don't take resources from the game
+    m_thumbnail_pregen.stop();
 }
 
 void ApiObject::onGameLaunchError(QString msg)
@@ -135,16 +181,28 @@ void ApiObject::onGameFinished()
 
     m_providerman.onGameFinished(m_launch_game_file);
     m_launch_game_file = nullptr;
+
+    if (AppSettings::general.pregen_thumbnails)
+        m_thumbnail_pregen.start();
 }
 
 void ApiObject::onGameFavoriteChanged()
 {
-    m_providerman.onGameFavoriteChanged(m_allGames->asList());
+    auto game = static_cast<model::Game*>(QObject::sender());
+    m_providerman.onGameFavoriteChanged(game);
 }
 
 void ApiObject::onGameWhitelistChanged()
 {
-    m_providerman.onGameWhitelistChanged(m_allGames->asList());
+    auto game = static_cast<model::Game*>(QObject::sender());
+    m_providerman.onGameWhitelistChanged(game);
+}
+
+void ApiObject::onAppCloseRequested()
+{
+    // save everything before the program quits or the system goes down
+    m_memory.save();
+    m_providerman.unloadProviders();
 }
 
 void ApiObject::onThemeChanged()
@@ -18,8 +18,11 @@
 #pragma once
 
 #include "CliArgs.h"
+#include "imggen/ThumbnailPregen.h"
 #include "model/gaming/Collection.h"
+#include "model/gaming/Facets.h"
 #include "model/gaming/Game.h"
+#include "model/images/ImagePrefetch.h"
 #include "model/internal/Internal.h"
 #include "model/keys/Keys.h"
 #include "model/memory/Memory.h"
@@ -39,6 +42,8 @@ class ApiObject : public QObject {
 
     QML_CONST_PROPERTY(model::Internal, internal)
     QML_CONST_PROPERTY(model::Keys, keys)
+    QML_CONST_PROPERTY(model::Facets, facets)
+    QML_CONST_PROPERTY(model::ImagePrefetch, prefetch)
     QML_READONLY_PROPERTY(model::Memory, memory)
     QML_OBJMODEL_PROPERTY(model::Collection, collections)
     QML_OBJMODEL_PROPERTY(model::Game, allGames)
@@ -76,6 +81,7 @@ private slots:
     void onStaticDataLoaded();
     void onGameFavoriteChanged();
     void onGameWhitelistChanged();
+    void onAppCloseRequested();
     void onGameFileSelectorRequested();
     void onGameFileLaunchRequested();
     void onThemeChanged();
@@ -87,7 +93,9 @@ private:
     // initialization
     QVector<model::Collection*> m_providerman_collections; // TODO: std::vector
     QVector<model::Game*> m_providerman_games;
+    model::FacetIndex m_providerman_facets;
     ProviderManager m_providerman;
+    ThumbnailPregen m_thumbnail_pregen;
 
     // used to trigger re-rendering of texts on locale change
     QString emptyString() const { return QString(); }
@@ -26,10 +26,18 @@
 #include "providers/pegasus_metadata/PegasusProvider.h"
 #include "providers/pegasus_playtime/PlaytimeStats.h"
 
+#include <QCoreApplication>
 #include <QFile>
+#include <QTimer>
 
 
 namespace {
+// quick repeated changes, like browsing the themes, are saved together
+static constexpr int SAVE_DELAY_MS = 500;
+
+bool g_save_pending = false;
+unsigned g_save_request = 0;
+
 HashMap<KeyEvent, QVector<QKeySequence>, EnumHash> default_keymap()
 {
     return {
@@ -96,6 +104,9 @@ General::General()
     , portable(true)
     , fullscreen(false)
     , mouse_support(true)
+    , pregen_thumbnails(true)
+    , startup_hook_timeout_ms(30000)
+    , script_timeout_ms(0)
     , locale() // intentionally blank
     , theme(DEFAULT_THEME)
 {}
@@ -152,10 +163,33 @@ void AppSettings::load_config()
 
 void AppSettings::save_config()
 {
+    g_save_pending = true;
+
+    // without an event loop, there's nothing to wait for
+    QCoreApplication* const app = QCoreApplication::instance();
+    if (!app) {
+        flush_config();
+        return;
+    }
+
+    // only the last request in a row does the saving
+    const unsigned request = ++g_save_request;
+    QTimer::singleShot(SAVE_DELAY_MS, app, [request]{
+        if (request == g_save_request)
+            flush_config();
+    });
+}
+
+void AppSettings::flush_config()
+{
+    if (!g_save_pending)
+        return;
+
+    g_save_pending = false;
     appsettings::SaveContext().save();
 
-    ScriptRunner::run(ScriptEvent::CONFIG_CHANGED);
-    ScriptRunner::run(ScriptEvent::SETTINGS_CHANGED);
+    ScriptRunner::runAsync(ScriptEvent::CONFIG_CHANGED);
+    ScriptRunner::runAsync(ScriptEvent::SETTINGS_CHANGED);
 }
 
 void AppSettings::parse_gamedirs(const std::function<void(const QString&)>& callback)
@@ -42,6 +42,11 @@ struct General {
     bool portable;
     bool fullscreen;
     bool mouse_support;
+    bool pregen_thumbnails;
+    int startup_hook_timeout_ms;
+    /// The event scripts running longer than this are stopped (`script-timeout`
+    /// in the settings file); 0 means they can run for any time
+    int script_timeout_ms;
     QString locale;
     QString theme;
 
@@ -75,7 +80,11 @@ struct AppSettings {
     static appsettings::Keys keys;
 
     static void load_config();
+    /// Saves the settings after a short delay, together with the changes
+    /// made in the meantime
     static void save_config();
+    /// Saves the pending changes right away
+    static void flush_config();
     static void parse_gamedirs(const std::function<void(const QString&)>&);
 
     static const std::map<QKeySequence, QString> gamepadButtonNames;
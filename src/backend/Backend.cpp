@@ -17,21 +17,24 @@
 
 #include "Backend.h"
 
+#include "AppSettings.h"
 #include "LocaleUtils.h"
 #include "Log.h"
 #include "ScriptRunner.h"
 #include "model/gaming/Game.h"
 #include "platform/PowerCommands.h"
+#include "utils/Tracing.h"
 
 #include <QCoreApplication>
 #include <QDebug>
-#include <QProcess>
 
 
 namespace {
 
 void on_app_close(AppCloseType type)
 {
+    AppSettings::flush_config();
+
     ScriptRunner::run(ScriptEvent::QUIT);
     switch (type) {
         case AppCloseType::REBOOT:
@@ -43,6 +46,8 @@ void on_app_close(AppCloseType type)
         default: break;
     }
 
+    tracing::save();
+
     qInfo().noquote() << tr_log("Closing JSF, goodbye!");
     Log::close();
 
@@ -71,25 +76,32 @@ Backend::Backend(const CliArgs& args)
     : init(args)
     , api(args)
     , frontend(&api)
+    , startup_hook(QStringLiteral("Steamworks.exe"), { QStringLiteral("/c"), QStringLiteral("dir"), QStringLiteral("/b") })
 {
+    ScriptRunner::watchScriptDirs();
+
     // the following communication is required because process handling
-    // and destroying/rebuilding the frontend stack are asynchronous tasks;
+    // and suspending/resuming the frontend stack are asynchronous tasks;
     // see the relevant classes
 
     // the Api asks the Launcher to start the game
     QObject::connect(&api, &ApiObject::launchGameFile,
                      &launcher, &ProcessLauncher::onLaunchRequested);
 
-    // the Launcher tries to start the game, ask the Frontend
-    // to tear down the UI, then report back to the Api
+    // the Frontend suspends the UI while the Launcher prepares and starts
+    // the game, then the Launcher reports back to the Api
+    QObject::connect(&launcher, &ProcessLauncher::processLaunching,
+                     &frontend, &FrontendLayer::suspend);
+
     QObject::connect(&launcher, &ProcessLauncher::processLaunchOk,
                      &api, &ApiObject::onGameLaunchOk);
 
     QObject::connect(&launcher, &ProcessLauncher::processLaunchError,
                      &api, &ApiObject::onGameLaunchError);
 
-    QObject::connect(&launcher, &ProcessLauncher::processLaunchOk,
-                     &frontend, &FrontendLayer::teardown);
+    // if the game could not be started, the UI comes back right away
+    QObject::connect(&launcher, &ProcessLauncher::processLaunchAborted,
+                     &frontend, &FrontendLayer::resume);
 
     QObject::connect(&frontend, &FrontendLayer::teardownComplete,
                      &launcher, &ProcessLauncher::onTeardownComplete);
@@ -99,27 +111,43 @@ Backend::Backend(const CliArgs& args)
                      &api, &ApiObject::onGameFinished);
 
     QObject::connect(&launcher, &ProcessLauncher::processFinished,
-                     &frontend, &FrontendLayer::rebuild);
+                     &frontend, &FrontendLayer::resume);
 
 
     // partial QML reload
     QObject::connect(&api.internal().meta(), &model::Meta::qmlClearCacheRequested,
                      &frontend, &FrontendLayer::clearCache);
 
+    // prepare the newly selected theme
+    QObject::connect(&api.internal().settings().themes(), &model::Themes::themeChanged,
+                     &frontend, [this]{ frontend.precompileTheme(api.internal().settings().themes().currentQmlDir()); });
+
+    // the result of the startup hook is shown by the frontend
+    QObject::connect(&startup_hook, &StartupHook::started,
+                     &api.internal().meta(), &model::Meta::onStartupHookStarted);
+    QObject::connect(&startup_hook, &StartupHook::finished,
+                     &api.internal().meta(), &model::Meta::onStartupHookFinished);
+
     // quit/reboot/shutdown request
     QObject::connect(&api.internal().system(), &model::System::appCloseRequested, on_app_close);
+
+    // the settings may be waiting to be saved when the program quits otherwise
+    if (QCoreApplication::instance())
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &AppSettings::flush_config);
 }
 
 void Backend::start()
 {
-	QProcess process;
-	process.start("Steamworks.exe",
-    QStringList() << "/c" << "dir" << "/b",
-    QIODevice::ReadWrite | QIODevice::Text);
-    process.waitForFinished();
-    process.close();
+    const tracing::Span span("Backend::start");
+    // the trace is saved once the first frame is shown and the games are loaded
+    tracing::expect_milestones(2);
+
     frontend.rebuild();
     api.startScanning();
+    startup_hook.start(AppSettings::general.startup_hook_timeout_ms);
+
+    // while the games are loading
+    frontend.precompileTheme(api.internal().settings().themes().currentQmlDir());
 }
 
 } // namespace backend
\ No newline at end of file
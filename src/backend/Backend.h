@@ -22,6 +22,7 @@
 #include "FrontendLayer.h"
 #include "PreInit.h"
 #include "ProcessLauncher.h"
+#include "StartupHook.h"
 
 
 namespace backend {
@@ -44,6 +45,9 @@ private:
     ApiObject api;
     FrontendLayer frontend;
     ProcessLauncher launcher;
+
+    // runs in parallel with the game scanning
+    StartupHook startup_hook;
 };
 
 } // namespace backend
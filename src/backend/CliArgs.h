@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <QString>
+
 namespace backend {
 struct CliArgs {
     bool portable = true;
@@ -26,5 +28,7 @@ struct CliArgs {
     bool enable_menu_reboot = false;
     bool enable_menu_settings = false;
     bool enable_gamepad_autoconfig = true;
+    bool measure_input_latency = false;
+    QString trace_path;
 };
 } // namespace backend
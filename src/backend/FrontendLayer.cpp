@@ -17,16 +17,33 @@
 
 #include "FrontendLayer.h"
 
+#include "LocaleUtils.h"
 #include "Paths.h"
 #include "imggen/BlurhashProvider.h"
+#include "imggen/ThumbnailProvider.h"
+#include "imggen/Thumbnails.h"
+#include "platform/MemoryInfo.h"
+#include "utils/Tracing.h"
 
+#include <QDebug>
+#include <QDirIterator>
 #include <QNetworkAccessManager>
 #include <QNetworkDiskCache>
+#include <QQmlComponent>
 #include <QQmlContext>
 #include <QQmlNetworkAccessManagerFactory>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <memory>
 
 
 namespace {
+// below this, the game gets all the memory we can give
+constexpr qint64 SUSPEND_MIN_AVAILABLE_MEMORY = 512 * 1024 * 1024;
+// a sanity limit for precompiling themes
+constexpr int PRECOMPILE_MAX_FILES = 512;
+// MediaPlayer.PlayingState
+constexpr int MEDIA_PLAYING_STATE = 1;
 
 class DiskCachedNAMFactory : public QQmlNetworkAccessManagerFactory {
 public:
@@ -46,6 +63,37 @@ QNetworkAccessManager* DiskCachedNAMFactory::create(QObject* parent)
     return nam;
 }
 
+// Media objects (MediaPlayer, Video, Audio) are recognized by their
+// interface, so the ones in third-party themes are found too
+bool is_playing_media(QObject* const obj)
+{
+    const QMetaObject* const meta = obj->metaObject();
+    const int state_idx = meta->indexOfProperty("playbackState");
+    if (state_idx < 0 || meta->indexOfMethod("pause()") < 0 || meta->indexOfMethod("play()") < 0)
+        return false;
+
+    return meta->property(state_idx).read(obj).toInt() == MEDIA_PLAYING_STATE;
+}
+
+void find_playing_media(QQuickItem* const item, std::vector<QPointer<QObject>>& out)
+{
+    if (is_playing_media(item))
+        out.emplace_back(item);
+
+    for (QObject* const child : item->children()) {
+        if (!qobject_cast<QQuickItem*>(child) && is_playing_media(child))
+            out.emplace_back(child);
+    }
+    for (QQuickItem* const child : item->childItems())
+        find_playing_media(child, out);
+}
+
+bool has_memory_for_suspend()
+{
+    const qint64 available = platform::memory::available_bytes();
+    return available < 0 || SUSPEND_MIN_AVAILABLE_MEMORY <= available;
+}
+
 } // namespace
 
 
@@ -53,6 +101,9 @@ FrontendLayer::FrontendLayer(QObject* const api, QObject* parent)
     : QObject(parent)
     , m_api(api)
     , m_engine(nullptr)
+    , m_blurhash_provider(nullptr)
+    , m_suspended(false)
+    , m_window_visibility(QWindow::AutomaticVisibility)
 {
     // Note: the pointer to the Api is non-owning and constant during the runtime
 }
@@ -60,15 +111,29 @@ FrontendLayer::FrontendLayer(QObject* const api, QObject* parent)
 void FrontendLayer::rebuild()
 {
     Q_ASSERT(!m_engine);
+    const tracing::Span span("FrontendLayer::rebuild");
+
+    m_blurhash_provider = new BlurhashProvider;
 
     m_engine = new QQmlApplicationEngine(this);
     m_engine->addImportPath(QStringLiteral("lib/qml"));
     m_engine->addImportPath(QStringLiteral("qml"));
     m_engine->setNetworkAccessManagerFactory(new DiskCachedNAMFactory);
-    m_engine->addImageProvider(QStringLiteral("blurhash"), new BlurhashProvider);
+    m_engine->addImageProvider(QStringLiteral("blurhash"), m_blurhash_provider);
+    m_engine->addImageProvider(QStringLiteral("thumbnail"), new ThumbnailProvider);
     m_engine->rootContext()->setContextProperty(QStringLiteral("api"), m_api);
     m_engine->load(QUrl(QStringLiteral("qrc:/frontend/main.qml")));
 
+    auto quick_win = qobject_cast<QQuickWindow*>(window());
+    if (quick_win && tracing::enabled()) {
+        // may be called on the render thread
+        auto conn = std::make_shared<QMetaObject::Connection>();
+        *conn = connect(quick_win, &QQuickWindow::frameSwapped, [conn]{
+            tracing::milestone("first frame");
+            QObject::disconnect(*conn);
+        });
+    }
+
     emit rebuildComplete();
 }
 
@@ -82,6 +147,102 @@ void FrontendLayer::teardown()
 
     m_engine->deleteLater();
     m_engine = nullptr;
+    m_blurhash_provider = nullptr;
+    m_suspended = false;
+    m_paused_media.clear();
+}
+
+QWindow* FrontendLayer::window() const
+{
+    Q_ASSERT(m_engine);
+
+    const QList<QObject*> roots = m_engine->rootObjects();
+    return roots.isEmpty()
+        ? nullptr
+        : qobject_cast<QWindow*>(roots.constFirst());
+}
+
+void FrontendLayer::suspend()
+{
+    Q_ASSERT(m_engine);
+    Q_ASSERT(!m_suspended);
+
+    QWindow* const win = window();
+    if (!win || !has_memory_for_suspend()) {
+        qInfo().noquote() << tr_log("Releasing the frontend while the game runs");
+        teardown();
+        return;
+    }
+
+    pause_media();
+
+    // without these, the graphics resources would stay allocated while hidden
+    auto quick_win = qobject_cast<QQuickWindow*>(win);
+    if (quick_win) {
+        quick_win->setPersistentOpenGLContext(false);
+        quick_win->setPersistentSceneGraph(false);
+    }
+    m_window_visibility = win->visibility();
+    win->hide();
+    if (quick_win)
+        quick_win->releaseResources();
+
+    m_blurhash_provider->clearCache();
+    thumbnails::clear_memory();
+    m_engine->collectGarbage();
+
+    m_suspended = true;
+
+    // like the teardown, the completion is reported asynchronously
+    QMetaObject::invokeMethod(this, "teardownComplete", Qt::QueuedConnection);
+}
+
+void FrontendLayer::resume()
+{
+    if (!m_suspended) {
+        rebuild();
+        return;
+    }
+
+    Q_ASSERT(m_engine);
+
+    QWindow* const win = window();
+    Q_ASSERT(win);
+    win->setVisibility(m_window_visibility);
+    win->requestActivate();
+
+    auto quick_win = qobject_cast<QQuickWindow*>(win);
+    if (quick_win) {
+        quick_win->setPersistentOpenGLContext(true);
+        quick_win->setPersistentSceneGraph(true);
+    }
+
+    resume_media();
+    m_suspended = false;
+
+    emit rebuildComplete();
+}
+
+void FrontendLayer::pause_media()
+{
+    Q_ASSERT(m_paused_media.empty());
+
+    auto quick_win = qobject_cast<QQuickWindow*>(window());
+    if (!quick_win)
+        return;
+
+    find_playing_media(quick_win->contentItem(), m_paused_media);
+    for (const QPointer<QObject>& media : m_paused_media)
+        QMetaObject::invokeMethod(media.data(), "pause");
+}
+
+void FrontendLayer::resume_media()
+{
+    for (const QPointer<QObject>& media : m_paused_media) {
+        if (media)
+            QMetaObject::invokeMethod(media.data(), "play");
+    }
+    m_paused_media.clear();
 }
 
 void FrontendLayer::clearCache()
@@ -89,3 +250,30 @@ void FrontendLayer::clearCache()
     Q_ASSERT(m_engine);
     m_engine->clearComponentCache();
 }
+
+void FrontendLayer::precompileTheme(const QString& root_dir)
+{
+    // the built-in theme is compiled ahead of time
+    if (!m_engine || root_dir.isEmpty() || root_dir.startsWith(QLatin1Char(':')))
+        return;
+
+    constexpr auto filters = QDir::Files | QDir::Readable | QDir::NoDotAndDotDot;
+    constexpr auto flags = QDirIterator::Subdirectories | QDirIterator::FollowSymlinks;
+
+    int file_cnt = 0;
+    QDirIterator file_it(root_dir, { QStringLiteral("*.qml") }, filters, flags);
+    while (file_it.hasNext() && file_cnt < PRECOMPILE_MAX_FILES) {
+        const QUrl url = QUrl::fromLocalFile(file_it.next());
+        file_cnt++;
+
+        // the compiled types stay in the engine's cache after the component is gone
+        auto component = new QQmlComponent(m_engine, url, QQmlComponent::Asynchronous, m_engine);
+        if (component->isLoading()) {
+            connect(component, &QQmlComponent::statusChanged,
+                    component, &QObject::deleteLater);
+        }
+        else {
+            component->deleteLater();
+        }
+    }
+}
@@ -18,15 +18,26 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
 #include <QQmlApplicationEngine>
+#include <QWindow>
+#include <vector>
+
+class BlurhashProvider;
 
 
 /// Manages the dynamic reload of the frontend layer
 ///
-/// When we launch a game, the frontend stack will be teared down to save
-/// resources. However, this happens asyncronously (see QObject destructor).
-/// When it's done, the relevant signal will be triggered. After the actual
-/// execution is finished, the frontend layer can be rebuilt again.
+/// When we launch a game, the frontend stack will be suspended or teared down
+/// to save resources. However, this happens asyncronously (see QObject
+/// destructor). When it's done, the relevant signal will be triggered. After
+/// the actual execution is finished, the frontend layer can be resumed or
+/// rebuilt again.
+///
+/// Suspending keeps the engine, the loaded theme and its bindings, but hides
+/// the window, which releases the scene graph and its textures, and pauses
+/// the playing media. If the system is low on memory, the whole stack is
+/// teared down instead.
 ///
 /// Some funtions require a pointer to the API object, to connect and make
 /// it accessible to the frontend.
@@ -39,8 +50,15 @@ public:
     void rebuild();
     void teardown();
 
+    void suspend();
+    void resume();
+
     void clearCache();
 
+    /// Compiles the QML files of a theme in the background, so they are
+    /// ready (and in the disk cache of the engine) by the time they're used
+    void precompileTheme(const QString& root_dir);
+
 signals:
     void rebuildComplete();
     void teardownComplete();
@@ -48,4 +66,13 @@ signals:
 private:
     QObject* const m_api;
     QQmlApplicationEngine* m_engine;
+    BlurhashProvider* m_blurhash_provider;
+
+    bool m_suspended;
+    QWindow::Visibility m_window_visibility;
+    std::vector<QPointer<QObject>> m_paused_media;
+
+    QWindow* window() const;
+    void pause_media();
+    void resume_media();
 };
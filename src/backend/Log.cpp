@@ -23,7 +23,10 @@
 
 #include <QDateTime>
 #include <QFile>
+#include <QMutex>
 #include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
 
 LogSink::LogSink() = default;
 LogSink::~LogSink() = default;
@@ -37,15 +40,18 @@ public:
         : m_stream(stdout)
     {}
 
-    void info(const QString& msg) override {
+    void info(const QString&, const QString& msg) override {
         colorlog(m_pre_info, msg);
     }
-    void warning(const QString& msg) override {
+    void warning(const QString&, const QString& msg) override {
         colorlog(m_pre_warning, msg);
     }
-    void error(const QString& msg) override {
+    void error(const QString&, const QString& msg) override {
         colorlog(m_pre_error, msg);
     }
+    void flush() override {
+        m_stream.flush();
+    }
 
 private:
     QTextStream m_stream;
@@ -63,7 +69,7 @@ private:
 #endif
 
     void colorlog(const char* const prefix, const QString& msg) {
-        m_stream << prefix << QChar(' ') << msg << m_fmt_reset << endl;
+        m_stream << prefix << QChar(' ') << msg << m_fmt_reset << QChar('\n');
     }
 };
 
@@ -82,15 +88,16 @@ public:
         m_stream.setDevice(&m_file);
     }
 
-    void info(const QString& msg) override {
-        datelog(m_marker_info, msg);
+    void info(const QString& time, const QString& msg) override {
+        datelog(time, m_marker_info, msg);
     }
-    void warning(const QString& msg) override {
-        datelog(m_marker_warning, msg);
-        m_stream.flush();
+    void warning(const QString& time, const QString& msg) override {
+        datelog(time, m_marker_warning, msg);
     }
-    void error(const QString& msg) override {
-        datelog(m_marker_error, msg);
+    void error(const QString& time, const QString& msg) override {
+        datelog(time, m_marker_error, msg);
+    }
+    void flush() override {
         m_stream.flush();
     }
 
@@ -106,8 +113,8 @@ private:
         return paths::writableConfigDir() + QLatin1String("/lastrun.log");
     }
 
-    void datelog(const char* const marker, const QString& msg) {
-        m_stream << QDateTime::currentDateTime().toString(Qt::ISODate) << QChar(' ')
+    void datelog(const QString& time, const char* const marker, const QString& msg) {
+        m_stream << time << QChar(' ')
                  << marker << QChar(' ')
                  << msg << QChar('\n');
     }
@@ -118,6 +125,100 @@ private:
 
 namespace {
 
+// above this, new messages are dropped instead of blocking the caller
+constexpr size_t QUEUE_CAPACITY = 16384;
+// the same message is written at most once in this time, the rest are counted
+constexpr qint64 REPEAT_WINDOW_MS = 1000;
+
+enum class Severity : unsigned char {
+    INFO,
+    WARNING,
+    CRITICAL,
+};
+
+struct LogEntry {
+    Severity severity;
+    qint64 time_ms;
+    QString message;
+};
+
+struct LogQueue {
+    QMutex guard;
+    QWaitCondition has_work;
+    QWaitCondition written;
+
+    std::vector<LogEntry> entries;
+    quint64 pushed_cnt = 0;
+    quint64 written_cnt = 0;
+    size_t dropped_cnt = 0;
+
+    bool accepting = false;
+    bool stopping = false;
+    QThread* thread = nullptr;
+
+    ~LogQueue() {
+        // in case the program ends without closing the log
+        stop();
+    }
+
+    void stop() {
+        if (!thread)
+            return;
+
+        {
+            const QMutexLocker lock(&guard);
+            accepting = false;
+            stopping = true;
+            has_work.wakeOne();
+        }
+
+        // everything logged until now is still written out
+        thread->wait();
+        delete thread;
+        thread = nullptr;
+    }
+};
+
+class WriterThread : public QThread {
+public:
+    explicit WriterThread(void (*func)())
+        : m_func(func)
+    {}
+
+protected:
+    void run() override {
+        m_func();
+    }
+
+private:
+    void (* const m_func)();
+};
+
+LogQueue& log_queue()
+{
+    static LogQueue instance;
+    return instance;
+}
+
+void push(Severity severity, const QString& message)
+{
+    const qint64 time_ms = QDateTime::currentMSecsSinceEpoch();
+    LogQueue& queue = log_queue();
+
+    const QMutexLocker lock(&queue.guard);
+    if (!queue.accepting)
+        return;
+
+    if (queue.entries.size() >= QUEUE_CAPACITY) {
+        queue.dropped_cnt++;
+        return;
+    }
+
+    queue.entries.push_back({ severity, time_ms, message });
+    queue.pushed_cnt++;
+    queue.has_work.wakeOne();
+}
+
 void on_qt_message(QtMsgType type, const QMessageLogContext& context, const QString& msg)
 {
     const QString prepared_msg = qFormatLogMessage(type, context, msg);
@@ -130,8 +231,12 @@ void on_qt_message(QtMsgType type, const QMessageLogContext& context, const QStr
             Log::warning(prepared_msg);
             break;
         case QtMsgType::QtCriticalMsg:
+            Log::error(prepared_msg);
+            break;
         case QtMsgType::QtFatalMsg:
+            // the program is aborted after this
             Log::error(prepared_msg);
+            Log::flush();
             break;
         default:
             Q_UNREACHABLE();
@@ -146,26 +251,171 @@ std::vector<std::unique_ptr<LogSink>> Log::m_sinks {};
 
 void Log::init(bool silent)
 {
+    LogQueue& queue = log_queue();
+    Q_ASSERT(!queue.thread);
+
+    {
+        const QMutexLocker lock(&queue.guard);
+        queue.accepting = true;
+        queue.stopping = false;
+    }
+
      if (!silent)
         m_sinks.emplace_back(new logsinks::Terminal());
 
     m_sinks.emplace_back(new logsinks::LogFile());
 
+    queue.thread = new WriterThread(&Log::write_loop);
+    queue.thread->setObjectName(QStringLiteral("log writer"));
+    queue.thread->start(QThread::LowPriority);
+
     // redirect Qt messages to the Log too
     qInstallMessageHandler(on_qt_message);
 }
 
 void Log::close()
 {
+    log_queue().stop();
     m_sinks.clear();
 }
 
-#define FORALLSINK_CALLER(method) \
-    void Log::method(const QString& message) \
-    { \
-        for (const auto& sink : m_sinks) \
-            sink->method(message); \
+void Log::flush()
+{
+    LogQueue& queue = log_queue();
+
+    // would wait for itself
+    if (!queue.thread || QThread::currentThread() == queue.thread)
+        return;
+
+    QMutexLocker lock(&queue.guard);
+    const quint64 target_cnt = queue.pushed_cnt;
+    while (queue.written_cnt < target_cnt && queue.thread->isRunning())
+        queue.written.wait(&queue.guard, 100);
+}
+
+void Log::info(const QString& message)
+{
+    push(Severity::INFO, message);
+}
+
+void Log::warning(const QString& message)
+{
+    push(Severity::WARNING, message);
+}
+
+void Log::error(const QString& message)
+{
+    push(Severity::CRITICAL, message);
+}
+
+void Log::write_loop()
+{
+    LogQueue& queue = log_queue();
+
+    // the date text is only updated once per second
+    qint64 time_str_secs = -1;
+    QString time_str;
+    const auto format_time = [&time_str_secs, &time_str](qint64 time_ms) -> const QString& {
+        const qint64 secs = time_ms / 1000;
+        if (secs != time_str_secs) {
+            time_str_secs = secs;
+            time_str = QDateTime::fromMSecsSinceEpoch(time_ms).toString(Qt::ISODate);
+        }
+        return time_str;
+    };
+
+    const auto write = [&format_time](Severity severity, qint64 time_ms, const QString& message) {
+        const QString& time = format_time(time_ms);
+        for (const auto& sink : m_sinks) {
+            switch (severity) {
+                case Severity::INFO:
+                    sink->info(time, message);
+                    break;
+                case Severity::WARNING:
+                    sink->warning(time, message);
+                    break;
+                case Severity::CRITICAL:
+                    sink->error(time, message);
+                    break;
+            }
+        }
+    };
+
+    // the last written message, for detecting repeats
+    bool has_last = false;
+    LogEntry last { Severity::INFO, 0, QString() };
+    qint64 last_repeat_ms = 0;
+    size_t repeat_cnt = 0;
+
+    const auto write_repeats = [&]{
+        if (repeat_cnt == 0)
+            return;
+
+        write(last.severity, last_repeat_ms,
+            tr_log("(the previous message was repeated %1 more times)").arg(repeat_cnt));
+        repeat_cnt = 0;
+    };
+
+    std::vector<LogEntry> batch;
+    while (true) {
+        size_t dropped_cnt = 0;
+        bool stopping = false;
+        {
+            QMutexLocker lock(&queue.guard);
+            while (queue.entries.empty() && !queue.stopping) {
+                // pending repeats are written if nothing else comes for a while
+                if (repeat_cnt == 0)
+                    queue.has_work.wait(&queue.guard);
+                else if (!queue.has_work.wait(&queue.guard, REPEAT_WINDOW_MS))
+                    break;
+            }
+
+            batch.swap(queue.entries);
+            std::swap(dropped_cnt, queue.dropped_cnt);
+            stopping = queue.stopping;
+        }
+
+        if (batch.empty())
+            write_repeats();
+
+        for (LogEntry& entry : batch) {
+            const bool is_repeat = has_last
+                && entry.severity == last.severity
+                && entry.time_ms - last.time_ms < REPEAT_WINDOW_MS
+                && entry.message == last.message;
+            if (is_repeat) {
+                repeat_cnt++;
+                last_repeat_ms = entry.time_ms;
+                continue;
+            }
+
+            write_repeats();
+            write(entry.severity, entry.time_ms, entry.message);
+
+            has_last = true;
+            last = std::move(entry);
+        }
+
+        if (dropped_cnt > 0) {
+            write_repeats();
+            write(Severity::WARNING, QDateTime::currentMSecsSinceEpoch(),
+                tr_log("%1 log messages were dropped, too many were logged at once").arg(dropped_cnt));
+        }
+
+        if (stopping)
+            write_repeats();
+
+        for (const auto& sink : m_sinks)
+            sink->flush();
+
+        {
+            const QMutexLocker lock(&queue.guard);
+            queue.written_cnt += batch.size();
+            queue.written.wakeAll();
+
+            if (stopping && queue.entries.empty())
+                break;
+        }
+        batch.clear();
     }
-FORALLSINK_CALLER(info)
-FORALLSINK_CALLER(warning)
-FORALLSINK_CALLER(error)
+}
@@ -24,18 +24,27 @@
 #include <vector>
 
 
+/// Receives the log messages, on the log writer thread
 class LogSink {
 public:
     LogSink();
     virtual ~LogSink();
     NO_COPY_NO_MOVE(LogSink)
 
-    virtual void info(const QString&) = 0;
-    virtual void warning(const QString&) = 0;
-    virtual void error(const QString&) = 0;
+    /// The time is the ISO date of the moment the message was logged
+    virtual void info(const QString& time, const QString& message) = 0;
+    virtual void warning(const QString& time, const QString& message) = 0;
+    virtual void error(const QString& time, const QString& message) = 0;
+
+    /// Called after every batch of messages
+    virtual void flush() = 0;
 };
 
 
+/// Logging, usable from any thread
+///
+/// The messages are only queued by the calling thread; they are formatted
+/// and written out by the sinks on a background thread.
 class Log {
 public:
     Log() = delete;
@@ -48,6 +57,11 @@ public:
     static void warning(const QString& message);
     static void error(const QString& message);
 
+    /// Waits until every message logged so far is written out
+    static void flush();
+
 private:
     static std::vector<std::unique_ptr<LogSink>> m_sinks;
+
+    static void write_loop();
 };
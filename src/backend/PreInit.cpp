@@ -23,8 +23,10 @@
 #include "Log.h"
 #include "Paths.h"
 #include "model/gaming/Collection.h"
+#include "model/gaming/Facets.h"
 #include "model/gaming/Game.h"
 #include "model/gaming/Assets.h"
+#include "model/images/ImagePrefetch.h"
 #include "model/keys/Key.h"
 #include "utils/FolderListModel.h"
 
@@ -71,6 +73,8 @@ void register_api_classes()
     qmlRegisterUncreatableType<model::Key>(API_URI, 0, 10, "Key", error_msg);
     qmlRegisterUncreatableType<model::Keys>(API_URI, 0, 10, "Keys", error_msg);
     qmlRegisterUncreatableType<model::GamepadManager>(API_URI, 0, 12, "GamepadManager", error_msg);
+    qmlRegisterUncreatableType<model::Facets>(API_URI, 0, 13, "Facets", error_msg);
+    qmlRegisterUncreatableType<model::ImagePrefetch>(API_URI, 0, 13, "ImagePrefetch", error_msg);
 
     // QML utilities
     qmlRegisterType<FolderListModel>("Pegasus.FolderListModel", 1, 0, "FolderListModel");
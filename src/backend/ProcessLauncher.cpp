@@ -22,43 +22,16 @@
 #include "model/gaming/Game.h"
 #include "model/gaming/GameFile.h"
 #include "platform/TerminalKbd.h"
-#include "utils/CommandTokenizer.h"
+#include "utils/CommandTemplate.h"
 
 #include <QDebug>
 #include <QDir>
-#include <QRegularExpression>
+#include <QFutureWatcher>
 
 
 namespace {
 static constexpr auto SEPARATOR = "----------------------------------------";
 
-void replace_env_vars(QString& param)
-{
-    const auto env = QProcessEnvironment::systemEnvironment();
-    const QRegularExpression rx_env(QStringLiteral("{env.([^}]+)}"));
-
-    auto match = rx_env.match(param);
-    while (match.hasMatch()) {
-        const int from = match.capturedStart();
-        const int len = match.capturedLength();
-        param.replace(from, len, env.value(match.captured(1)));
-
-        const int match_offset = match.capturedStart() + match.capturedLength();
-        match = rx_env.match(param, match_offset);
-    }
-}
-
-void replace_variables(QString& param, const QFileInfo& finfo)
-{
-    param
-        .replace(QLatin1String("{file.path}"), QDir::toNativeSeparators(finfo.absoluteFilePath()))
-        .replace(QLatin1String("{file.name}"), finfo.fileName())
-        .replace(QLatin1String("{file.basename}"), finfo.completeBaseName())
-        .replace(QLatin1String("{file.dir}"), QDir::toNativeSeparators(finfo.absolutePath()));
-
-    replace_env_vars(param);
-}
-
 bool contains_slash(const QString& str)
 {
     return str.contains(QChar('/')) || str.contains(QChar('\\'));
@@ -115,28 +88,33 @@ QString abs_workdir(const QString& workdir, const QString& base_dir, const QStri
 ProcessLauncher::ProcessLauncher(QObject* parent)
     : QObject(parent)
     , m_process(nullptr)
+    , m_state(State::IDLE)
+    , m_process_done(false)
+    , m_teardown_done(false)
+    , m_scripts_time(-1)
+    , m_started_time(-1)
+    , m_teardown_time(-1)
 {}
 
 void ProcessLauncher::onLaunchRequested(const model::GameFile* q_gamefile)
 {
     Q_ASSERT(q_gamefile);
+    Q_ASSERT(m_state == State::IDLE);
 
     const model::GameFile& gamefile = *q_gamefile;
     const model::Game& game = static_cast<model::Game&>(*gamefile.parent());
 
-    const QString raw_launch_cmd =
-#if defined(Q_OS_LINUX) && defined(PEGASUS_INSIDE_FLATPAK)
-        QLatin1String("flatpak-spawn --host ") % game.launchCmd();
-#else
-        game.launchCmd();
-#endif
-
-
     // TODO: in the future, check the gamefile's own launch command first
 
-    QStringList args = ::utils::tokenize_command(raw_launch_cmd);
-    for (QString& arg : args)
-        replace_variables(arg, gamefile.fileinfo());
+    // the templates are normally prepared during the scanning
+    QStringList args = game.launchCmdTemplate()
+        ? game.launchCmdTemplate()->expand(gamefile.fileinfo())
+        : ::utils::CommandTemplate::fromCommand(game.launchCmd()).expand(gamefile.fileinfo());
+
+#if defined(Q_OS_LINUX) && defined(PEGASUS_INSIDE_FLATPAK)
+    if (!args.isEmpty())
+        args = QStringList { QStringLiteral("flatpak-spawn"), QStringLiteral("--host") } + args;
+#endif
 
     QString command = args.isEmpty() ? QString() : args.takeFirst();
     if (command.isEmpty()) {
@@ -164,13 +142,27 @@ void ProcessLauncher::onLaunchRequested(const model::GameFile* q_gamefile)
         ? QFileInfo(command).absolutePath()
         : gamefile.fileinfo().absolutePath();
 
-    QString workdir = game.launchWorkdir();
-    replace_variables(workdir, gamefile.fileinfo());
+    QString workdir = game.launchWorkdirTemplate()
+        ? game.launchWorkdirTemplate()->expandText(gamefile.fileinfo())
+        : ::utils::CommandTemplate::fromText(game.launchWorkdir()).expandText(gamefile.fileinfo());
     workdir = helpers::abs_workdir(workdir, game.launchCmdBasedir(), default_workdir);
 
 
-    beforeRun(gamefile.fileinfo().absoluteFilePath());
-    runProcess(command, args, workdir);
+    m_state = State::LAUNCHING;
+    m_process_done = false;
+    m_teardown_done = false;
+    m_scripts_time = -1;
+    m_started_time = -1;
+    m_teardown_time = -1;
+    m_launch_timer.start();
+
+    // the frontend is released while the game is being prepared
+    emit processLaunching();
+
+    beforeRun(gamefile.fileinfo().absoluteFilePath(), [this, command, args, workdir]{
+        m_scripts_time = m_launch_timer.elapsed();
+        runProcess(command, args, workdir);
+    });
 }
 
 void ProcessLauncher::runProcess(const QString& command, const QStringList& args, const QString& workdir)
@@ -192,22 +184,31 @@ void ProcessLauncher::runProcess(const QString& command, const QStringList& args
     m_process->setInputChannelMode(QProcess::ForwardedInputChannel);
     m_process->setWorkingDirectory(workdir);
     m_process->start(command, args, QProcess::ReadOnly);
-    m_process->waitForStarted(-1);
 }
 
 void ProcessLauncher::onTeardownComplete()
 {
-    Q_ASSERT(m_process);
+    // the launch may have failed in the meantime
+    if (m_state == State::IDLE)
+        return;
 
-    m_process->waitForFinished(-1);
-    emit processFinished();
+    m_teardown_done = true;
+    m_teardown_time = m_launch_timer.elapsed();
+    printLaunchTimes();
+
+    finishIfDone();
 }
 
 void ProcessLauncher::onProcessStarted()
 {
     Q_ASSERT(m_process);
+    m_state = State::RUNNING;
+    m_started_time = m_launch_timer.elapsed();
+
     qInfo().noquote() << tr_log("Process %1 started").arg(m_process->processId());
     qInfo().noquote() << SEPARATOR;
+    printLaunchTimes();
+
     emit processLaunchOk();
 }
 
@@ -220,8 +221,10 @@ void ProcessLauncher::onProcessError(QProcess::ProcessError error)
     switch (m_process->state()) {
         case QProcess::Starting:
         case QProcess::NotRunning:
-            emit processLaunchError(message);
             qWarning().noquote() << message;
+            m_state = State::IDLE;
+            emit processLaunchAborted();
+            emit processLaunchError(message);
             afterRun(); // finished() won't run
             break;
 
@@ -251,10 +254,10 @@ void ProcessLauncher::onProcessFinished(int exitcode, QProcess::ExitStatus exits
     afterRun();
 }
 
-void ProcessLauncher::beforeRun(const QString& game_path)
+void ProcessLauncher::beforeRun(const QString& game_path, std::function<void()>&& then)
 {
     TerminalKbd::enable();
-    ScriptRunner::run(ScriptEvent::PROCESS_STARTED, { game_path });
+    runScripts(ScriptEvent::PROCESS_STARTED, { game_path }, std::move(then));
 }
 
 void ProcessLauncher::afterRun()
@@ -263,6 +266,44 @@ void ProcessLauncher::afterRun()
     m_process->deleteLater();
     m_process = nullptr;
 
-    ScriptRunner::run(ScriptEvent::PROCESS_FINISHED);
-    TerminalKbd::disable();
+    runScripts(ScriptEvent::PROCESS_FINISHED, {}, [this]{
+        TerminalKbd::disable();
+
+        m_process_done = true;
+        finishIfDone();
+    });
+}
+
+void ProcessLauncher::runScripts(ScriptEvent event, const QStringList& args, std::function<void()>&& then)
+{
+    // the scripts are waited for on the script thread, not on the event loop
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [watcher, then]{
+        watcher->deleteLater();
+        then();
+    });
+    watcher->setFuture(ScriptRunner::runAsync(event, args));
+}
+
+void ProcessLauncher::finishIfDone()
+{
+    // a failed launch is not a finished game
+    if (m_state != State::RUNNING || !m_process_done || !m_teardown_done)
+        return;
+
+    m_state = State::IDLE;
+    emit processFinished();
+}
+
+void ProcessLauncher::printLaunchTimes() const
+{
+    // both parallel parts are done
+    if (m_started_time < 0 || m_teardown_time < 0)
+        return;
+
+    qInfo().noquote() << tr_log("Launch times: `game-start` scripts %1ms, process started at %2ms, "
+                                "frontend released at %3ms")
+        .arg(QString::number(m_scripts_time),
+             QString::number(m_started_time),
+             QString::number(m_teardown_time));
 }
\ No newline at end of file
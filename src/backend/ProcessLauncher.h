@@ -17,8 +17,12 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QProcess>
+#include <functional>
+
+enum class ScriptEvent : unsigned char;
 
 namespace model { class GameFile; }
 
@@ -32,6 +36,10 @@ QString abs_workdir(const QString& workdir, const QString& base_dir, const QStri
 /// Launches and manages external processes
 ///
 /// Launches external processes and detects their success or failure.
+/// The steps of a launch don't block the event loop: the frontend can be
+/// released while the `game-start` scripts run and the process starts, and
+/// the end of the game is reported once both the game and the release of
+/// the frontend have finished.
 class ProcessLauncher : public QObject {
     Q_OBJECT
 
@@ -39,7 +47,9 @@ public:
     explicit ProcessLauncher(QObject* parent = nullptr);
 
 signals:
+    void processLaunching();
     void processLaunchOk();
+    void processLaunchAborted();
     void processLaunchError(QString);
     void processRuntimeError(QString);
     void processFinished();
@@ -56,8 +66,25 @@ private slots:
 private:
     QProcess* m_process;
 
+    enum class State : unsigned char {
+        IDLE,
+        LAUNCHING,
+        RUNNING,
+    } m_state;
+    bool m_process_done;
+    bool m_teardown_done;
+
+    // launch timings, in ms since the request
+    QElapsedTimer m_launch_timer;
+    qint64 m_scripts_time;
+    qint64 m_started_time;
+    qint64 m_teardown_time;
+
     void runProcess(const QString&, const QStringList&, const QString&);
 
-    void beforeRun(const QString&);
+    void beforeRun(const QString&, std::function<void()>&& then);
     void afterRun();
+    void runScripts(ScriptEvent, const QStringList&, std::function<void()>&& then);
+    void finishIfDone();
+    void printLaunchTimes() const;
 };
@@ -17,31 +17,107 @@
 
 #include "ScriptRunner.h"
 
+#include "AppSettings.h"
 #include "LocaleUtils.h"
 #include "Paths.h"
 #include "utils/HashMap.h"
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QMutex>
 #include <QProcess>
 #include <QString>
 #include <QStringBuilder>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 
 namespace {
-std::vector<QString> find_scripts_in(const QString& dirname)
+enum class ScriptMode : unsigned char {
+    SEQUENTIAL,
+    PARALLEL,
+    DETACHED,
+};
+
+struct Script {
+    QString path;
+    ScriptMode mode;
+};
+
+struct ScanResult {
+    std::vector<Script> scripts;
+    QStringList dirs;
+};
+
+
+const QString& script_dirname(ScriptEvent event)
+{
+    static const HashMap<ScriptEvent, QString, EnumHash> SCRIPT_DIRS {
+        { ScriptEvent::QUIT, QStringLiteral("quit") },
+        { ScriptEvent::REBOOT, QStringLiteral("reboot") },
+        { ScriptEvent::SHUTDOWN, QStringLiteral("shutdown") },
+        { ScriptEvent::CONFIG_CHANGED, QStringLiteral("config-changed") },
+        { ScriptEvent::SETTINGS_CHANGED, QStringLiteral("settings-changed") },
+        { ScriptEvent::CONTROLS_CHANGED, QStringLiteral("controls-changed") },
+        { ScriptEvent::PROCESS_STARTED, QStringLiteral("game-start") },
+        { ScriptEvent::PROCESS_FINISHED, QStringLiteral("game-end") },
+    };
+    Q_ASSERT(SCRIPT_DIRS.count(event));
+
+    return SCRIPT_DIRS.at(event);
+}
+
+ScriptMode mode_of(const QString& path)
+{
+    // the markers can be any part of the file name after the first dot
+    const QStringList name_parts = QFileInfo(path).fileName().split(QLatin1Char('.'));
+    for (int i = 1; i < name_parts.size(); i++) {
+        if (name_parts.at(i) == QLatin1String("detached"))
+            return ScriptMode::DETACHED;
+        if (name_parts.at(i) == QLatin1String("parallel"))
+            return ScriptMode::PARALLEL;
+    }
+    return ScriptMode::SEQUENTIAL;
+}
+
+ScanResult find_scripts_in(const QString& dirname)
 {
     constexpr auto filters = QDir::Files | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot;
+    constexpr auto dir_filters = QDir::Dirs | QDir::NoDotAndDotDot;
     constexpr auto flags = QDirIterator::Subdirectories | QDirIterator::FollowSymlinks;
 
     Q_ASSERT(!dirname.isEmpty());
 
-    std::vector<QString> all_scripts;
+    ScanResult result;
 
     const QStringList configdirs = paths::configDirs();
     for (const QString& configdir : configdirs) {
-        const QString scriptdir = configdir % QStringLiteral("/scripts/") % dirname;
+        const QString scriptroot = configdir % QStringLiteral("/scripts");
+        const QString scriptdir = scriptroot % QLatin1Char('/') % dirname;
+
+        // if the directory doesn't exist, its creation is watched instead
+        if (QFileInfo(scriptdir).isDir()) {
+            result.dirs << scriptdir;
+            QDirIterator subdir_it(scriptdir, dir_filters, flags);
+            while (subdir_it.hasNext())
+                result.dirs << subdir_it.next();
+        }
+        else if (QFileInfo(scriptroot).isDir()) {
+            result.dirs << scriptroot;
+            continue;
+        }
+        else {
+            if (QFileInfo(configdir).isDir())
+                result.dirs << configdir;
+            continue;
+        }
 
         std::vector<QString> local_scripts;
         QDirIterator scripdir_it(scriptdir, filters, flags);
@@ -49,57 +125,234 @@ std::vector<QString> find_scripts_in(const QString& dirname)
             local_scripts.emplace_back(scripdir_it.next());
 
         std::sort(local_scripts.begin(), local_scripts.end());
-        all_scripts.insert(all_scripts.end(),
-                           std::make_move_iterator(local_scripts.begin()),
-                           std::make_move_iterator(local_scripts.end()));
+        for (QString& path : local_scripts) {
+            const ScriptMode mode = mode_of(path);
+            result.scripts.push_back({ std::move(path), mode });
+        }
     }
 
-    return all_scripts;
+    return result;
 }
 
-void execute_all(const std::vector<QString>& paths, const QStringList& args)
+
+class ScriptCache {
+public:
+    ScriptCache()
+        : m_watcher(nullptr)
+        , m_generation(0)
+    {}
+
+    void watch();
+    std::vector<Script> scripts_for(ScriptEvent);
+
+private:
+    QMutex m_guard;
+    QFileSystemWatcher* m_watcher;
+    HashMap<ScriptEvent, std::vector<Script>, EnumHash> m_entries;
+    unsigned m_generation;
+
+    void invalidate();
+    void on_dir_changed(const QString&);
+};
+
+void ScriptCache::watch()
 {
-    Q_ASSERT(!paths.empty());
+    const QMutexLocker lock(&m_guard);
+    if (m_watcher)
+        return;
 
-    const int num_field_width = QString::number(paths.size()).length();
+    m_watcher = new QFileSystemWatcher(QCoreApplication::instance());
+    QObject::connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+                     [this](const QString& path){ on_dir_changed(path); });
+}
 
-    for (size_t i = 0; i < paths.size(); i++) {
-        qInfo().noquote() << tr_log("[%1/%2] Running `%3`")
-            .arg(i + 1, num_field_width)
-            .arg(paths.size())
-            .arg(paths[i]);
-        QProcess::execute(paths[i], args);
+void ScriptCache::on_dir_changed(const QString& path)
+{
+    // A config directory is only watched until its `scripts` directory
+    // appears; the other changes there, like saving the settings, are ignored
+    if (paths::configDirs().contains(path)) {
+        if (!QFileInfo(path + QStringLiteral("/scripts")).isDir())
+            return;
+
+        m_watcher->removePath(path);
     }
+
+    invalidate();
 }
-} // namespace
 
+void ScriptCache::invalidate()
+{
+    const QMutexLocker lock(&m_guard);
+    m_entries.clear();
+    m_generation++;
+}
 
-void ScriptRunner::run(ScriptEvent event)
+std::vector<Script> ScriptCache::scripts_for(ScriptEvent event)
 {
-    run(event, {});
+    const QString& dirname = script_dirname(event);
+
+    unsigned generation = 0;
+    {
+        const QMutexLocker lock(&m_guard);
+        if (!m_watcher)
+            return find_scripts_in(dirname).scripts;
+
+        const auto it = m_entries.find(event);
+        if (it != m_entries.cend())
+            return it->second;
+
+        generation = m_generation;
+    }
+
+    ScanResult result = find_scripts_in(dirname);
+
+    const QMutexLocker lock(&m_guard);
+    // a change during the scan may have been missed
+    if (generation != m_generation)
+        return std::move(result.scripts);
+
+    m_entries.emplace(event, result.scripts);
+
+    QFileSystemWatcher* const watcher = m_watcher;
+    QStringList dirs = std::move(result.dirs);
+    QMetaObject::invokeMethod(watcher, [watcher, dirs]{
+        QStringList new_dirs;
+        const QStringList watched_dirs = watcher->directories();
+        for (const QString& dir : dirs) {
+            if (!watched_dirs.contains(dir) && !new_dirs.contains(dir))
+                new_dirs << dir;
+        }
+        if (!new_dirs.isEmpty())
+            watcher->addPaths(new_dirs);
+    }, Qt::QueuedConnection);
+
+    return std::move(result.scripts);
 }
 
-void ScriptRunner::run(ScriptEvent event, const QStringList& args)
+ScriptCache& script_cache()
 {
-    static const HashMap<ScriptEvent, QString, EnumHash> SCRIPT_DIRS {
-        { ScriptEvent::QUIT, QStringLiteral("quit") },
-        { ScriptEvent::REBOOT, QStringLiteral("reboot") },
-        { ScriptEvent::SHUTDOWN, QStringLiteral("shutdown") },
-        { ScriptEvent::CONFIG_CHANGED, QStringLiteral("config-changed") },
-        { ScriptEvent::SETTINGS_CHANGED, QStringLiteral("settings-changed") },
-        { ScriptEvent::CONTROLS_CHANGED, QStringLiteral("controls-changed") },
-        { ScriptEvent::PROCESS_STARTED, QStringLiteral("game-start") },
-        { ScriptEvent::PROCESS_FINISHED, QStringLiteral("game-end") },
+    static ScriptCache cache;
+    return cache;
+}
+
+
+QThreadPool& script_pool()
+{
+    // one thread keeps the events in order
+    static QThreadPool* const pool = []{
+        auto pool = new QThreadPool();
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+    return *pool;
+}
+
+void wait_for(QProcess& process, int timeout_ms)
+{
+    if (process.waitForFinished(timeout_ms))
+        return;
+
+    if (process.state() == QProcess::NotRunning) {
+        qWarning().noquote() << tr_log("`%1` could not be started: %2")
+            .arg(process.program(), process.errorString());
+        return;
+    }
+
+    qWarning().noquote() << tr_log("`%1` did not finish in %2 ms, stopping it")
+        .arg(process.program(), QString::number(timeout_ms));
+    process.kill();
+    process.waitForFinished();
+}
+
+void execute_all(const std::vector<Script>& scripts, const QStringList& args)
+{
+    Q_ASSERT(!scripts.empty());
+
+    const int timeout_ms = AppSettings::general.script_timeout_ms > 0
+        ? AppSettings::general.script_timeout_ms
+        : -1;
+    const int num_field_width = QString::number(scripts.size()).length();
+
+    const auto log_running = [&](size_t i){
+        qInfo().noquote() << tr_log("[%1/%2] Running `%3`")
+            .arg(i + 1, num_field_width)
+            .arg(scripts.size())
+            .arg(scripts[i].path);
+    };
+    const auto start = [&args](QProcess& process, const QString& path){
+        process.setProcessChannelMode(QProcess::ForwardedChannels);
+        process.start(path, args);
     };
-    Q_ASSERT(SCRIPT_DIRS.count(event));
 
+    // the scripts that don't need to wait for the others go first
+    QElapsedTimer parallel_timer;
+    parallel_timer.start();
+    std::vector<std::unique_ptr<QProcess>> parallel_procs;
+    for (size_t i = 0; i < scripts.size(); i++) {
+        switch (scripts[i].mode) {
+            case ScriptMode::DETACHED:
+                log_running(i);
+                if (!QProcess::startDetached(scripts[i].path, args))
+                    qWarning().noquote() << tr_log("`%1` could not be started").arg(scripts[i].path);
+                break;
+            case ScriptMode::PARALLEL:
+                log_running(i);
+                parallel_procs.emplace_back(new QProcess());
+                start(*parallel_procs.back(), scripts[i].path);
+                break;
+            case ScriptMode::SEQUENTIAL:
+                break;
+        }
+    }
 
-    const QString& dirname = SCRIPT_DIRS.at(event);
-    const std::vector<QString> scripts = find_scripts_in(dirname);
+    for (size_t i = 0; i < scripts.size(); i++) {
+        if (scripts[i].mode != ScriptMode::SEQUENTIAL)
+            continue;
 
+        log_running(i);
+        QProcess process;
+        start(process, scripts[i].path);
+        wait_for(process, timeout_ms);
+    }
+
+    for (const std::unique_ptr<QProcess>& process : parallel_procs) {
+        const int remaining_ms = timeout_ms < 0
+            ? -1
+            : static_cast<int>(std::max<qint64>(0, timeout_ms - parallel_timer.elapsed()));
+        wait_for(*process, remaining_ms);
+    }
+}
+
+void run_scripts(ScriptEvent event, const QStringList& args)
+{
+    const std::vector<Script> scripts = script_cache().scripts_for(event);
     if (scripts.empty())
         return;
 
-    qInfo().noquote() << tr_log("Running `%1` scripts...").arg(dirname);
+    qInfo().noquote() << tr_log("Running `%1` scripts...").arg(script_dirname(event));
     execute_all(scripts, args);
 }
+} // namespace
+
+
+void ScriptRunner::run(ScriptEvent event)
+{
+    run(event, {});
+}
+
+void ScriptRunner::run(ScriptEvent event, const QStringList& args)
+{
+    // the earlier events go first
+    script_pool().waitForDone();
+    run_scripts(event, args);
+}
+
+QFuture<void> ScriptRunner::runAsync(ScriptEvent event, const QStringList& args)
+{
+    return QtConcurrent::run(&script_pool(), [event, args]{ run_scripts(event, args); });
+}
+
+void ScriptRunner::watchScriptDirs()
+{
+    script_cache().watch();
+}
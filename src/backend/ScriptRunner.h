@@ -17,7 +17,8 @@
 
 #pragma once
 
-class QStringList;
+#include <QFuture>
+#include <QStringList>
 
 
 enum class ScriptEvent : unsigned char {
@@ -33,8 +34,23 @@ enum class ScriptEvent : unsigned char {
 
 
 /// A utility class for finding and running external scripts
+///
+/// The scripts of an event run in alphabetical order, one after the other.
+/// Scripts with a `.parallel` part in their file name (eg. `10-foo.parallel.sh`)
+/// are started together before the rest, and the `.detached` ones are started
+/// without waiting for them. Scripts running longer than the configured
+/// timeout are stopped.
 class ScriptRunner {
 public:
+    /// Runs the scripts of the event and waits for them, after the ones
+    /// started with `runAsync`
     static void run(ScriptEvent);
     static void run(ScriptEvent, const QStringList&);
+    /// Runs the scripts on a worker thread; the events are handled in the
+    /// order they were requested
+    static QFuture<void> runAsync(ScriptEvent, const QStringList& = {});
+
+    /// Keeps the found scripts in memory, and updates them when the script
+    /// directories change; call on the main thread
+    static void watchScriptDirs();
 };
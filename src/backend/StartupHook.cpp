@@ -0,0 +1,94 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "StartupHook.h"
+
+#include "LocaleUtils.h"
+
+#include <QDebug>
+
+
+StartupHook::StartupHook(QString program, QStringList args, QObject* parent)
+    : QObject(parent)
+    , m_program(std::move(program))
+    , m_args(std::move(args))
+    , m_running(false)
+{
+    // the output is not used, there's no need to buffer it
+    m_process.setStandardOutputFile(QProcess::nullDevice());
+    m_process.setStandardErrorFile(QProcess::nullDevice());
+
+    m_timeout_timer.setSingleShot(true);
+
+    connect(&m_process, &QProcess::errorOccurred, this, &StartupHook::onProcessError);
+    connect(&m_process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &StartupHook::onProcessFinished);
+    connect(&m_timeout_timer, &QTimer::timeout, this, &StartupHook::onTimeout);
+}
+
+void StartupHook::start(int timeout_ms)
+{
+    if (m_running || timeout_ms <= 0)
+        return;
+
+    m_running = true;
+    emit started();
+
+    m_timeout_timer.start(timeout_ms);
+    m_process.start(m_program, m_args, QIODevice::ReadOnly);
+}
+
+void StartupHook::onProcessError(QProcess::ProcessError error)
+{
+    // the other errors are followed by `finished`, or handled by the timer
+    if (error != QProcess::FailedToStart)
+        return;
+
+    qInfo().noquote() << tr_log("Startup hook: could not run `%1`, ignored").arg(m_program);
+    finish(false);
+}
+
+void StartupHook::onProcessFinished(int exitcode, QProcess::ExitStatus exitstatus)
+{
+    if (!m_running)
+        return;
+
+    const bool success = exitstatus == QProcess::NormalExit && exitcode == 0;
+    if (!success) {
+        qWarning().noquote() << tr_log("Startup hook: `%1` has finished with an error (code %2)")
+            .arg(m_program, QString::number(exitcode));
+    }
+    finish(success);
+}
+
+void StartupHook::onTimeout()
+{
+    qWarning().noquote() << tr_log("Startup hook: `%1` did not finish in %2ms, stopped")
+        .arg(m_program, QString::number(m_timeout_timer.interval()));
+
+    finish(false);
+    m_process.kill();
+}
+
+void StartupHook::finish(bool success)
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_timeout_timer.stop();
+    emit finished(success);
+}
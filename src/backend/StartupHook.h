@@ -0,0 +1,55 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+
+
+/// Runs an external program during startup, in parallel with everything else
+///
+/// The program is optional: if it's missing, fails or does not finish in
+/// time, it is only reported, and never delays the rest of the startup.
+class StartupHook : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StartupHook(QString program, QStringList args, QObject* parent = nullptr);
+
+    /// Starts the program; a non-positive timeout disables the hook
+    void start(int timeout_ms);
+
+signals:
+    void started();
+    void finished(bool success);
+
+private slots:
+    void onProcessError(QProcess::ProcessError);
+    void onProcessFinished(int, QProcess::ExitStatus);
+    void onTimeout();
+
+private:
+    const QString m_program;
+    const QStringList m_args;
+    QProcess m_process;
+    QTimer m_timeout_timer;
+    bool m_running;
+
+    void finish(bool success);
+};
@@ -18,6 +18,7 @@ SOURCES += \
     PreInit.cpp \
     ProcessLauncher.cpp \
     ScriptRunner.cpp \
+    StartupHook.cpp \
     Paths.cpp \
     AppSettings.cpp \
     Log.cpp \
@@ -33,6 +34,7 @@ HEADERS += \
     PreInit.h \
     ProcessLauncher.h \
     ScriptRunner.h \
+    StartupHook.h \
     LocaleUtils.h \
     Paths.h \
     AppSettings.h \
@@ -17,21 +17,30 @@
 
 #include "BlurhashProvider.h"
 
-#include <QHash>
+#include "PooledImageResponse.h"
+
+#include <QMutexLocker>
 
 #include <array>
 #include <cmath>
 
 
 namespace {
-constexpr std::array<QChar, 83> BASE83 {
+constexpr char BASE83[] {
     '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
     'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
     'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
     'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '#', '$', '%', '*', '+', ',',
     '-', '.', ':', ';', '=', '?', '@', '[', ']', '^', '_', '{', '|', '}', '~',
 };
+constexpr int BASE83_LEN = sizeof(BASE83);
 constexpr int BLURHASH_MIN_LEN = 6;
+// resolution of the linear -> sRGB lookup table
+constexpr int LINEAR_LUT_SIZE = 4096;
+// total size of the decoded images kept around
+constexpr int CACHE_MAX_BYTES = 4 * 1024 * 1024;
+// placeholders are cheap, there's no need to occupy every core
+constexpr int MAX_DECODER_THREADS = 2;
 
 
 struct FpColor {
@@ -43,20 +52,20 @@ struct FpColor {
 
 unsigned decode_base83(QStringView str)
 {
-    static const QHash<QChar, unsigned int> BASE83_MAP = [](){
-        QHash<QChar, unsigned int> out;
-        out.reserve(BASE83.size());
-        for (size_t i = 0; i < BASE83.size(); i++)
-            out.insert(BASE83[i], i);
+    static const std::array<int8_t, 128> BASE83_MAP = [](){
+        std::array<int8_t, 128> out;
+        out.fill(-1);
+        for (int i = 0; i < BASE83_LEN; i++)
+            out[static_cast<unsigned char>(BASE83[i])] = static_cast<int8_t>(i);
         return out;
     }();
 
     unsigned int result = 0;
     for (const QChar ch : str) {
-        const auto it = BASE83_MAP.find(ch);
-        if (it != BASE83_MAP.cend()) {
-            result *= BASE83.size();
-            result += *it;
+        const ushort code = ch.unicode();
+        if (code < BASE83_MAP.size() && BASE83_MAP[code] >= 0) {
+            result *= BASE83_LEN;
+            result += BASE83_MAP[code];
         }
     }
     return result;
@@ -78,9 +87,35 @@ uint8_t linear_to_srgb(float linear_val)
     // NOTE: See "sRGB forward transformation"
     const float u = std::max(0.f, std::min(linear_val, 1.f));
     const float g = u <= 0.0031308f
-        ? u * 12.92
-        : 1.055 * std::pow(u, 1.f / 2.4f) - 0.055f;
-    return std::round(g * 255.f + 0.5f);
+        ? u * 12.92f
+        : 1.055f * std::pow(u, 1.f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::max(0.f, std::min(g * 255.f + 0.5f, 255.f)));
+}
+
+
+float lookup_srgb_to_linear(uint8_t srgb_val)
+{
+    static const std::array<float, 256> TABLE = [](){
+        std::array<float, 256> out;
+        for (size_t i = 0; i < out.size(); i++)
+            out[i] = srgb_to_linear(static_cast<uint8_t>(i));
+        return out;
+    }();
+    return TABLE[srgb_val];
+}
+
+
+// The pow() of the forward transformation is the most expensive part of the
+// decoding, so the output goes through a table instead
+const std::array<uint8_t, LINEAR_LUT_SIZE>& linear_to_srgb_table()
+{
+    static const std::array<uint8_t, LINEAR_LUT_SIZE> TABLE = [](){
+        std::array<uint8_t, LINEAR_LUT_SIZE> out;
+        for (int i = 0; i < LINEAR_LUT_SIZE; i++)
+            out[i] = linear_to_srgb(i / static_cast<float>(LINEAR_LUT_SIZE - 1));
+        return out;
+    }();
+    return TABLE;
 }
 
 
@@ -93,11 +128,11 @@ float unquant_ac_component(float quant, float max_ac)
 
 FpColor decode_dc(unsigned raw_val)
 {
-    const float b = srgb_to_linear(raw_val & 0xFF);
+    const float b = lookup_srgb_to_linear(raw_val & 0xFF);
     raw_val >>= 8;
-    const float g = srgb_to_linear(raw_val & 0xFF);
+    const float g = lookup_srgb_to_linear(raw_val & 0xFF);
     raw_val >>= 8;
-    const float r = srgb_to_linear(raw_val & 0xFF);
+    const float r = lookup_srgb_to_linear(raw_val & 0xFF);
     return { r, g, b };
 }
 
@@ -115,31 +150,21 @@ FpColor decode_ac(unsigned raw_val, float max_ac)
 }
 
 
-std::vector<float> create_cos_table(unsigned components, unsigned image_dim)
+// Returns the basis values of each component, one row of `image_dim` per component
+std::vector<float> create_cos_table(unsigned components, int image_dim)
 {
     std::vector<float> out(components * image_dim);
-    for (size_t i = 0; i < out.size(); i++)
-        out[i] = std::cos(M_PI * i / image_dim);
+    for (unsigned c = 0; c < components; c++) {
+        float* const row = out.data() + c * image_dim;
+        for (int i = 0; i < image_dim; i++)
+            row[i] = std::cos(M_PI * c * i / image_dim);
+    }
     return out;
 }
-} // namespace
 
 
-BlurhashProvider::BlurhashProvider()
-    : QQuickImageProvider(QQuickImageProvider::Image)
-{}
-
-
-QImage BlurhashProvider::requestImage(const QString& hash_url, QSize* out_size, const QSize& requested_size)
+QImage decode_blurhash(const QString& hash, const QSize& img_size, const std::atomic_bool& canceled)
 {
-    const QString hash = QUrl::fromPercentEncoding(hash_url.toLatin1());
-    if (hash.length() < BLURHASH_MIN_LEN)
-        return {};
-
-    const QSize img_size = requested_size.isEmpty()
-        ? QSize(24, 24)
-        : requested_size;
-
     const unsigned components_raw = decode_base83(hash.leftRef(1));
     const unsigned components_x = (components_raw % 9) + 1;
     const unsigned components_y = (components_raw / 9) + 1;
@@ -166,36 +191,124 @@ QImage BlurhashProvider::requestImage(const QString& hash_url, QSize* out_size,
         return out;
     }();
 
-    const std::vector<float> cos_x_table = create_cos_table(components_x, img_size.width());
-    const std::vector<float> cos_y_table = create_cos_table(components_y, img_size.height());
+    const int width = img_size.width();
+    const int height = img_size.height();
+    const size_t line_len = static_cast<size_t>(width) * 3;
+
+    const std::vector<float> cos_x_table = create_cos_table(components_x, width);
+    const std::vector<float> cos_y_table = create_cos_table(components_y, height);
+
+    // The basis is separable, so instead of summing every component for
+    // every pixel, first the horizontal components of each component row
+    // are summed for every column, then these rows are mixed for every line.
+    // The lines are stored as plain RGB float arrays, so the inner loops
+    // can be vectorized by the compiler.
+    std::vector<float> comp_rows(components_y * line_len, 0.f);
+    for (unsigned cy = 0; cy < components_y; cy++) {
+        float* const row = comp_rows.data() + cy * line_len;
+
+        for (unsigned cx = 0; cx < components_x; cx++) {
+            const FpColor color = colors[cy * components_x + cx];
+            const float* const cos_x = cos_x_table.data() + cx * width;
+
+            for (int img_x = 0; img_x < width; img_x++) {
+                row[img_x * 3 + 0] += color.r * cos_x[img_x];
+                row[img_x * 3 + 1] += color.g * cos_x[img_x];
+                row[img_x * 3 + 2] += color.b * cos_x[img_x];
+            }
+        }
+    }
+
+    const auto& srgb_table = linear_to_srgb_table();
+    constexpr float LUT_SCALE = LINEAR_LUT_SIZE - 1;
 
     QImage out_img(img_size, QImage::Format_RGB888);
-    uchar* const out_img_data = out_img.bits();
-
-    for (int img_y = 0; img_y < img_size.height(); img_y++) {
-        for (int img_x = 0; img_x < img_size.width(); img_x++) {
-            FpColor out_color { 0, 0, 0 };
-
-            for (unsigned cy = 0; cy < components_y; cy++) {
-                for (unsigned cx = 0; cx < components_x; cx++) {
-                    const float basis = cos_x_table[img_x * cx] * cos_y_table[img_y * cy];
-                    const size_t color_idx = cy * components_x + cx;
-                    const FpColor color = colors[color_idx];
-
-                    out_color.r += color.r * basis;
-                    out_color.g += color.g * basis;
-                    out_color.b += color.b * basis;
-                }
-            }
+    std::vector<float> line(line_len);
+
+    for (int img_y = 0; img_y < height; img_y++) {
+        if (canceled)
+            return {};
+
+        std::fill(line.begin(), line.end(), 0.f);
 
-            const size_t pixeldata_idx = (img_y * img_size.width() + img_x) * 3;
-            out_img_data[pixeldata_idx + 0] = linear_to_srgb(out_color.r);
-            out_img_data[pixeldata_idx + 1] = linear_to_srgb(out_color.g);
-            out_img_data[pixeldata_idx + 2] = linear_to_srgb(out_color.b);
+        for (unsigned cy = 0; cy < components_y; cy++) {
+            const float basis = cos_y_table[cy * height + img_y];
+            const float* const row = comp_rows.data() + cy * line_len;
+
+            for (size_t i = 0; i < line_len; i++)
+                line[i] += basis * row[i];
+        }
+
+        uchar* const out_line = out_img.scanLine(img_y);
+        for (size_t i = 0; i < line_len; i++) {
+            const float u = std::max(0.f, std::min(line[i], 1.f));
+            out_line[i] = srgb_table[static_cast<int>(u * LUT_SCALE + 0.5f)];
         }
     }
 
-    if (out_size)
-        *out_size = img_size;
     return out_img;
 }
+} // namespace
+
+
+BlurhashProvider::BlurhashProvider()
+    : QQuickAsyncImageProvider()
+    , m_cache(CACHE_MAX_BYTES)
+{
+    m_pool.setMaxThreadCount(MAX_DECODER_THREADS);
+}
+
+
+BlurhashProvider::~BlurhashProvider()
+{
+    m_pool.waitForDone();
+}
+
+
+QQuickImageResponse* BlurhashProvider::requestImageResponse(const QString& hash_url, const QSize& requested_size)
+{
+    return PooledImageResponse::start(m_pool, [this, hash_url, requested_size](const std::atomic_bool& canceled){
+        return decode(hash_url, requested_size, canceled);
+    });
+}
+
+
+QImage BlurhashProvider::decode(const QString& hash_url, const QSize& requested_size, const std::atomic_bool& canceled)
+{
+    const QString hash = QUrl::fromPercentEncoding(hash_url.toLatin1());
+    if (hash.length() < BLURHASH_MIN_LEN)
+        return {};
+
+    const QSize img_size = requested_size.isEmpty()
+        ? QSize(24, 24)
+        : requested_size;
+
+    const QString cache_key = hash
+        + QLatin1Char('@') + QString::number(img_size.width())
+        + QLatin1Char('x') + QString::number(img_size.height());
+
+    {
+        const QMutexLocker lock(&m_cache_guard);
+        const QImage* const cached = m_cache.object(cache_key);
+        if (cached)
+            return *cached;
+    }
+
+    const QImage out_img = decode_blurhash(hash, img_size, canceled);
+    if (out_img.isNull())
+        return {};
+
+    {
+        const QMutexLocker lock(&m_cache_guard);
+        m_cache.insert(cache_key, new QImage(out_img), static_cast<int>(out_img.sizeInBytes()));
+    }
+
+    return out_img;
+}
+
+
+void BlurhashProvider::clearCache()
+{
+    const QMutexLocker lock(&m_cache_guard);
+    m_cache.clear();
+}
@@ -17,12 +17,35 @@
 
 #pragma once
 
-#include <QQuickImageProvider>
+#include <QCache>
+#include <QMutex>
+#include <QQuickAsyncImageProvider>
+#include <QThreadPool>
+#include <atomic>
 
 
-class BlurhashProvider : public QQuickImageProvider {
+/// Decodes blurhash strings into placeholder images. The decoding runs on a
+/// small pool of its own, so large requests never block the render loop,
+/// and requests that are no longer needed are dropped.
+class BlurhashProvider : public QQuickAsyncImageProvider {
 public:
     BlurhashProvider();
+    ~BlurhashProvider();
 
-    QImage requestImage(const QString&, QSize*, const QSize&) override;
+    QQuickImageResponse* requestImageResponse(const QString&, const QSize&) override;
+
+    /// Decodes the image on the calling thread; returns a null image if the
+    /// hash is invalid or the request got canceled meanwhile
+    QImage decode(const QString& hash_url, const QSize& requested_size, const std::atomic_bool& canceled);
+
+    /// Drops the decoded images kept in memory
+    void clearCache();
+
+private:
+    QThreadPool m_pool;
+
+    // the same placeholders are requested again and again while scrolling,
+    // so the last decoded images are kept, keyed by hash and size
+    QMutex m_cache_guard;
+    QCache<QString, QImage> m_cache;
 };
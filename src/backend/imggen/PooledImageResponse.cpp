@@ -0,0 +1,58 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "PooledImageResponse.h"
+
+#include <QQuickTextureFactory>
+#include <QThreadPool>
+
+
+PooledImageResponse::PooledImageResponse(QThreadPool& pool, Loader loader)
+    : m_pool(pool)
+    , m_loader(std::move(loader))
+    , m_canceled(false)
+{
+    setAutoDelete(false);
+}
+
+PooledImageResponse* PooledImageResponse::start(QThreadPool& pool, Loader loader)
+{
+    auto response = new PooledImageResponse(pool, std::move(loader));
+    pool.start(response);
+    return response;
+}
+
+void PooledImageResponse::run()
+{
+    if (!m_canceled)
+        m_image = m_loader(m_canceled);
+
+    emit finished();
+}
+
+void PooledImageResponse::cancel()
+{
+    m_canceled = true;
+
+    // if the loading didn't start yet, it never will
+    if (m_pool.tryTake(this))
+        emit finished();
+}
+
+QQuickTextureFactory* PooledImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
@@ -0,0 +1,53 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QImage>
+#include <QQuickImageResponse>
+#include <QRunnable>
+#include <atomic>
+#include <functional>
+
+class QThreadPool;
+
+
+/// An image provider response that runs its loader function on a thread pool.
+///
+/// As in the Qt documentation, the response is queued on the pool directly,
+/// but deleted by the engine after `finished()`. When the engine cancels the
+/// request (eg. the delegate got destroyed), it is taken off the queue if it
+/// did not start yet, otherwise the loader is expected to check the flag it
+/// receives and return early.
+class PooledImageResponse : public QQuickImageResponse, public QRunnable {
+public:
+    using Loader = std::function<QImage(const std::atomic_bool& canceled)>;
+
+    /// Creates a new response and queues it on the pool
+    static PooledImageResponse* start(QThreadPool&, Loader);
+
+    void run() override;
+    void cancel() override;
+    QQuickTextureFactory* textureFactory() const override;
+
+private:
+    PooledImageResponse(QThreadPool&, Loader);
+
+    QThreadPool& m_pool;
+    const Loader m_loader;
+    std::atomic_bool m_canceled;
+    QImage m_image;
+};
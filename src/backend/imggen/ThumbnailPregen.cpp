@@ -0,0 +1,132 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThumbnailPregen.h"
+
+#include "LocaleUtils.h"
+#include "Thumbnails.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QUrl>
+#include <QtConcurrent/QtConcurrent>
+
+
+namespace {
+// time spent resting after each image, relative to the time it took
+constexpr qint64 REST_RATIO = 3;
+constexpr qint64 MAX_REST_MS = 1000;
+// the rest is split into steps, so stopping is not delayed too much
+constexpr qint64 REST_STEP_MS = 50;
+} // namespace
+
+
+ThumbnailPregen::ThumbnailPregen(QObject* parent)
+    : QObject(parent)
+    , m_canceled(std::make_shared<std::atomic_bool>(true))
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+ThumbnailPregen::~ThumbnailPregen()
+{
+    // the run in progress still refers to this object
+    stop();
+    m_pool.waitForDone();
+}
+
+void ThumbnailPregen::setImages(QStringList urls)
+{
+    m_image_urls = std::move(urls);
+}
+
+void ThumbnailPregen::start()
+{
+    stop();
+
+    if (m_image_urls.isEmpty())
+        return;
+
+    // every run has its own flag, so a canceled one that is still finishing
+    // its current image does not affect the next
+    m_canceled = std::make_shared<std::atomic_bool>(false);
+
+    const QStringList urls = m_image_urls;
+    const std::shared_ptr<std::atomic_bool> canceled = m_canceled;
+    QtConcurrent::run(&m_pool, [this, urls, canceled]{ run(urls, *canceled); });
+}
+
+void ThumbnailPregen::stop()
+{
+    // does not wait for the current image, the run just ends after it
+    *m_canceled = true;
+}
+
+void ThumbnailPregen::rest(qint64 msecs, const std::atomic_bool& canceled) const
+{
+    while (msecs > 0 && !canceled) {
+        const qint64 step = std::min(msecs, REST_STEP_MS);
+        QThread::msleep(static_cast<unsigned long>(step));
+        msecs -= step;
+    }
+}
+
+void ThumbnailPregen::run(const QStringList& urls, const std::atomic_bool& canceled)
+{
+    QThread* const thread = QThread::currentThread();
+    thread->setPriority(QThread::LowestPriority);
+
+    // the thumbnails of the old sizes and removed artwork are never read
+    // again, so they are cleaned up before the new ones are added
+    const int pruned_cnt = thumbnails::prune_disk_cache();
+    if (pruned_cnt > 0)
+        qInfo().noquote() << tr_log("Removed %1 old thumbnails").arg(pruned_cnt);
+
+    const QVector<QSize> sizes = thumbnails::requested_sizes();
+    if (sizes.isEmpty()) {
+        thread->setPriority(QThread::NormalPriority);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (const QString& url_str : urls) {
+        if (canceled)
+            break;
+
+        const QUrl url(url_str);
+        if (!url.isLocalFile())
+            continue;
+
+        const QString path = url.toLocalFile();
+        for (const QSize& size : sizes) {
+            const qint64 work_start = timer.elapsed();
+            thumbnails::create(path, size, canceled);
+            const qint64 work_time = timer.elapsed() - work_start;
+
+            rest(std::min(work_time * REST_RATIO, MAX_REST_MS), canceled);
+        }
+    }
+
+    thread->setPriority(QThread::NormalPriority);
+
+    if (!canceled) {
+        qInfo().noquote() << tr_log("Thumbnails prepared in %1ms").arg(timer.elapsed());
+        emit finished();
+    }
+}
@@ -0,0 +1,57 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+
+/// Creates the thumbnails of the game artwork in the background, at the sizes
+/// the frontend requested recently (see `thumbnails::requested_sizes()`).
+///
+/// The images are processed one by one on a low priority thread, resting
+/// between them in proportion to the work done, to stay within a small CPU
+/// and disk budget. Thumbnails created earlier are skipped quickly, so an
+/// interrupted run continues where it stopped, even after a restart.
+class ThumbnailPregen : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailPregen(QObject* parent = nullptr);
+    ~ThumbnailPregen();
+
+    /// Sets the URLs of the images to process; only local files are used
+    void setImages(QStringList urls);
+
+    void start();
+    /// Cancels the current run without waiting for it
+    void stop();
+
+signals:
+    void finished();
+
+private:
+    QStringList m_image_urls;
+    std::shared_ptr<std::atomic_bool> m_canceled;
+    QThreadPool m_pool;
+
+    void run(const QStringList& urls, const std::atomic_bool& canceled);
+    void rest(qint64 msecs, const std::atomic_bool& canceled) const;
+};
@@ -0,0 +1,64 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThumbnailProvider.h"
+
+#include "PooledImageResponse.h"
+#include "Thumbnails.h"
+
+#include <QThread>
+#include <QUrl>
+
+
+namespace {
+QString local_path(const QString& image_id)
+{
+    const QUrl url(QUrl::fromPercentEncoding(image_id.toLatin1()));
+    if (url.isLocalFile())
+        return url.toLocalFile();
+    if (url.scheme() == QLatin1String("qrc"))
+        return QLatin1Char(':') + url.path();
+    if (url.isRelative())
+        return url.path();
+
+    return {};
+}
+} // namespace
+
+
+ThumbnailProvider::ThumbnailProvider()
+    : QQuickAsyncImageProvider()
+{
+    // the work is mostly disk access, more threads wouldn't help much
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+ThumbnailProvider::~ThumbnailProvider()
+{
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse* ThumbnailProvider::requestImageResponse(const QString& image_id, const QSize& requested_size)
+{
+    const QString path = local_path(image_id);
+    thumbnails::note_requested_size(requested_size);
+
+    return PooledImageResponse::start(m_pool, [path, requested_size](const std::atomic_bool& canceled){
+        return path.isEmpty()
+            ? QImage()
+            : thumbnails::load(path, requested_size, canceled);
+    });
+}
@@ -0,0 +1,36 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QQuickAsyncImageProvider>
+#include <QThreadPool>
+
+
+/// Serves downscaled copies of local images, for use in grids and lists.
+/// The image id is the percent-encoded URL or path of the source image,
+/// and the thumbnail size comes from the requested size (`sourceSize`).
+/// The thumbnails are created and read on a thread pool of their own.
+class ThumbnailProvider : public QQuickAsyncImageProvider {
+public:
+    ThumbnailProvider();
+    ~ThumbnailProvider();
+
+    QQuickImageResponse* requestImageResponse(const QString&, const QSize&) override;
+
+private:
+    QThreadPool m_pool;
+};
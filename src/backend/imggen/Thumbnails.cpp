@@ -0,0 +1,377 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Thumbnails.h"
+
+#include "Paths.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutex>
+#include <QSaveFile>
+#include <QTextStream>
+
+
+namespace {
+constexpr int JPEG_QUALITY = 90;
+// the size of the grid items may change with the window or theme
+constexpr int MAX_REMEMBERED_SIZES = 4;
+// the decoded thumbnails kept in memory, for prefetching and scrolling back
+constexpr int MEMORY_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+// the cached files are marked as used when read, but at most this often,
+// so the pruning can remove the least recently used ones
+constexpr qint64 TOUCH_INTERVAL_SECS = 24 * 60 * 60;
+
+const QString& cache_dir()
+{
+    static const QString dir = [](){
+        QString path = paths::writableCacheDir() + QLatin1String("/thumbnails");
+        QDir().mkpath(path);
+        return path;
+    }();
+    return dir;
+}
+
+bool has_size(const QSize& requested_size)
+{
+    return requested_size.width() > 0 || requested_size.height() > 0;
+}
+
+QString cache_key(const QFileInfo& finfo, const QSize& size)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(finfo.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(finfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(finfo.size()));
+    hash.addData(QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height()));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+// Formats that can be uploaded as textures without further conversion
+QImage to_texture_format(const QImage& image)
+{
+    const QImage::Format format = image.hasAlphaChannel()
+        ? QImage::Format_ARGB32_Premultiplied
+        : QImage::Format_RGB32;
+    return image.format() == format
+        ? image
+        : image.convertToFormat(format);
+}
+
+QString cache_base_path(const QFileInfo& finfo, const QSize& requested_size)
+{
+    return cache_dir() + QLatin1Char('/') + cache_key(finfo, requested_size);
+}
+
+bool is_cached(const QString& base_path)
+{
+    return QFileInfo::exists(base_path + QLatin1String(".jpg"))
+        || QFileInfo::exists(base_path + QLatin1String(".png"));
+}
+
+void touch_maybe(const QFileInfo& finfo)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    if (finfo.lastModified().secsTo(now) < TOUCH_INTERVAL_SECS)
+        return;
+
+    QFile file(finfo.filePath());
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(now, QFileDevice::FileModificationTime);
+}
+
+QImage read_cached(const QString& base_path)
+{
+    for (const QLatin1String ext : { QLatin1String(".jpg"), QLatin1String(".png") }) {
+        const QFileInfo finfo(base_path + ext);
+        if (finfo.exists()) {
+            QImage image(finfo.filePath());
+            if (!image.isNull()) {
+                touch_maybe(finfo);
+                return image;
+            }
+        }
+    }
+    return {};
+}
+
+void write_cached(const QString& base_path, const QImage& image)
+{
+    // JPEG is faster to decode, but only PNG keeps the transparency of logos
+    const bool lossless = image.hasAlphaChannel();
+    const QString path = base_path + (lossless ? QLatin1String(".png") : QLatin1String(".jpg"));
+
+    // written into a temporary file first, so other threads never see a partial image
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QImageWriter writer(&file, lossless ? QByteArrayLiteral("png") : QByteArrayLiteral("jpg"));
+    if (!lossless)
+        writer.setQuality(JPEG_QUALITY);
+
+    if (writer.write(image))
+        file.commit();
+}
+
+
+// Reads the original image, and stores the downscaled version if there's one
+QImage read_and_store(const QString& image_path, const QSize& requested_size, const QString& cache_path)
+{
+    QImageReader reader(image_path);
+    reader.setAutoTransform(true);
+
+    const QSize orig_size = reader.size();
+    const QSize target_size = has_size(requested_size) && orig_size.isValid()
+        ? thumbnails::scaled_size(orig_size, requested_size)
+        : orig_size;
+    const bool downscaled = target_size != orig_size;
+    if (downscaled)
+        reader.setScaledSize(target_size);
+
+    const QImage image = reader.read();
+    if (!image.isNull() && downscaled)
+        write_cached(cache_path, image);
+
+    return image;
+}
+
+// The images that need no scaling are used as they are, without a cached
+// copy; this only reads the header of the file
+bool needs_no_scaling(const QString& image_path, const QSize& requested_size)
+{
+    const QSize orig_size = QImageReader(image_path).size();
+    return orig_size.isValid() && thumbnails::scaled_size(orig_size, requested_size) == orig_size;
+}
+
+
+QString sizes_file_path()
+{
+    return cache_dir() + QLatin1String("/sizes.txt");
+}
+
+QVector<QSize> read_sizes_file()
+{
+    QVector<QSize> sizes;
+
+    QFile file(sizes_file_path());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return sizes;
+
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line) && sizes.size() < MAX_REMEMBERED_SIZES) {
+        const QStringList parts = line.split(QLatin1Char('x'));
+        if (parts.size() != 2)
+            continue;
+
+        const QSize size(parts.at(0).toInt(), parts.at(1).toInt());
+        if (has_size(size))
+            sizes.append(size);
+    }
+    return sizes;
+}
+
+void write_sizes_file(const QVector<QSize>& sizes)
+{
+    QSaveFile file(sizes_file_path());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    QTextStream stream(&file);
+    for (const QSize& size : sizes)
+        stream << size.width() << 'x' << size.height() << '\n';
+    stream.flush();
+
+    file.commit();
+}
+
+QMutex& memory_guard()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QCache<QString, QImage>& memory_cache()
+{
+    static QCache<QString, QImage> cache(MEMORY_CACHE_MAX_BYTES);
+    return cache;
+}
+
+QImage read_memory(const QString& cache_path)
+{
+    const QMutexLocker lock(&memory_guard());
+    const QImage* const image = memory_cache().object(cache_path);
+    return image ? *image : QImage();
+}
+
+void store_memory(const QString& cache_path, const QImage& image)
+{
+    const QMutexLocker lock(&memory_guard());
+    memory_cache().insert(cache_path, new QImage(image), static_cast<int>(image.sizeInBytes()));
+}
+
+
+QMutex& sizes_guard()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<QSize>& remembered_sizes()
+{
+    static QVector<QSize> sizes = read_sizes_file();
+    return sizes;
+}
+} // namespace
+
+
+namespace thumbnails {
+
+QSize scaled_size(const QSize& orig_size, const QSize& requested_size)
+{
+    const qreal scale_w = requested_size.width() > 0
+        ? requested_size.width() / static_cast<qreal>(orig_size.width())
+        : 0.0;
+    const qreal scale_h = requested_size.height() > 0
+        ? requested_size.height() / static_cast<qreal>(orig_size.height())
+        : 0.0;
+
+    const qreal scale = std::max(scale_w, scale_h);
+    if (scale <= 0.0 || 1.0 <= scale)
+        return orig_size;
+
+    return QSize(
+        std::max(1, qRound(orig_size.width() * scale)),
+        std::max(1, qRound(orig_size.height() * scale)));
+}
+
+QImage load(const QString& image_path, const QSize& requested_size, const std::atomic_bool& canceled)
+{
+    const QFileInfo finfo(image_path);
+    if (!finfo.isFile())
+        return {};
+
+    const QString cache_path = has_size(requested_size)
+        ? cache_base_path(finfo, requested_size)
+        : QString();
+
+    // nothing to scale to
+    if (cache_path.isEmpty()) {
+        const QImage image = canceled
+            ? QImage()
+            : read_and_store(image_path, requested_size, cache_path);
+        return image.isNull()
+            ? image
+            : to_texture_format(image);
+    }
+
+    const QImage in_memory = read_memory(cache_path);
+    if (!in_memory.isNull())
+        return in_memory;
+
+    QImage image = read_cached(cache_path);
+    if (image.isNull()) {
+        if (canceled)
+            return {};
+
+        // the work is already done at this point, so it's saved even if canceled
+        image = read_and_store(image_path, requested_size, cache_path);
+        if (image.isNull())
+            return {};
+    }
+
+    image = to_texture_format(image);
+    store_memory(cache_path, image);
+    return image;
+}
+
+bool create(const QString& image_path, const QSize& requested_size, const std::atomic_bool& canceled)
+{
+    const QFileInfo finfo(image_path);
+    if (!finfo.isFile())
+        return false;
+    if (!has_size(requested_size))
+        return true;
+
+    const QString cache_path = cache_base_path(finfo, requested_size);
+    if (is_cached(cache_path))
+        return true;
+
+    if (canceled)
+        return false;
+
+    // nothing would be stored, so there's no point decoding them
+    if (needs_no_scaling(image_path, requested_size))
+        return true;
+
+    return !read_and_store(image_path, requested_size, cache_path).isNull();
+}
+
+int prune_disk_cache(qint64 max_bytes)
+{
+    // newest first; the files used recently are touched when read
+    const QFileInfoList files = QDir(cache_dir()).entryInfoList(
+        { QStringLiteral("*.jpg"), QStringLiteral("*.png") },
+        QDir::Files, QDir::Time);
+
+    qint64 total_bytes = 0;
+    int removed_cnt = 0;
+    for (const QFileInfo& finfo : files) {
+        total_bytes += finfo.size();
+        if (max_bytes < total_bytes && QFile::remove(finfo.filePath()))
+            removed_cnt++;
+    }
+    return removed_cnt;
+}
+
+void clear_memory()
+{
+    const QMutexLocker lock(&memory_guard());
+    memory_cache().clear();
+}
+
+void note_requested_size(const QSize& size)
+{
+    if (!has_size(size))
+        return;
+
+    const QMutexLocker lock(&sizes_guard());
+    QVector<QSize>& sizes = remembered_sizes();
+    if (sizes.contains(size))
+        return;
+
+    sizes.prepend(size);
+    if (sizes.size() > MAX_REMEMBERED_SIZES)
+        sizes.resize(MAX_REMEMBERED_SIZES);
+
+    write_sizes_file(sizes);
+}
+
+QVector<QSize> requested_sizes()
+{
+    const QMutexLocker lock(&sizes_guard());
+    return remembered_sizes();
+}
+
+} // namespace thumbnails
@@ -0,0 +1,65 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <QVector>
+#include <atomic>
+
+class QString;
+
+
+/// Downscaled copies of local images, stored in the cache directory
+namespace thumbnails {
+
+/// The disk space the thumbnails may take, see `prune_disk_cache`
+constexpr qint64 DISK_CACHE_MAX_BYTES = 256 * 1024 * 1024;
+
+/// The smallest size that covers the requested area, or the original size if
+/// that's not larger; a zero requested dimension means that side is not
+/// constrained, as with `sourceSize`
+QSize scaled_size(const QSize& orig_size, const QSize& requested_size);
+
+/// Returns the image at the path, scaled down to cover the requested size.
+/// Thumbnails are created on the first request and read from the disk
+/// cache afterwards; the cache entries are keyed by the path, the
+/// modification time and file size of the source, and the requested size.
+/// Images not larger than the requested size are returned as they are.
+/// The last loaded thumbnails are also kept in memory, up to a fixed limit.
+QImage load(const QString& image_path, const QSize& requested_size, const std::atomic_bool& canceled);
+
+/// Drops the thumbnails kept in memory
+void clear_memory();
+
+/// Makes sure the thumbnail of the requested size exists on the disk, without
+/// reading it back if it does; returns false if the image couldn't be read
+bool create(const QString& image_path, const QSize& requested_size, const std::atomic_bool& canceled);
+
+/// Removes the least recently used thumbnails from the disk, until the rest
+/// fit in the size limit (eg. the ones of removed games or old sizes).
+/// Returns the number of files removed. It lists the whole cache directory,
+/// so it should not run on the UI thread.
+int prune_disk_cache(qint64 max_bytes = DISK_CACHE_MAX_BYTES);
+
+/// Remembers a size requested by the frontend, so the thumbnails of later
+/// added images can be created in advance. The list is kept between runs.
+void note_requested_size(const QSize&);
+/// The sizes requested recently, the newest one first
+QVector<QSize> requested_sizes();
+
+} // namespace thumbnails
@@ -1,5 +1,13 @@
 HEADERS += \
-    $$PWD/BlurhashProvider.h
+    $$PWD/BlurhashProvider.h \
+    $$PWD/PooledImageResponse.h \
+    $$PWD/ThumbnailPregen.h \
+    $$PWD/ThumbnailProvider.h \
+    $$PWD/Thumbnails.h
 
 SOURCES += \
-    $$PWD/BlurhashProvider.cpp
+    $$PWD/BlurhashProvider.cpp \
+    $$PWD/PooledImageResponse.cpp \
+    $$PWD/ThumbnailPregen.cpp \
+    $$PWD/ThumbnailProvider.cpp \
+    $$PWD/Thumbnails.cpp
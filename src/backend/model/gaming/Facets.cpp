@@ -0,0 +1,206 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Facets.h"
+
+#include "model/gaming/Game.h"
+#include "utils/HashMap.h"
+
+#include <algorithm>
+
+
+namespace {
+bool find_field(const QString& name, model::FacetField& out)
+{
+    static const HashMap<QString, model::FacetField> map {
+        { QStringLiteral("developer"), model::FacetField::DEVELOPER },
+        { QStringLiteral("developers"), model::FacetField::DEVELOPER },
+        { QStringLiteral("developerList"), model::FacetField::DEVELOPER },
+        { QStringLiteral("publisher"), model::FacetField::PUBLISHER },
+        { QStringLiteral("publishers"), model::FacetField::PUBLISHER },
+        { QStringLiteral("publisherList"), model::FacetField::PUBLISHER },
+        { QStringLiteral("genre"), model::FacetField::GENRE },
+        { QStringLiteral("genres"), model::FacetField::GENRE },
+        { QStringLiteral("genreList"), model::FacetField::GENRE },
+        { QStringLiteral("tag"), model::FacetField::TAG },
+        { QStringLiteral("tags"), model::FacetField::TAG },
+        { QStringLiteral("tagList"), model::FacetField::TAG },
+    };
+
+    const auto it = map.find(name);
+    if (it == map.cend())
+        return false;
+
+    out = it->second;
+    return true;
+}
+
+const QStringList& field_values(const model::Game& game, model::FacetField field)
+{
+    switch (field) {
+        case model::FacetField::DEVELOPER: return game.developerListConst();
+        case model::FacetField::PUBLISHER: return game.publisherListConst();
+        case model::FacetField::GENRE: return game.genreListConst();
+        case model::FacetField::TAG: return game.tagListConst();
+    }
+    Q_UNREACHABLE();
+}
+
+std::vector<model::FacetEntry> build_table(const QVector<model::Game*>& games, model::FacetField field)
+{
+    HashMap<QString, std::vector<int>> postings;
+    for (int game_idx = 0; game_idx < games.count(); game_idx++) {
+        for (const QString& value : field_values(*games.at(game_idx), field)) {
+            if (value.isEmpty())
+                continue;
+
+            // games are visited in order, so the lists stay sorted;
+            // only the duplicates of the same game have to be skipped
+            std::vector<int>& list = postings[value];
+            if (list.empty() || list.back() != game_idx)
+                list.push_back(game_idx);
+        }
+    }
+
+    std::vector<model::FacetEntry> table;
+    table.reserve(postings.size());
+    for (auto& entry : postings)
+        table.push_back({ entry.first, std::move(entry.second) });
+
+    std::sort(table.begin(), table.end(),
+        [](const model::FacetEntry& a, const model::FacetEntry& b){ return a.value < b.value; });
+    return table;
+}
+} // namespace
+
+
+namespace model {
+const FacetEntry* FacetIndex::find(FacetField field, const QString& value) const
+{
+    const std::vector<FacetEntry>& entries = table(field);
+    const auto it = std::lower_bound(entries.cbegin(), entries.cend(), value,
+        [](const FacetEntry& entry, const QString& val){ return entry.value < val; });
+
+    if (it == entries.cend() || it->value != value)
+        return nullptr;
+
+    return &*it;
+}
+
+FacetIndex build_facet_index(const QVector<model::Game*>& games)
+{
+    FacetIndex index;
+    index.game_count = games.count();
+    for (size_t i = 0; i < FACET_FIELD_COUNT; i++)
+        index.tables[i] = build_table(games, static_cast<FacetField>(i));
+
+    return index;
+}
+
+
+Facets::Facets(QObject* parent)
+    : QObject(parent)
+{}
+
+void Facets::setIndex(FacetIndex&& index)
+{
+    m_index = std::move(index);
+    refresh_values();
+}
+
+void Facets::clear()
+{
+    setIndex(FacetIndex());
+}
+
+void Facets::refresh_values()
+{
+    for (size_t i = 0; i < FACET_FIELD_COUNT; i++) {
+        const std::vector<FacetEntry>& table = m_index.tables.at(i);
+
+        QStringList list;
+        list.reserve(static_cast<int>(table.size()));
+        for (const FacetEntry& entry : table)
+            list.append(entry.value);
+
+        m_values[i] = std::move(list);
+    }
+
+    emit facetsChanged();
+}
+
+QStringList Facets::values(const QString& field_name) const
+{
+    FacetField field;
+    if (!find_field(field_name, field))
+        return {};
+
+    return m_values.at(static_cast<size_t>(field));
+}
+
+int Facets::count(const QString& field_name, const QString& value) const
+{
+    FacetField field;
+    if (!find_field(field_name, field))
+        return 0;
+
+    const FacetEntry* const entry = m_index.find(field, value);
+    return entry ? static_cast<int>(entry->game_ids.size()) : 0;
+}
+
+QVariantList Facets::games(const QString& field_name, const QString& value) const
+{
+    FacetField field;
+    if (!find_field(field_name, field))
+        return {};
+
+    const FacetEntry* const entry = m_index.find(field, value);
+    if (!entry)
+        return {};
+
+    QVariantList out;
+    out.reserve(static_cast<int>(entry->game_ids.size()));
+    for (const int game_idx : entry->game_ids)
+        out.append(game_idx);
+
+    return out;
+}
+
+QVariantList Facets::gameMask(const QString& field_name, const QStringList& values) const
+{
+    FacetField field;
+    if (!find_field(field_name, field))
+        return {};
+
+    std::vector<bool> mask(static_cast<size_t>(m_index.game_count), false);
+    for (const QString& value : values) {
+        const FacetEntry* const entry = m_index.find(field, value);
+        if (!entry)
+            continue;
+
+        for (const int game_idx : entry->game_ids)
+            mask[static_cast<size_t>(game_idx)] = true;
+    }
+
+    QVariantList out;
+    out.reserve(m_index.game_count);
+    for (const bool val : mask)
+        out.append(val);
+
+    return out;
+}
+} // namespace model
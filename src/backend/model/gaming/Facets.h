@@ -0,0 +1,101 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantList>
+#include <array>
+#include <vector>
+
+namespace model { class Game; }
+
+
+namespace model {
+enum class FacetField : unsigned char {
+    DEVELOPER,
+    PUBLISHER,
+    GENRE,
+    TAG,
+};
+static constexpr size_t FACET_FIELD_COUNT = 4;
+
+
+/// One distinct value of a field, with the sorted indices of the games
+/// (in `api.allGames` order) that have it
+struct FacetEntry {
+    QString value;
+    std::vector<int> game_ids;
+};
+
+/// Value -> posting list tables for every facet field; the entries of each
+/// table are sorted by value, so lookups are binary searches
+struct FacetIndex {
+    std::array<std::vector<FacetEntry>, FACET_FIELD_COUNT> tables;
+    int game_count = 0;
+
+    const std::vector<FacetEntry>& table(FacetField field) const {
+        return tables.at(static_cast<size_t>(field));
+    }
+    const FacetEntry* find(FacetField, const QString&) const;
+};
+
+/// Builds the facet tables; the games are expected to be in their final order
+FacetIndex build_facet_index(const QVector<model::Game*>&);
+
+
+/// Precomputed unique values of the game list fields, for faceted browsing
+class Facets : public QObject {
+    Q_OBJECT
+
+    Q_PROPERTY(QStringList developers READ developers NOTIFY facetsChanged)
+    Q_PROPERTY(QStringList publishers READ publishers NOTIFY facetsChanged)
+    Q_PROPERTY(QStringList genres READ genres NOTIFY facetsChanged)
+    Q_PROPERTY(QStringList tags READ tags NOTIFY facetsChanged)
+
+public:
+    explicit Facets(QObject* parent = nullptr);
+
+    void setIndex(FacetIndex&&);
+    void clear();
+    const FacetIndex& index() const { return m_index; }
+
+    QStringList developers() const { return m_values.at(static_cast<size_t>(FacetField::DEVELOPER)); }
+    QStringList publishers() const { return m_values.at(static_cast<size_t>(FacetField::PUBLISHER)); }
+    QStringList genres() const { return m_values.at(static_cast<size_t>(FacetField::GENRE)); }
+    QStringList tags() const { return m_values.at(static_cast<size_t>(FacetField::TAG)); }
+
+    /// The field names accepted here are `developer`, `publisher`, `genre`
+    /// and `tag`, with the QML list property names (eg. `genreList`) as aliases
+    Q_INVOKABLE QStringList values(const QString& field) const;
+    Q_INVOKABLE int count(const QString& field, const QString& value) const;
+    Q_INVOKABLE QVariantList games(const QString& field, const QString& value) const;
+    /// Returns a list of `api.allGames.count` booleans, marking the games
+    /// having at least one of the values; meant for `ExpressionFilter`s
+    Q_INVOKABLE QVariantList gameMask(const QString& field, const QStringList& values) const;
+
+signals:
+    void facetsChanged();
+
+private:
+    FacetIndex m_index;
+    std::array<QStringList, FACET_FIELD_COUNT> m_values;
+
+    void refresh_values();
+};
+} // namespace model
@@ -82,6 +82,11 @@ Game& Game::setWhitelist(bool new_val)
 }
 
 void Game::onEntryPlayStatsChanged()
+{
+    refresh_playstats();
+}
+
+void Game::refresh_playstats()
 {
     m_data.playstats.play_count = std::accumulate(filesConst().cbegin(), filesConst().cend(), 0,
         [](int sum, const model::GameFile* const gamefile){
@@ -19,11 +19,13 @@
 
 #include "Assets.h"
 #include "GameFile.h"
+#include "utils/CommandTemplate.h"
 #include "utils/MoveOnly.h"
 #include "model/gaming/Collection.h"
 
 #include "QtQmlTricks/QQmlObjectListModel.h"
 #include <QObject>
+#include <memory>
 #include <unordered_set>
 
 namespace model { class Collection; }
@@ -84,6 +86,10 @@ struct GameData {
         QString launch_cmd;
         QString launch_workdir;
         QString relative_basedir; // TODO: check if needed
+
+        // prepared from the fields above when the game list is finalized
+        std::shared_ptr<const utils::CommandTemplate> launch_cmd_template;
+        std::shared_ptr<const utils::CommandTemplate> launch_workdir_template;
     } launch_params;
 };
 
@@ -145,6 +151,8 @@ public:
     GETTER(const QString&, launchCmd, launch_params.launch_cmd)
     GETTER(const QString&, launchWorkdir, launch_params.launch_workdir)
     GETTER(const QString&, launchCmdBasedir, launch_params.relative_basedir)
+    GETTER(const std::shared_ptr<const utils::CommandTemplate>&, launchCmdTemplate, launch_params.launch_cmd_template)
+    GETTER(const std::shared_ptr<const utils::CommandTemplate>&, launchWorkdirTemplate, launch_params.launch_workdir_template)
 #undef GETTER
 
 
@@ -162,6 +170,8 @@ public:
     SETTER(QString, LaunchCmd, launch_params.launch_cmd)
     SETTER(QString, LaunchWorkdir, launch_params.launch_workdir)
     SETTER(QString, LaunchCmdBasedir, launch_params.relative_basedir)
+    SETTER(std::shared_ptr<const utils::CommandTemplate>, LaunchCmdTemplate, launch_params.launch_cmd_template)
+    SETTER(std::shared_ptr<const utils::CommandTemplate>, LaunchWorkdirTemplate, launch_params.launch_workdir_template)
 
     Game& setFavorite(bool val);
     Game& setWhitelist(bool val);
@@ -255,6 +265,9 @@ public:
 
     Q_INVOKABLE void launch();
 
+    /// Recalculates the play stats from the files
+    void refresh_playstats();
+
     void finalize();
 };
 
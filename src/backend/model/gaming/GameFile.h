@@ -78,6 +78,8 @@ public:
     Q_INVOKABLE void launch();
 
     void update_playstats(int playcount, qint64 playtime, QDateTime last_played);
+    /// Same as `update_playstats`, but without emitting `playStatsChanged`
+    void add_playstats(int playcount, qint64 playtime, QDateTime last_played);
 
 signals:
     void launchRequested();
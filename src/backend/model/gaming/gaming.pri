@@ -1,11 +1,13 @@
 HEADERS += \
     $$PWD/Assets.h \
     $$PWD/Collection.h \
+    $$PWD/Facets.h \
     $$PWD/Game.h \
     $$PWD/GameFile.h \
 
 SOURCES += \
     $$PWD/Assets.cpp \
     $$PWD/Collection.cpp \
+    $$PWD/Facets.cpp \
     $$PWD/Game.cpp \
     $$PWD/GameFile.cpp \
\ No newline at end of file
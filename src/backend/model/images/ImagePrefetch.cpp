@@ -0,0 +1,125 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ImagePrefetch.h"
+
+#include "imggen/Thumbnails.h"
+#include "model/gaming/Assets.h"
+#include "model/gaming/Game.h"
+
+#include <QAbstractItemModel>
+#include <QThread>
+#include <QUrl>
+#include <QtConcurrent/QtConcurrent>
+
+
+namespace {
+// more would just push the visible items out of the memory cache
+constexpr int MAX_PREFETCH_ITEMS = 64;
+
+QSize variant_to_size(const QVariant& var)
+{
+    // sizes created in QML with `Qt.size()` are QSizeF
+    return var.userType() == QMetaType::QSizeF
+        ? var.toSizeF().toSize()
+        : var.toSize();
+}
+} // namespace
+
+
+namespace model {
+
+ImagePrefetch::ImagePrefetch(QObject* parent)
+    : QObject(parent)
+    , m_processing(false)
+    , m_canceled(false)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+ImagePrefetch::~ImagePrefetch()
+{
+    m_canceled = true;
+    m_future.waitForFinished();
+}
+
+void ImagePrefetch::prefetch(QObject* model, int index, int direction, int count, const QVariantMap& sizes)
+{
+    const auto item_model = qobject_cast<QAbstractItemModel*>(model);
+    if (!item_model || direction == 0 || count <= 0 || sizes.isEmpty())
+        return;
+
+    const int game_role = item_model->roleNames().key(QByteArrayLiteral("modelData"), -1);
+    if (game_role < 0)
+        return;
+
+    const int step = direction > 0 ? 1 : -1;
+    const int item_cnt = std::min(count, MAX_PREFETCH_ITEMS);
+    const int row_cnt = item_model->rowCount();
+
+    std::vector<Request> requests;
+    for (int k = 1; k <= item_cnt; k++) {
+        const int i = index + step * k;
+        if (i < 0 || row_cnt <= i)
+            break;
+
+        const QVariant game_var = item_model->data(item_model->index(i, 0), game_role);
+        const auto game = qobject_cast<const model::Game*>(game_var.value<QObject*>());
+        if (!game)
+            continue;
+
+        for (auto it = sizes.cbegin(); it != sizes.cend(); ++it) {
+            const QUrl url(game->assets().property(it.key().toLatin1().constData()).toString());
+            const QSize size = variant_to_size(it.value());
+            if (url.isLocalFile() && !size.isEmpty())
+                requests.push_back({ url.toLocalFile(), size });
+        }
+    }
+    if (requests.empty())
+        return;
+
+    QMutexLocker lock(&m_task_guard);
+    m_pending.swap(requests);
+    if (!m_processing) {
+        m_processing = true;
+        start_processing();
+    }
+}
+
+void ImagePrefetch::start_processing()
+{
+    m_future = QtConcurrent::run(&m_pool, [this]{
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+
+        while (!m_canceled) {
+            Request request;
+            {
+                QMutexLocker lock(&m_task_guard);
+                if (m_pending.empty()) {
+                    m_processing = false;
+                    break;
+                }
+                // the nearest items are the first ones
+                request = std::move(m_pending.front());
+                m_pending.erase(m_pending.begin());
+            }
+
+            thumbnails::load(request.path, request.size, m_canceled);
+        }
+    });
+}
+
+} // namespace model
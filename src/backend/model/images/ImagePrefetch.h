@@ -0,0 +1,65 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QFuture>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <atomic>
+#include <vector>
+
+
+namespace model {
+
+/// Loads the artwork of the items coming next into memory, for when the user
+/// holds a direction and the grid moves faster than the images could load.
+///
+/// The images go through the thumbnail cache (see `image://thumbnail`),
+/// whose memory use is capped, so prefetching can't grow without bounds.
+class ImagePrefetch : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ImagePrefetch(QObject* parent = nullptr);
+    ~ImagePrefetch();
+
+    /// Prefetches the artwork of `count` games of a game list model, following
+    /// the item at `index` in the `direction` (+1 or -1). The `sizes` map the
+    /// asset names (eg. `boxFront`) to the size they are shown at, which
+    /// should match the `sourceSize` of the Image. A new call replaces the
+    /// requests not started yet.
+    Q_INVOKABLE void prefetch(QObject* model, int index, int direction, int count, const QVariantMap& sizes);
+
+private:
+    struct Request {
+        QString path;
+        QSize size;
+    };
+    std::vector<Request> m_pending;
+    bool m_processing;
+    QMutex m_task_guard;
+    std::atomic_bool m_canceled;
+    QThreadPool m_pool;
+    QFuture<void> m_future;
+
+    void start_processing();
+};
+
+} // namespace model
@@ -0,0 +1,5 @@
+HEADERS += \
+    $$PWD/ImagePrefetch.h
+
+SOURCES += \
+    $$PWD/ImagePrefetch.cpp
@@ -31,8 +31,8 @@
 namespace {
 void call_gamepad_reconfig_scripts()
 {
-    ScriptRunner::run(ScriptEvent::CONFIG_CHANGED);
-    ScriptRunner::run(ScriptEvent::CONTROLS_CHANGED);
+    ScriptRunner::runAsync(ScriptEvent::CONFIG_CHANGED);
+    ScriptRunner::runAsync(ScriptEvent::CONTROLS_CHANGED);
 }
 
 QQmlObjectListModel<model::Gamepad>::const_iterator
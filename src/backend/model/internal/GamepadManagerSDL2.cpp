@@ -26,18 +26,51 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QGuiApplication>
+#include <QQuickWindow>
 #include <QStringBuilder>
+#include <QThread>
 #include <array>
+#include <functional>
 
 
 namespace {
 constexpr size_t GUID_LEN = 33; // 16x2 + null
 constexpr auto USERCFG_FILE = "/sdl_controllers.txt";
 
+// Since SDL 2.0.16 the input thread can block in SDL_WaitEventTimeout until
+// an event arrives; older versions would poll every millisecond there, so
+// for them the thread polls in its own pace instead, faster while the
+// gamepads are in use
+constexpr uint16_t BLOCKING_WAIT_VERSION = 2016; // 2.0.16
+constexpr int WAIT_TIMEOUT_MS = 1000;
+constexpr unsigned long ACTIVE_POLL_MS = 8;
+constexpr unsigned long IDLE_POLL_MS = 16;
+constexpr unsigned long NO_DEVICE_POLL_MS = 250;
+constexpr qint64 IDLE_AFTER_MS = 3000;
+// stick and trigger movements smaller than this are treated as noise
+constexpr Sint16 AXIS_DEADZONE = 8000;
+
+class InputThread : public QThread {
+public:
+    explicit InputThread(std::function<void()> func)
+        : m_func(std::move(func))
+    {}
+
+protected:
+    void run() override {
+        m_func();
+    }
+
+private:
+    const std::function<void()> m_func;
+};
+
 constexpr uint16_t version(uint16_t major, uint16_t minor, uint16_t micro)
 {
     return major * 1000u + minor * 100u + micro;
 }
+static_assert(version(2, 0, 16) == BLOCKING_WAIT_VERSION, "");
 
 std::unique_ptr<char, void(*)(void*)> freeable_str(char* const str)
 {
@@ -279,11 +312,44 @@ void GamepadManagerSDL2::RecordingState::reset()
 GamepadManagerSDL2::GamepadManagerSDL2(QObject* parent)
     : GamepadManagerBackend(parent)
     , m_sdl_version(linked_sdl_version())
+    , m_measure_latency(false)
+    , m_input_thread(nullptr)
+    , m_stopping(false)
 {
-    connect(&m_poll_timer, &QTimer::timeout, this, &GamepadManagerSDL2::poll);
+    m_clock.start();
 }
 
 void GamepadManagerSDL2::start(const backend::CliArgs& args)
+{
+    Q_ASSERT(!m_input_thread);
+    m_measure_latency = args.measure_input_latency;
+
+    m_input_thread = new InputThread([this, args]{ run_input_thread(args); });
+    m_input_thread->setObjectName(QStringLiteral("gamepad input"));
+    m_input_thread->start(QThread::HighPriority);
+}
+
+GamepadManagerSDL2::~GamepadManagerSDL2()
+{
+    if (!m_input_thread)
+        return;
+
+    {
+        const QMutexLocker lock(&m_guard);
+        m_stopping = true;
+        m_wakeup.wakeOne();
+    }
+    // interrupts SDL_WaitEventTimeout; if SDL isn't running (yet), the
+    // thread notices the flag after the wait times out
+    SDL_Event wakeup_event {};
+    wakeup_event.type = SDL_USEREVENT;
+    SDL_PushEvent(&wakeup_event);
+
+    m_input_thread->wait();
+    delete m_input_thread;
+}
+
+void GamepadManagerSDL2::run_input_thread(const backend::CliArgs& args)
 {
     if (SDL_Init(SDL_INIT_GAMECONTROLLER) != 0) {
         qCritical().noquote() << "Failed to initialize SDL2. Gamepad support may not work.";
@@ -299,13 +365,45 @@ void GamepadManagerSDL2::start(const backend::CliArgs& args)
     for (const QString& dir : paths::configDirs())
         load_user_gamepaddb(dir);
 
-    m_poll_timer.start(16);
-}
+    const bool can_block = BLOCKING_WAIT_VERSION <= m_sdl_version;
+    qint64 last_input_ms = -IDLE_AFTER_MS;
 
-GamepadManagerSDL2::~GamepadManagerSDL2()
-{
-    m_poll_timer.stop();
+    QMutexLocker lock(&m_guard);
+    while (!m_stopping) {
+        int input_cnt = 0;
+        if (can_block) {
+            // the destructor pushes an event to wake this up
+            lock.unlock();
+            SDL_Event event;
+            const bool has_event = SDL_WaitEventTimeout(&event, WAIT_TIMEOUT_MS) == 1;
+            lock.relock();
+
+            if (m_stopping)
+                break;
+            if (has_event)
+                input_cnt += handle_event(event);
+        }
+
+        input_cnt += poll_events();
+        send_batch();
+
+        if (can_block)
+            continue;
+
+        const qint64 now_ms = m_clock.elapsed();
+        if (input_cnt > 0)
+            last_input_ms = now_ms;
+
+        const unsigned long wait_ms = m_idx_to_device.empty()
+            ? NO_DEVICE_POLL_MS
+            : (now_ms - last_input_ms < IDLE_AFTER_MS) ? ACTIVE_POLL_MS : IDLE_POLL_MS;
+        m_wakeup.wait(&m_guard, wait_ms);
+    }
+    lock.unlock();
+
+    m_axis_values.clear();
     m_idx_to_device.clear();
+    m_iid_to_idx.clear();
     SDL_Quit();
 }
 
@@ -365,6 +463,7 @@ void GamepadManagerSDL2::load_user_gamepaddb(const QString& dir)
 
 void GamepadManagerSDL2::start_recording(int device_idx, GamepadButton button)
 {
+    const QMutexLocker lock(&m_guard);
     m_recording.reset();
     m_recording.device = device_idx;
     m_recording.target_button = button;
@@ -372,6 +471,7 @@ void GamepadManagerSDL2::start_recording(int device_idx, GamepadButton button)
 
 void GamepadManagerSDL2::start_recording(int device_idx, GamepadAxis axis)
 {
+    const QMutexLocker lock(&m_guard);
     m_recording.reset();
     m_recording.device = device_idx;
     m_recording.target_axis = axis;
@@ -379,62 +479,143 @@ void GamepadManagerSDL2::start_recording(int device_idx, GamepadAxis axis)
 
 void GamepadManagerSDL2::cancel_recording()
 {
-    if (m_recording.is_active())
-        emit configurationCanceled(m_recording.device);
+    int device_idx = -1;
+    {
+        const QMutexLocker lock(&m_guard);
+        device_idx = m_recording.device;
+        m_recording.reset();
+    }
 
-    m_recording.reset();
+    if (device_idx >= 0)
+        emit configurationCanceled(device_idx);
 }
 
-void GamepadManagerSDL2::poll()
+int GamepadManagerSDL2::poll_events()
 {
+    int input_cnt = 0;
+
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_CONTROLLERDEVICEADDED:
-                // ignored in favor of SDL_JOYDEVICEADDED
-                break;
-            case SDL_CONTROLLERDEVICEREMOVED:
-                remove_pad_by_iid(event.cdevice.which);
-                break;
-            case SDL_CONTROLLERDEVICEREMAPPED:
-                // ignored, could be logged
-                break;
-            case SDL_JOYDEVICEADDED:
-                add_controller_by_idx(event.jdevice.which);
-                break;
-            case SDL_JOYDEVICEREMOVED:
-                // ignored in favor of SDL_CONTROLLERDEVICEREMOVED
-                break;
-            case SDL_CONTROLLERBUTTONUP:
-            case SDL_CONTROLLERBUTTONDOWN:
-                // also ignore input from other (non-recording) gamepads
-                if (!m_recording.is_active()) {
-                    const bool pressed = event.cbutton.state == SDL_PRESSED;
-                    fwd_button_event(event.cbutton.which, event.cbutton.button, pressed);
-                }
-                break;
-            case SDL_CONTROLLERAXISMOTION:
-                if (!m_recording.is_active())
-                    fwd_axis_event(event.caxis.which, event.caxis.axis, event.caxis.value);
-                break;
-            case SDL_JOYBUTTONUP:
-                // ignored
-                break;
-            case SDL_JOYBUTTONDOWN:
-                record_joy_button_maybe(event.jbutton.which, event.jbutton.button);
-                break;
-            case SDL_JOYHATMOTION:
-                record_joy_hat_maybe(event.jhat.which, event.jhat.hat, event.jhat.value);
-                break;
-            case SDL_JOYAXISMOTION:
-                record_joy_axis_maybe(event.jaxis.which, event.jaxis.axis, event.jaxis.value);
-                break;
-            default:
-                break;
+    while (SDL_PollEvent(&event))
+        input_cnt += handle_event(event);
+
+    return input_cnt;
+}
+
+int GamepadManagerSDL2::handle_event(const SDL_Event& event)
+{
+    int input_cnt = 0;
+    const qint64 arrival_us = arrival_time_us(event);
+
+    switch (event.type) {
+        case SDL_CONTROLLERDEVICEADDED:
+            // ignored in favor of SDL_JOYDEVICEADDED
+            break;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            remove_pad_by_iid(event.cdevice.which);
+            break;
+        case SDL_CONTROLLERDEVICEREMAPPED:
+            // ignored, could be logged
+            break;
+        case SDL_JOYDEVICEADDED:
+            add_controller_by_idx(event.jdevice.which);
+            break;
+        case SDL_JOYDEVICEREMOVED:
+            // ignored in favor of SDL_CONTROLLERDEVICEREMOVED
+            break;
+        case SDL_CONTROLLERBUTTONUP:
+        case SDL_CONTROLLERBUTTONDOWN:
+            input_cnt++;
+            // also ignore input from other (non-recording) gamepads
+            if (!m_recording.is_active()) {
+                const bool pressed = event.cbutton.state == SDL_PRESSED;
+                fwd_button_event(event.cbutton.which, event.cbutton.button, pressed, arrival_us);
+            }
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+            if (!m_recording.is_active()
+                && fwd_axis_event(event.caxis.which, event.caxis.axis, event.caxis.value, arrival_us))
+            {
+                input_cnt++;
+            }
+            break;
+        case SDL_JOYBUTTONUP:
+            // ignored
+            break;
+        case SDL_JOYBUTTONDOWN:
+            record_joy_button_maybe(event.jbutton.which, event.jbutton.button);
+            break;
+        case SDL_JOYHATMOTION:
+            record_joy_hat_maybe(event.jhat.which, event.jhat.hat, event.jhat.value);
+            break;
+        case SDL_JOYAXISMOTION:
+            record_joy_axis_maybe(event.jaxis.which, event.jaxis.axis, event.jaxis.value);
+            break;
+        default:
+            break;
+    }
+
+    return input_cnt;
+}
+
+qint64 GamepadManagerSDL2::arrival_time_us(const SDL_Event& event) const
+{
+    // the event timestamps are in SDL ticks, the milliseconds since SDL_Init;
+    // the unsigned difference stays correct when the ticks wrap around
+    const Uint32 age_ms = SDL_GetTicks() - event.common.timestamp;
+    return m_clock.nsecsElapsed() / 1000 - static_cast<qint64>(age_ms) * 1000;
+}
+
+void GamepadManagerSDL2::send_batch()
+{
+    if (m_batch.empty())
+        return;
+
+    std::vector<InputEvent> batch;
+    batch.swap(m_batch);
+    QMetaObject::invokeMethod(this, [this, batch]{ deliver_batch(batch); }, Qt::QueuedConnection);
+}
+
+void GamepadManagerSDL2::deliver_batch(const std::vector<InputEvent>& batch)
+{
+    for (const InputEvent& event : batch) {
+        if (!event.is_button) {
+            emit axisChanged(event.device_idx, event.axis, event.axis_value);
+            continue;
         }
+
+        emit buttonChanged(event.device_idx, event.button, event.pressed);
+        if (m_measure_latency && event.pressed)
+            measure_latency(event.arrival_us);
     }
 }
 
+void GamepadManagerSDL2::measure_latency(qint64 arrival_us)
+{
+    const qint64 delivered_us = m_clock.nsecsElapsed() / 1000;
+    const auto format_ms = [arrival_us](qint64 time_us){
+        return QString::number((time_us - arrival_us) / 1000.0, 'f', 1);
+    };
+
+    auto window = qobject_cast<QQuickWindow*>(QGuiApplication::focusWindow());
+    if (!window) {
+        qInfo().noquote() << tr_log("Gamepad: input reached the main thread in %1 ms")
+            .arg(format_ms(delivered_us));
+        return;
+    }
+
+    // the first frame rendered after the input was handled;
+    // this may be called on the render thread
+    const QElapsedTimer clock = m_clock;
+    auto conn = std::make_shared<QMetaObject::Connection>();
+    *conn = connect(window, &QQuickWindow::frameSwapped, [conn, clock, delivered_us, format_ms]{
+        QObject::disconnect(*conn);
+
+        const qint64 shown_us = clock.nsecsElapsed() / 1000;
+        qInfo().noquote() << tr_log("Gamepad: input shown in %1 ms (reached the main thread in %2 ms)")
+            .arg(format_ms(shown_us), format_ms(delivered_us));
+    });
+}
+
 void GamepadManagerSDL2::add_controller_by_idx(int device_idx)
 {
     Q_ASSERT(m_idx_to_device.count(device_idx) == 0);
@@ -463,6 +644,8 @@ void GamepadManagerSDL2::add_controller_by_idx(int device_idx)
     m_idx_to_device.emplace(device_idx, device_ptr(pad, SDL_GameControllerClose));
     m_iid_to_idx.emplace(iid, device_idx);
 
+    // keep the order of the events
+    send_batch();
     emit connected(device_idx, name);
 }
 
@@ -474,31 +657,66 @@ void GamepadManagerSDL2::remove_pad_by_iid(SDL_JoystickID instance_id)
     const int device_idx = m_iid_to_idx.at(instance_id);
     m_idx_to_device.erase(device_idx);
     m_iid_to_idx.erase(instance_id);
+    m_axis_values.erase(device_idx);
 
-    if (m_recording.device == device_idx)
-        cancel_recording();
+    if (m_recording.device == device_idx) {
+        m_recording.reset();
+        emit configurationCanceled(device_idx);
+    }
 
+    send_batch();
     emit disconnected(device_idx);
 }
 
-void GamepadManagerSDL2::fwd_button_event(SDL_JoystickID instance_id, Uint8 button, bool pressed)
+void GamepadManagerSDL2::fwd_button_event(SDL_JoystickID instance_id, Uint8 button, bool pressed, qint64 arrival_us)
 {
     const int device_idx = m_iid_to_idx.at(instance_id);
-    emit buttonChanged(device_idx, translate_button(button), pressed);
+    m_batch.push_back({
+        true,
+        device_idx,
+        translate_button(button), pressed,
+        GamepadAxis::INVALID, 0.0,
+        arrival_us,
+    });
 }
 
-void GamepadManagerSDL2::fwd_axis_event(SDL_JoystickID instance_id, Uint8 axis, Sint16 value)
+bool GamepadManagerSDL2::fwd_axis_event(SDL_JoystickID instance_id, Uint8 axis, Sint16 value, qint64 arrival_us)
 {
+    if (SDL_CONTROLLER_AXIS_MAX <= axis)
+        return false;
+
     const int device_idx = m_iid_to_idx.at(instance_id);
 
+    // a slightly moving stick or trigger would send events all the time;
+    // inside the deadzone, only the first one is forwarded, as zero
+    if (-AXIS_DEADZONE < value && value < AXIS_DEADZONE)
+        value = 0;
+    Sint16& last_value = m_axis_values[device_idx][axis];
+    if (value == 0 && last_value == 0)
+        return false;
+    last_value = value;
+
     const GamepadButton button = detect_trigger_axis(axis);
     if (button != GamepadButton::INVALID) {
-        emit buttonChanged(device_idx, button, value != 0);
-        return;
+        m_batch.push_back({
+            true,
+            device_idx,
+            button, value != 0,
+            GamepadAxis::INVALID, 0.0,
+            arrival_us,
+        });
+        return true;
     }
 
     const double dblval = value / static_cast<double>(std::numeric_limits<Sint16>::max());
-    emit axisChanged(device_idx, translate_axis(axis), dblval);
+    m_batch.push_back({
+        false,
+        device_idx,
+        GamepadButton::INVALID, false,
+        translate_axis(axis), dblval,
+        arrival_us,
+    });
+    return true;
 }
 
 void GamepadManagerSDL2::record_joy_button_maybe(SDL_JoystickID instance_id, Uint8 button)
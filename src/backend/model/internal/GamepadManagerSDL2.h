@@ -21,12 +21,24 @@
 #include "GamepadManagerBackend.h"
 
 #include <SDL.h>
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <array>
 #include <memory>
+#include <vector>
+
+class QThread;
 
 
 namespace model {
 
+/// Gamepad support using SDL2
+///
+/// Every SDL call happens on a dedicated input thread. The input events are
+/// forwarded to the main thread in batches, together with the time SDL
+/// received them. With SDL older than 2.0.16 the events are only read when
+/// the thread polls, so that delay is not part of the measured latency.
 class GamepadManagerSDL2 : public GamepadManagerBackend {
 public:
     explicit GamepadManagerSDL2(QObject* parent);
@@ -38,22 +50,47 @@ public:
     void start_recording(int, GamepadAxis) final;
     void cancel_recording() final;
 
-private slots:
-    void poll();
-
 private:
     const uint16_t m_sdl_version;
-    QTimer m_poll_timer;
+    QElapsedTimer m_clock;
+    bool m_measure_latency;
+
+    // input thread control, also guards the recording state
+    QThread* m_input_thread;
+    QMutex m_guard;
+    QWaitCondition m_wakeup;
+    bool m_stopping;
+
+    void run_input_thread(const backend::CliArgs&);
+    int poll_events();
+    int handle_event(const SDL_Event&);
+    qint64 arrival_time_us(const SDL_Event&) const;
+
+    struct InputEvent {
+        bool is_button;
+        int device_idx;
+        GamepadButton button;
+        bool pressed;
+        GamepadAxis axis;
+        double axis_value;
+        qint64 arrival_us;
+    };
+    std::vector<InputEvent> m_batch;
+    void send_batch();
+    void deliver_batch(const std::vector<InputEvent>&);
+    void measure_latency(qint64 arrival_us);
 
     using device_deleter = void(*)(SDL_GameController*);
     using device_ptr = std::unique_ptr<SDL_GameController, device_deleter>;
     HashMap<int, const device_ptr> m_idx_to_device;
     HashMap<SDL_JoystickID, const int> m_iid_to_idx;
+    // the last forwarded value of each axis, by device index
+    HashMap<int, std::array<Sint16, SDL_CONTROLLER_AXIS_MAX>> m_axis_values;
 
     void add_controller_by_idx(int);
     void remove_pad_by_iid(SDL_JoystickID);
-    void fwd_button_event(SDL_JoystickID, Uint8, bool);
-    void fwd_axis_event(SDL_JoystickID, Uint8, Sint16);
+    void fwd_button_event(SDL_JoystickID, Uint8, bool, qint64);
+    bool fwd_axis_event(SDL_JoystickID, Uint8, Sint16, qint64);
 
     struct RecordingState {
         int device = -1;
@@ -38,6 +38,8 @@ Meta::Meta(const backend::CliArgs& args, QObject* parent)
     , m_loading(true)
     , m_loading_progress(0.f)
     , m_game_count(0)
+    , m_startup_hook_running(false)
+    , m_startup_hook_success(false)
 {}
 
 void Meta::resetLoadingState()
@@ -91,4 +93,18 @@ void Meta::onGameCountUpdate(int game_count)
     }
 }
 
+void Meta::onStartupHookStarted()
+{
+    m_startup_hook_running = true;
+    m_startup_hook_success = false;
+    emit startupHookChanged();
+}
+
+void Meta::onStartupHookFinished(bool success)
+{
+    m_startup_hook_running = false;
+    m_startup_hook_success = success;
+    emit startupHookChanged();
+}
+
 } // namespace model
\ No newline at end of file
@@ -31,6 +31,9 @@ class Meta : public QObject {
     Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
     Q_PROPERTY(float loadingProgress READ loadingProgress NOTIFY loadingProgressChanged)
 
+    Q_PROPERTY(bool startupHookRunning READ startupHookRunning NOTIFY startupHookChanged)
+    Q_PROPERTY(bool startupHookSuccess READ startupHookSuccess NOTIFY startupHookChanged)
+
     Q_PROPERTY(int gameCount READ gameCount NOTIFY gameCountChanged)
 
     Q_PROPERTY(QString gitRevision MEMBER m_git_revision CONSTANT)
@@ -56,16 +59,23 @@ public:
 
     int gameCount() const { return m_game_count; }
 
+    bool startupHookRunning() const { return m_startup_hook_running; }
+    bool startupHookSuccess() const { return m_startup_hook_success; }
+
 public slots:
     void onFirstPhaseCompleted(qint64 elapsedTime);
     void onSecondPhaseCompleted(qint64 elapsedTime);
 
     void onGameCountUpdate(int game_count);
 
+    void onStartupHookStarted();
+    void onStartupHookFinished(bool success);
+
 signals:
     void loadingChanged();
     void loadingProgressChanged();
     void gameCountChanged();
+    void startupHookChanged();
 
     void qmlClearCacheRequested();
 
@@ -83,6 +93,9 @@ private:
     float m_loading_progress;
 
     int m_game_count;
+
+    bool m_startup_hook_running;
+    bool m_startup_hook_success;
 };
 
 } // namespace model
\ No newline at end of file
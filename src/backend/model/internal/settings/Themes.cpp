@@ -28,6 +28,7 @@
 #include <QDirIterator>
 #include <QStringBuilder>
 #include <QUrl>
+#include <algorithm>
 
 
 namespace {
@@ -57,11 +58,9 @@ HashMap<QString, QString> read_metafile(const QString& config_file_path)
     return result;
 }
 
-std::vector<model::ThemeEntry> find_available_themes()
+// Reads the theme in the directory, and adds it to the list if it's valid
+bool read_theme(const QString& basedir, std::vector<model::ThemeEntry>& themes)
 {
-    constexpr auto filters = QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot;
-    constexpr auto flags = QDirIterator::FollowSymlinks;
-
     const auto META_FILENAME(QStringLiteral("theme.cfg"));
     const auto QML_FILENAME(QStringLiteral("theme.qml"));
 
@@ -77,6 +76,54 @@ std::vector<model::ThemeEntry> find_available_themes()
     const auto E_KEY_MISSING = tr_log("There is no `%1` entry in `%2`, theme skipped");
 
 
+    const QString meta_path = basedir % META_FILENAME;
+    QString qml_path = basedir % QML_FILENAME;
+
+    if (!::validFile(meta_path)) {
+        qWarning().noquote() << E_FILE_MISSING.arg(META_FILENAME, basedir);
+        return false;
+    }
+    if (!::validFile(qml_path)) {
+        qWarning().noquote() << E_FILE_MISSING.arg(QML_FILENAME, basedir);
+        return false;
+    }
+
+    HashMap<QString, QString> metadata = read_metafile(meta_path);
+    if (!metadata.count(META_KEY_NAME)) {
+        qWarning().noquote() << E_KEY_MISSING.arg(META_KEY_NAME, meta_path);
+        return false;
+    }
+
+    // add the qrc/file protocol prefix
+    const bool is_builtin = basedir.startsWith(':');
+    qml_path = is_builtin
+        ? QLatin1String("qrc://") % qml_path.midRef(1)
+        : QUrl::fromLocalFile(qml_path).toString();
+
+    themes.emplace_back(
+        basedir,
+        qml_path,
+        metadata[META_KEY_NAME],
+        metadata[META_KEY_AUTHOR],
+        metadata[META_KEY_VERSION],
+        metadata[META_KEY_SUMMARY],
+        metadata[META_KEY_DESC]);
+
+    qInfo().noquote() << tr_log("Found theme `%1` at `%2`")
+                         .arg(themes.back().name, themes.back().root_dir);
+    return true;
+}
+
+bool theme_less(const model::ThemeEntry& a, const model::ThemeEntry& b)
+{
+    return QString::localeAwareCompare(a.name, b.name) < 0;
+}
+
+std::vector<model::ThemeEntry> find_available_themes()
+{
+    constexpr auto filters = QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot;
+    constexpr auto flags = QDirIterator::FollowSymlinks;
+
     const QStringList search_paths = theme_directories();
 
     std::vector<model::ThemeEntry> themes;
@@ -84,54 +131,21 @@ std::vector<model::ThemeEntry> find_available_themes()
 
     for (auto& path : search_paths) {
         QDirIterator themedir(path, filters, flags);
-        while (themedir.hasNext()) {
-            const QString basedir = themedir.next() % '/';
-            const QString meta_path = basedir % META_FILENAME;
-            QString qml_path = basedir % QML_FILENAME;
-
-            if (!::validFile(meta_path)) {
-                qWarning().noquote() << E_FILE_MISSING.arg(META_FILENAME, basedir);
-                continue;
-            }
-            if (!::validFile(qml_path)) {
-                qWarning().noquote() << E_FILE_MISSING.arg(QML_FILENAME, basedir);
-                continue;
-            }
-
-            HashMap<QString, QString> metadata = read_metafile(meta_path);
-            if (!metadata.count(META_KEY_NAME)) {
-                qWarning().noquote() << E_KEY_MISSING.arg(META_KEY_NAME, meta_path);
-                continue;
-            }
-
-            // add the qrc/file protocol prefix
-            const bool is_builtin = basedir.startsWith(':');
-            qml_path = is_builtin
-                ? QLatin1String("qrc://") % qml_path.midRef(1)
-                : QUrl::fromLocalFile(qml_path).toString();
-
-            themes.emplace_back(
-                basedir,
-                qml_path,
-                metadata[META_KEY_NAME],
-                metadata[META_KEY_AUTHOR],
-                metadata[META_KEY_VERSION],
-                metadata[META_KEY_SUMMARY],
-                metadata[META_KEY_DESC]);
-
-            qInfo().noquote() << tr_log("Found theme `%1` at `%2`")
-                                 .arg(themes.back().name, themes.back().root_dir);
-        }
+        while (themedir.hasNext())
+            read_theme(themedir.next() % '/', themes);
     }
 
-    std::sort(themes.begin(), themes.end(),
-        [](const model::ThemeEntry& a, const model::ThemeEntry& b) {
-            return QString::localeAwareCompare(a.name, b.name) < 0;
-        }
-    );
-
+    std::sort(themes.begin(), themes.end(), theme_less);
     return themes;
 }
+
+bool is_default_theme(const QString& root_dir)
+{
+    // the stored path is made absolute when the settings are loaded
+    const QFileInfo finfo(paths::writableConfigDir(), root_dir);
+    const QFileInfo default_finfo(paths::writableConfigDir(), AppSettings::general.DEFAULT_THEME);
+    return root_dir.isEmpty() || finfo.absoluteFilePath() == default_finfo.absoluteFilePath();
+}
 } // namespace
 
 
@@ -157,7 +171,8 @@ Themes::Themes(QObject* parent)
         { Roles::Summary, QByteArrayLiteral("summary") },
         { Roles::Description, QByteArrayLiteral("description") },
     })
-    , m_themes(find_available_themes())
+    , m_all_found(false)
+    , m_current_idx(0)
 {
     select_preferred_theme();
     print_change();
@@ -165,11 +180,17 @@ Themes::Themes(QObject* parent)
 
 void Themes::select_preferred_theme()
 {
-    // A. Try to use the debug theme if available
+    // A. Use the theme selected the last time, unless it's the default one;
+    //    the settings file always contains a theme, and the debug theme
+    //    should still take precedence over the built-in one
+    if (!is_default_theme(AppSettings::general.theme) && select_theme(AppSettings::general.theme))
+        return;
+
+    // B. Try to use the debug theme if available
     if (select_theme(AppSettings::general.DEBUG_THEME))
         return;
 
-    // B. Fall back to the built-in theme
+    // C. Fall back to the built-in theme
     if (select_theme(AppSettings::general.DEFAULT_THEME))
         return;
 
@@ -183,11 +204,11 @@ bool Themes::select_theme(const QString& root_dir)
 
     const QFileInfo root_finfo(paths::writableConfigDir(), root_dir);
 
-    for (size_t idx = 0; idx < m_themes.size(); idx++) {
-        if (QFileInfo(m_themes.at(idx).root_dir) == root_finfo) {
-            m_current_idx = idx;
-            return true;
-        }
+    // only the theme to use is read at this point
+    Q_ASSERT(m_themes.empty());
+    if (root_finfo.isDir() && read_theme(root_finfo.absoluteFilePath() % '/', m_themes)) {
+        m_current_idx = 0;
+        return true;
     }
 
     qWarning().noquote() << tr_log("Requested theme `%1` not found, falling back to default")
@@ -203,6 +224,52 @@ void Themes::print_change() const
                          .arg(current.name, current.root_dir);
 }
 
+bool Themes::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && !m_all_found;
+}
+
+void Themes::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    m_all_found = true;
+
+    std::vector<ThemeEntry> found = find_available_themes();
+
+    // the current theme is already in the list, and stays there even if
+    // it's gone since the startup
+    const ThemeEntry& current = m_themes.at(m_current_idx);
+    const QFileInfo current_finfo(current.root_dir);
+    auto current_it = std::find_if(found.begin(), found.end(),
+        [&current_finfo](const ThemeEntry& entry){ return QFileInfo(entry.root_dir) == current_finfo; });
+    current_it = current_it != found.end()
+        ? found.erase(current_it)
+        : std::upper_bound(found.begin(), found.end(), current, theme_less);
+
+    // the rest is added around the current entry
+    const auto themes_before = static_cast<int>(std::distance(found.begin(), current_it));
+    const auto themes_after = static_cast<int>(std::distance(current_it, found.end()));
+
+    if (themes_before > 0) {
+        beginInsertRows(QModelIndex(), 0, themes_before - 1);
+        m_themes.insert(m_themes.begin(),
+                        std::make_move_iterator(found.begin()),
+                        std::make_move_iterator(current_it));
+        m_current_idx = static_cast<size_t>(themes_before);
+        endInsertRows();
+        emit currentIndexChanged();
+    }
+    if (themes_after > 0) {
+        beginInsertRows(QModelIndex(), themes_before + 1, themes_before + themes_after);
+        m_themes.insert(m_themes.end(),
+                        std::make_move_iterator(current_it),
+                        std::make_move_iterator(found.end()));
+        endInsertRows();
+    }
+}
+
 int Themes::rowCount(const QModelIndex& parent) const
 {
     if (parent.isValid())
@@ -249,6 +316,7 @@ void Themes::setCurrentIndex(int idx_int)
     // set
     m_current_idx = idx;
     print_change();
+    emit currentIndexChanged();
     emit themeChanged();
 
     // remember
@@ -39,9 +39,13 @@ struct ThemeEntry {
 };
 
 
+/// The list of installed themes
+///
+/// Only the current theme is read at startup; the rest of the themes are
+/// looked for when the list is first shown (see `fetchMore`).
 class Themes : public QAbstractListModel {
     Q_OBJECT
-    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY themeChanged)
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
     Q_PROPERTY(QString currentName READ currentName NOTIFY themeChanged)
     Q_PROPERTY(QString currentQmlPath READ currentQmlPath NOTIFY themeChanged)
 
@@ -59,6 +63,8 @@ public:
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override { return m_role_names; }
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
     int currentIndex() const { return static_cast<int>(m_current_idx); }
     void setCurrentIndex(int);
@@ -68,10 +74,12 @@ public:
 
 signals:
     void themeChanged();
+    void currentIndexChanged();
 
 private:
     const QHash<int, QByteArray> m_role_names;
-    const std::vector<ThemeEntry> m_themes;
+    std::vector<ThemeEntry> m_themes;
+    bool m_all_found;
 
     size_t m_current_idx;
     QTranslator m_translator;
@@ -25,10 +25,16 @@
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QStringBuilder>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 
 
 namespace {
+// quick repeated changes, like the cursor moving in a list, are saved together
+static constexpr int FLUSH_DELAY_MS = 1000;
+
 QString default_settings_dir()
 {
     return paths::writableConfigDir() % QStringLiteral("/theme_settings/");
@@ -51,8 +57,9 @@ void save_map_maybe(const QVariantMap& map, const QString& settings_dir, const Q
         return;
     }
 
+    // the previous file stays in place if the writing fails
     const QString json_path = json_path_for(settings_dir, theme_id);
-    QFile json_file(json_path);
+    QSaveFile json_file(json_path);
     if (!json_file.open(QIODevice::WriteOnly)) {
         qWarning().noquote()
             << tr_log("could not save theme settings file `%1`: %2")
@@ -61,7 +68,7 @@ void save_map_maybe(const QVariantMap& map, const QString& settings_dir, const Q
     }
 
     const auto json_doc = QJsonDocument::fromVariant(map);
-    if (json_file.write(json_doc.toJson(QJsonDocument::Compact)) < 0) {
+    if (json_file.write(json_doc.toJson(QJsonDocument::Compact)) < 0 || !json_file.commit()) {
         qWarning().noquote()
             << tr_log("failed to write theme settings file `%1`: %2")
                 .arg(json_path, json_file.errorString());
@@ -107,11 +114,73 @@ Memory::Memory(QObject* parent)
 Memory::Memory(QString settings_dir, QObject* parent)
     : QObject(parent)
     , m_settings_dir(std::move(settings_dir))
-{}
+    , m_dirty(false)
+    , m_processing(false)
+{
+    m_flush_timer.setSingleShot(true);
+    m_flush_timer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flush_timer, &QTimer::timeout,
+            this, &Memory::flush);
+}
+
+Memory::~Memory()
+{
+    save();
+}
+
+void Memory::flush()
+{
+    m_flush_timer.stop();
+    if (!m_dirty)
+        return;
+
+    m_dirty = false;
 
-void Memory::flush() const
+    // the map is implicitly shared, so this is a cheap snapshot
+    SaveTask task { m_settings_dir, m_current_theme, m_data };
+
+    QMutexLocker lock(&m_task_guard);
+    m_pending_tasks.push_back(std::move(task));
+    if (!m_processing) {
+        m_processing = true;
+        start_processing();
+    }
+}
+
+void Memory::save()
+{
+    flush();
+    m_future.waitForFinished();
+}
+
+void Memory::start_processing()
 {
-    save_map_maybe(m_data, m_settings_dir, m_current_theme);
+    m_future = QtConcurrent::run([this]{
+        while (true) {
+            std::vector<SaveTask> tasks;
+            {
+                QMutexLocker lock(&m_task_guard);
+                if (m_pending_tasks.empty()) {
+                    m_processing = false;
+                    break;
+                }
+                tasks.swap(m_pending_tasks);
+            }
+
+            for (size_t i = 0; i < tasks.size(); i++) {
+                const SaveTask& task = tasks[i];
+
+                // only the last state of a file is written
+                const auto is_same_file = [&task](const SaveTask& other){
+                    return other.theme_id == task.theme_id && other.settings_dir == task.settings_dir;
+                };
+                if (std::any_of(tasks.cbegin() + i + 1, tasks.cend(), is_same_file))
+                    continue;
+
+                save_map_maybe(task.data, task.settings_dir, task.theme_id);
+            }
+        }
+    });
 }
 
 QVariant Memory::get(const QString& key) const
@@ -138,7 +207,8 @@ void Memory::set(const QString& key, QVariant value)
     m_data[key] = std::move(value);
     emit dataChanged();
 
-    flush();
+    m_dirty = true;
+    m_flush_timer.start();
 }
 
 void Memory::unset(const QString& key)
@@ -146,7 +216,8 @@ void Memory::unset(const QString& key)
     m_data.remove(key);
     emit dataChanged();
 
-    flush();
+    m_dirty = true;
+    m_flush_timer.start();
 }
 
 void Memory::changeTheme(const QString& theme_root_dir)
@@ -155,6 +226,11 @@ void Memory::changeTheme(const QString& theme_root_dir)
     const int dir_name_start = theme_root_dir.lastIndexOf('/', -2) + 1;
     const int dir_name_len = theme_root_dir.length() - dir_name_start - 1;
     Q_ASSERT(dir_name_len > 0);
+
+    // the settings of the previous theme have to be on the disk before
+    // they could be read again
+    save();
+
     m_current_theme = theme_root_dir.mid(dir_name_start, dir_name_len);
 
     m_data = load_map_maybe(m_settings_dir, m_current_theme);
@@ -17,17 +17,26 @@
 
 #pragma once
 
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
+#include <QTimer>
 #include <QVariantMap>
+#include <vector>
 
 
 namespace model {
+/// Persistent key-value storage for the themes
+///
+/// The values are kept in memory. The changes are written to the settings
+/// file of the theme in batches, after a short delay, on a worker thread.
 class Memory : public QObject {
     Q_OBJECT
 
 public:
     explicit Memory(QObject* parent = nullptr);
     explicit Memory(QString settings_dir, QObject* parent = nullptr);
+    ~Memory();
 
     Q_INVOKABLE QVariant get(const QString&) const;
     Q_INVOKABLE bool has(const QString&) const;
@@ -36,6 +45,11 @@ public:
 
     void changeTheme(const QString&);
 
+    /// Starts writing the unsaved changes, without waiting for them
+    void flush();
+    /// Writes the unsaved changes and waits until they are done
+    void save();
+
 signals:
     // NOTE: because QVariantMap cannot be changed on the QML side (QTBUG-59474),
     // get/set functions were introduced. Because of this however, sending a
@@ -46,7 +60,19 @@ private:
     const QString m_settings_dir;
     QString m_current_theme;
     QVariantMap m_data;
+    bool m_dirty;
+    QTimer m_flush_timer;
+
+    struct SaveTask {
+        QString settings_dir;
+        QString theme_id;
+        QVariantMap data;
+    };
+    std::vector<SaveTask> m_pending_tasks;
+    bool m_processing;
+    QMutex m_task_guard;
+    QFuture<void> m_future;
 
-    void flush() const;
+    void start_processing();
 };
 } // namespace model
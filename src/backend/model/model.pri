@@ -2,3 +2,4 @@ include(gaming/gaming.pri)
 include(keys/keys.pri)
 include(memory/memory.pri)
 include(internal/internal.pri)
+include(images/images.pri)
@@ -28,12 +28,155 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QKeySequence>
+#include <QSaveFile>
 
 
 namespace {
 
 const QLatin1String COMMA_NAME_STR("Comma");
 
+// the keys that can be set in the settings file
+constexpr KeyEvent CONFIG_KEY_EVENTS[] {
+    KeyEvent::ACCEPT,
+    KeyEvent::CANCEL,
+    KeyEvent::DETAILS,
+    KeyEvent::FILTERS,
+    KeyEvent::NEXT_PAGE,
+    KeyEvent::PREV_PAGE,
+    KeyEvent::PAGE_UP,
+    KeyEvent::PAGE_DOWN,
+    KeyEvent::MAIN_MENU,
+};
+
+constexpr quint32 KEY_HASH_BASIS = 2166136261u;
+constexpr quint32 KEY_HASH_PRIME = 16777619u;
+
+// FNV-1a over the (ASCII) key names. The hashes of the known names are
+// calculated at compile time and used as switch cases, so if two of them
+// would collide, the code would not compile.
+constexpr quint32 key_hash(const char* str, quint32 hash = KEY_HASH_BASIS)
+{
+    return *str
+        ? key_hash(str + 1, (hash ^ static_cast<quint8>(*str)) * KEY_HASH_PRIME)
+        : hash;
+}
+
+quint32 key_hash(const QStringRef& str)
+{
+    quint32 hash = KEY_HASH_BASIS;
+    for (const QChar ch : str) {
+        // none of the known names would match
+        if (ch.unicode() > 0x7F)
+            return 0;
+
+        hash = (hash ^ static_cast<quint8>(ch.unicode())) * KEY_HASH_PRIME;
+    }
+    return hash;
+}
+
+
+const char* category_name(appsettings::ConfigEntryCategory category)
+{
+    using Category = appsettings::ConfigEntryCategory;
+    switch (category) {
+        case Category::GENERAL: return "general";
+        case Category::PROVIDERS: return "providers";
+        case Category::KEYS: return "keys";
+    }
+    Q_UNREACHABLE();
+    return nullptr;
+}
+
+const char* general_option_name(appsettings::ConfigEntryGeneralOption option)
+{
+    using GeneralOption = appsettings::ConfigEntryGeneralOption;
+    switch (option) {
+        case GeneralOption::FULLSCREEN: return "fullscreen";
+        case GeneralOption::MOUSE_SUPPORT: return "input-mouse-support";
+        case GeneralOption::PREGEN_THUMBNAILS: return "pregenerate-thumbnails";
+        case GeneralOption::STARTUP_HOOK_TIMEOUT: return "startup-hook-timeout";
+        case GeneralOption::SCRIPT_TIMEOUT: return "script-timeout";
+        case GeneralOption::LOCALE: return "locale";
+        case GeneralOption::THEME: return "theme";
+    }
+    Q_UNREACHABLE();
+    return nullptr;
+}
+
+const char* key_event_name(KeyEvent event)
+{
+    switch (event) {
+        case KeyEvent::ACCEPT: return "accept";
+        case KeyEvent::CANCEL: return "cancel";
+        case KeyEvent::DETAILS: return "details";
+        case KeyEvent::FILTERS: return "filters";
+        case KeyEvent::NEXT_PAGE: return "next-page";
+        case KeyEvent::PREV_PAGE: return "prev-page";
+        case KeyEvent::PAGE_UP: return "page-up";
+        case KeyEvent::PAGE_DOWN: return "page-down";
+        case KeyEvent::MAIN_MENU: return "menu";
+        default:
+            Q_UNREACHABLE();
+            return nullptr;
+    }
+}
+
+// NOTE: the hash lookups are followed by a string comparison, as an unknown
+// name may have the same hash as a known one
+
+bool find_category(const QStringRef& str, appsettings::ConfigEntryCategory& out)
+{
+    using Category = appsettings::ConfigEntryCategory;
+    switch (key_hash(str)) {
+        case key_hash("general"): out = Category::GENERAL; break;
+        case key_hash("providers"): out = Category::PROVIDERS; break;
+        case key_hash("keys"): out = Category::KEYS; break;
+        default: return false;
+    }
+    return str == QLatin1String(category_name(out));
+}
+
+bool find_general_option(const QStringRef& str, appsettings::ConfigEntryGeneralOption& out)
+{
+    using GeneralOption = appsettings::ConfigEntryGeneralOption;
+    switch (key_hash(str)) {
+        case key_hash("fullscreen"): out = GeneralOption::FULLSCREEN; break;
+        case key_hash("input-mouse-support"): out = GeneralOption::MOUSE_SUPPORT; break;
+        case key_hash("pregenerate-thumbnails"): out = GeneralOption::PREGEN_THUMBNAILS; break;
+        case key_hash("startup-hook-timeout"): out = GeneralOption::STARTUP_HOOK_TIMEOUT; break;
+        case key_hash("script-timeout"): out = GeneralOption::SCRIPT_TIMEOUT; break;
+        case key_hash("locale"): out = GeneralOption::LOCALE; break;
+        case key_hash("theme"): out = GeneralOption::THEME; break;
+        default: return false;
+    }
+    return str == QLatin1String(general_option_name(out));
+}
+
+bool find_key_event(const QStringRef& str, KeyEvent& out)
+{
+    switch (key_hash(str)) {
+        case key_hash("accept"): out = KeyEvent::ACCEPT; break;
+        case key_hash("cancel"): out = KeyEvent::CANCEL; break;
+        case key_hash("details"): out = KeyEvent::DETAILS; break;
+        case key_hash("filters"): out = KeyEvent::FILTERS; break;
+        case key_hash("next-page"): out = KeyEvent::NEXT_PAGE; break;
+        case key_hash("prev-page"): out = KeyEvent::PREV_PAGE; break;
+        case key_hash("page-up"): out = KeyEvent::PAGE_UP; break;
+        case key_hash("page-down"): out = KeyEvent::PAGE_DOWN; break;
+        case key_hash("menu"): out = KeyEvent::MAIN_MENU; break;
+        default: return false;
+    }
+    return str == QLatin1String(key_event_name(out));
+}
+
+// Returns the part before the first dot
+QStringRef first_section(const QStringRef& str)
+{
+    const int dot_pos = str.indexOf(QLatin1Char('.'));
+    return dot_pos < 0 ? str : str.left(dot_pos);
+}
+
+
 std::map<QString, QKeySequence> gen_gamepad_names() {
     std::map<QString, QKeySequence> result;
 
@@ -53,39 +196,27 @@ bool store_bool_maybe(const StrBoolConverter& converter, const QString& str, boo
     return success;
 }
 
+bool store_int_maybe(const QString& str, int& target)
+{
+    bool success = false;
+    const int value = str.toInt(&success);
+    if (success)
+        target = value;
+
+    return success;
+}
+
 } // namespace
 
 
 namespace appsettings {
 
-ConfigEntryMaps::ConfigEntryMaps()
-    : str_to_category {
-        { QStringLiteral("general"), Category::GENERAL },
-        { QStringLiteral("providers"), Category::PROVIDERS },
-        { QStringLiteral("keys"), Category::KEYS },
-    }
-    , str_to_general_opt {
-        { QStringLiteral("fullscreen"), GeneralOption::FULLSCREEN },
-        { QStringLiteral("input-mouse-support"), GeneralOption::MOUSE_SUPPORT },
-        { QStringLiteral("locale"), GeneralOption::LOCALE },
-        { QStringLiteral("theme"), GeneralOption::THEME },
-    }
-    , str_to_key_opt {
-        { QStringLiteral("accept"), KeyEvent::ACCEPT },
-        { QStringLiteral("cancel"), KeyEvent::CANCEL },
-        { QStringLiteral("details"), KeyEvent::DETAILS },
-        { QStringLiteral("filters"), KeyEvent::FILTERS },
-        { QStringLiteral("next-page"), KeyEvent::NEXT_PAGE },
-        { QStringLiteral("prev-page"), KeyEvent::PREV_PAGE },
-        { QStringLiteral("page-up"), KeyEvent::PAGE_UP },
-        { QStringLiteral("page-down"), KeyEvent::PAGE_DOWN },
-        { QStringLiteral("menu"), KeyEvent::MAIN_MENU },
-    }
+SettingsFileContext::SettingsFileContext()
+    : SettingsFileContext(paths::writableConfigDir() + QStringLiteral("/settings.txt"))
 {}
 
-
-SettingsFileContext::SettingsFileContext()
-    : config_path(paths::writableConfigDir() + QStringLiteral("/settings.txt"))
+SettingsFileContext::SettingsFileContext(QString config_path)
+    : config_path(std::move(config_path))
 {}
 
 
@@ -93,19 +224,96 @@ LoadContext::LoadContext()
     : reverse_gamepadButtonNames(gen_gamepad_names())
 {}
 
+LoadContext::LoadContext(QString config_path)
+    : SettingsFileContext(std::move(config_path))
+    , reverse_gamepadButtonNames(gen_gamepad_names())
+{}
+
 void LoadContext::load() const
 {
-    const auto on_error = [this](const metafile::Error& error){
-        log_error(error.line, error.message);
-    };
-    const auto on_attribute = [this](const metafile::Entry& entry){
-        handle_entry(entry.line, entry.key, entry.values);
-    };
+    QFile config_file(config_path);
+    if (config_file.open(QIODevice::ReadOnly | QIODevice::Text))
+        read_entries(QString::fromUtf8(config_file.readAll()));
 
-    metafile::read_file(config_path, on_attribute, on_error);
     qInfo().noquote() << tr_log("Program settings loaded (`%1`)").arg(config_path);
 }
 
+// The same format as the metafiles, but read in one pass over the whole
+// file, with the entries handled as soon as they end
+void LoadContext::read_entries(const QString& text) const
+{
+    constexpr QChar EMPTY_LINE_MARK('.');
+    constexpr QChar BYTE_ORDER_MARK(0xFEFF);
+
+    size_t entry_line = 0;
+    QString entry_key;
+    std::vector<QString> entry_values;
+
+    const auto close_current_entry = [&](){
+        if (!entry_key.isEmpty()) {
+            if (entry_values.empty())
+                log_error(entry_line, tr_log("attribute value missing, entry ignored"));
+            else
+                handle_entry(entry_line, entry_key, entry_values);
+        }
+
+        entry_key.clear();
+        entry_values.clear();
+    };
+
+    size_t lineno = 0;
+    int line_start = text.startsWith(BYTE_ORDER_MARK) ? 1 : 0;
+    while (line_start < text.length()) {
+        int line_end = text.indexOf(QLatin1Char('\n'), line_start);
+        if (line_end < 0)
+            line_end = text.length();
+
+        const QStringRef line = text.midRef(line_start, line_end - line_start);
+        line_start = line_end + 1;
+        lineno++;
+
+        if (line.startsWith(QLatin1Char('#')))
+            continue;
+
+        const QStringRef trimmed_line = line.trimmed();
+        if (trimmed_line.isEmpty()) {
+            close_current_entry();
+            continue;
+        }
+
+        // multiline (starts with whitespace but also has content)
+        if (line.at(0).isSpace()) {
+            if (entry_key.isEmpty()) {
+                log_error(lineno, tr_log("line starts with whitespace, but no attribute has been defined yet"));
+                continue;
+            }
+
+            const bool is_empty_mark = trimmed_line.size() == 1 && trimmed_line.at(0) == EMPTY_LINE_MARK;
+            entry_values.emplace_back(is_empty_mark ? QString() : trimmed_line.toString());
+            continue;
+        }
+
+        close_current_entry();
+
+        // key: value
+        const int colon_pos = trimmed_line.indexOf(QLatin1Char(':'));
+        if (colon_pos < 1) {
+            log_error(lineno, tr_log("line invalid, skipped"));
+            continue;
+        }
+
+        entry_key = trimmed_line.left(colon_pos).trimmed().toString().toLower();
+        entry_line = lineno;
+
+        // the value can be empty here, if it's purely multiline
+        const QStringRef value_part = trimmed_line.mid(colon_pos + 1).trimmed();
+        if (!value_part.isEmpty())
+            entry_values.emplace_back(value_part.toString());
+    }
+
+    close_current_entry();
+}
+
 void LoadContext::log_error(const size_t lineno, const QString& msg) const
 {
     qWarning().noquote()
@@ -124,46 +332,53 @@ void LoadContext::log_needs_bool(const size_t lineno, const QString& key) const
         tr_log("this option (`%1`) must be a boolean (true/false) value").arg(key));
 }
 
+void LoadContext::log_needs_number(const size_t lineno, const QString& key) const
+{
+    log_error(lineno,
+        tr_log("this option (`%1`) must be a whole number").arg(key));
+}
+
 void LoadContext::handle_entry(const size_t lineno,
                                const QString& key,
                                const std::vector<QString>& vals) const
 {
-    QStringList sections = key.split('.');
-    if (sections.size() < 2) {
+    // <category>.<option>
+    const int category_end = key.indexOf(QLatin1Char('.'));
+    if (category_end < 0) {
         log_unknown_key(lineno, key);
         return;
     }
 
-    const QString category_str = sections.takeFirst();
-    const auto category_it = maps.str_to_category.find(category_str);
-    if (category_it == maps.str_to_category.cend()) {
+    ConfigEntryCategory category;
+    if (!find_category(key.leftRef(category_end), category)) {
         log_unknown_key(lineno, key);
         return;
     }
 
-    switch (category_it->second) {
+    const QStringRef sections = key.midRef(category_end + 1);
+    switch (category) {
         case ConfigEntryCategory::GENERAL:
-            handle_general_attrib(lineno, key, metafile::merge_lines(vals), sections);
+            handle_general_attrib(lineno, key, metafile::merge_lines(vals), first_section(sections));
             break;
         case ConfigEntryCategory::PROVIDERS:
             handle_provider_attrib(lineno, key, vals, sections);
             break;
         case ConfigEntryCategory::KEYS:
-            handle_key_attrib(lineno, key, metafile::merge_lines(vals), sections);
+            handle_key_attrib(lineno, key, metafile::merge_lines(vals), first_section(sections));
             break;
     }
 }
 
 void LoadContext::handle_general_attrib(const size_t lineno, const QString& key, const QString& val,
-                                        QStringList& sections) const
+                                        const QStringRef& option_str) const
 {
-    const auto option_it = maps.str_to_general_opt.find(sections.constFirst());
-    if (option_it == maps.str_to_general_opt.cend()) {
+    ConfigEntryGeneralOption option;
+    if (!find_general_option(option_str, option)) {
         log_unknown_key(lineno, key);
         return;
     }
 
-    switch (option_it->second) {
+    switch (option) {
         case ConfigEntryGeneralOption::FULLSCREEN:
             if (!store_bool_maybe(strconv, val, AppSettings::general.fullscreen))
                 log_needs_bool(lineno, key);
@@ -172,6 +387,18 @@ void LoadContext::handle_general_attrib(const size_t lineno, const QString& key,
             if (!store_bool_maybe(strconv, val, AppSettings::general.mouse_support))
                 log_needs_bool(lineno, key);
             break;
+        case ConfigEntryGeneralOption::PREGEN_THUMBNAILS:
+            if (!store_bool_maybe(strconv, val, AppSettings::general.pregen_thumbnails))
+                log_needs_bool(lineno, key);
+            break;
+        case ConfigEntryGeneralOption::STARTUP_HOOK_TIMEOUT:
+            if (!store_int_maybe(val, AppSettings::general.startup_hook_timeout_ms))
+                log_needs_number(lineno, key);
+            break;
+        case ConfigEntryGeneralOption::SCRIPT_TIMEOUT:
+            if (!store_int_maybe(val, AppSettings::general.script_timeout_ms))
+                log_needs_number(lineno, key);
+            break;
         case ConfigEntryGeneralOption::LOCALE:
             AppSettings::general.locale = val;
             break;
@@ -183,14 +410,16 @@ void LoadContext::handle_general_attrib(const size_t lineno, const QString& key,
 
 void LoadContext::handle_provider_attrib(const size_t lineno, const QString& key,
                                          const std::vector<QString>& vals,
-                                         QStringList& sections) const
+                                         const QStringRef& sections) const
 {
-    if (sections.size() < 2) {
+    // <provider>.<option>
+    const int name_end = sections.indexOf(QLatin1Char('.'));
+    if (name_end < 0) {
         log_unknown_key(lineno, key);
         return;
     }
 
-    const QString provider_name = sections.takeFirst();
+    const QStringRef provider_name = sections.left(name_end);
     const auto provider_it = std::find_if(
         AppSettings::providers.cbegin(),
         AppSettings::providers.cend(),
@@ -204,7 +433,7 @@ void LoadContext::handle_provider_attrib(const size_t lineno, const QString& key
         return;
     }
 
-    const QString option = sections.takeFirst();
+    const QStringRef option = first_section(sections.mid(name_end + 1));
     if (option == QLatin1String("enabled")) {
         const QString val = metafile::merge_lines(vals);
 
@@ -218,20 +447,18 @@ void LoadContext::handle_provider_attrib(const size_t lineno, const QString& key
         return;
     }
 
-    (*provider_it)->setOption(option, vals);
+    (*provider_it)->setOption(option.toString(), vals);
 }
 
 void LoadContext::handle_key_attrib(const size_t lineno, const QString& key, const QString& val,
-                       QStringList& sections) const
+                                    const QStringRef& option) const
 {
-    const auto key_it = maps.str_to_key_opt.find(sections.constFirst());
-    if (key_it == maps.str_to_key_opt.cend()) {
+    KeyEvent key_event;
+    if (!find_key_event(option, key_event)) {
         log_unknown_key(lineno, key);
         return;
     }
 
-    const KeyEvent key_event = key_it->second;
-
     AppSettings::keys.clear(key_event);
     if (val.toLower() == QStringLiteral("none"))
         return;
@@ -264,13 +491,18 @@ void LoadContext::handle_key_attrib(const size_t lineno, const QString& key, con
 SaveContext::SaveContext()
     : STR_TRUE(QStringLiteral("true"))
     , STR_FALSE(QStringLiteral("false"))
-    , LINE_TEMPLATE(QStringLiteral("%1.%2: %3\n"))
-    , category_names(gen_category_names())
+{}
+
+SaveContext::SaveContext(QString config_path)
+    : SettingsFileContext(std::move(config_path))
+    , STR_TRUE(QStringLiteral("true"))
+    , STR_FALSE(QStringLiteral("false"))
 {}
 
 void SaveContext::save() const
 {
-    QFile config_file(config_path);
+    // the previous file stays in place if the writing fails
+    QSaveFile config_file(config_path);
     if (!config_file.open(QFile::WriteOnly | QFile::Text)) {
         qWarning().noquote()
             << tr_log("Failed to save program settings to `%1`").arg(config_path);
@@ -278,9 +510,17 @@ void SaveContext::save() const
     }
 
     QTextStream stream(&config_file);
+    stream.setCodec("UTF-8");
     print_general(stream);
     print_providers(stream);
     print_keys(stream);
+    stream.flush();
+
+    if (!config_file.commit()) {
+        qWarning().noquote()
+            << tr_log("Failed to save program settings to `%1`").arg(config_path);
+        return;
+    }
 
     qInfo().noquote() << tr_log("Program settings saved");
 }
@@ -288,75 +528,69 @@ void SaveContext::save() const
 void SaveContext::print_general(QTextStream& stream) const
 {
     using GeneralOption = ConfigEntryGeneralOption;
-    using GeneralStrMap = HashMap<GeneralOption, QString, EnumHash>;
-
-    GeneralStrMap option_names;
-    for (const auto& entry : maps.str_to_general_opt)
-        option_names.emplace(entry.second, entry.first);
 
     const QString configdir_path = paths::writableConfigDir() + QChar('/');
     const QString theme_path = AppSettings::general.theme.startsWith(configdir_path)
         ? AppSettings::general.theme.mid(configdir_path.length())
         : AppSettings::general.theme;
 
-    GeneralStrMap option_values {
+    const std::pair<GeneralOption, QString> option_values[] {
         { GeneralOption::FULLSCREEN, AppSettings::general.fullscreen ? STR_TRUE : STR_FALSE },
         { GeneralOption::MOUSE_SUPPORT, AppSettings::general.mouse_support ? STR_TRUE : STR_FALSE },
+        { GeneralOption::PREGEN_THUMBNAILS, AppSettings::general.pregen_thumbnails ? STR_TRUE : STR_FALSE },
+        { GeneralOption::STARTUP_HOOK_TIMEOUT, QString::number(AppSettings::general.startup_hook_timeout_ms) },
+        { GeneralOption::SCRIPT_TIMEOUT, QString::number(AppSettings::general.script_timeout_ms) },
         { GeneralOption::LOCALE, AppSettings::general.locale },
         { GeneralOption::THEME, theme_path },
     };
 
+    const QLatin1String category(category_name(ConfigEntryCategory::GENERAL));
     for (const auto& entry : option_values) {
         if (entry.second.isEmpty())
             continue;
 
-        stream << LINE_TEMPLATE.arg(
-            category_names.at(ConfigEntryCategory::GENERAL),
-            option_names.at(entry.first),
-            entry.second);
+        stream << category << '.' << QLatin1String(general_option_name(entry.first))
+               << ": " << entry.second << '\n';
     }
 }
 
 void SaveContext::print_providers(QTextStream& stream) const
 {
-    const QString TEMPLATE_KEY(QStringLiteral("%1.%2.%3:"));
+    const QLatin1String category(category_name(ConfigEntryCategory::PROVIDERS));
 
     for (const auto& entry : AppSettings::providers) {
         if (entry->flags() & providers::INTERNAL)
             continue;
 
-        stream << LINE_TEMPLATE.arg(
-            category_names.at(ConfigEntryCategory::PROVIDERS),
-            entry->codename() + QStringLiteral(".enabled"),
-            entry->enabled() ? STR_TRUE : STR_FALSE);
+        stream << category << '.' << entry->codename() << ".enabled: "
+               << (entry->enabled() ? STR_TRUE : STR_FALSE) << '\n';
 
         for (const auto& option : entry->options()) {
-            stream << TEMPLATE_KEY.arg(
-                    category_names.at(ConfigEntryCategory::PROVIDERS),
-                    entry->codename(),
-                    option.first);
+            stream << category << '.' << entry->codename() << '.' << option.first << ':';
 
             if (option.second.size() == 1) {
-                stream << QChar(' ') << option.second.front() << QChar('\n');
+                stream << ' ' << option.second.front() << '\n';
                 continue;
             }
 
-            stream << QChar('\n');
+            stream << '\n';
             for (const QString& val : option.second)
-                stream << QLatin1String("  ") << val << QChar('\n');
+                stream << QLatin1String("  ") << val << '\n';
         }
     }
 }
 
 void SaveContext::print_keys(QTextStream& stream) const
 {
-    for (const auto& entry : maps.str_to_key_opt) {
+    const QLatin1String category(category_name(ConfigEntryCategory::KEYS));
+
+    for (const KeyEvent key_event : CONFIG_KEY_EVENTS) {
         QStringList key_strs;
 
-        for (const QKeySequence& keyseq : AppSettings::keys.at(entry.second)) {
+        for (const QKeySequence& keyseq : AppSettings::keys.at(key_event)) {
             const auto btnname_it = AppSettings::gamepadButtonNames.find(keyseq);
             if (btnname_it != AppSettings::gamepadButtonNames.cend()) {
-                key_strs << QStringLiteral("Gamepad") + AppSettings::gamepadButtonNames.at(keyseq);
+                key_strs << QStringLiteral("Gamepad") + btnname_it->second;
                 continue;
             }
 
@@ -368,20 +602,9 @@ void SaveContext::print_keys(QTextStream& stream) const
         if (key_strs.isEmpty())
             key_strs << QStringLiteral("none");
 
-        stream << LINE_TEMPLATE.arg(
-            category_names.at(ConfigEntryCategory::KEYS),
-            entry.first,
-            key_strs.join(','));
+        stream << category << '.' << QLatin1String(key_event_name(key_event))
+               << ": " << key_strs.join(',') << '\n';
     }
 }
 
-HashMap<ConfigEntryCategory, QString, EnumHash> SaveContext::gen_category_names() const {
-    HashMap<ConfigEntryCategory, QString, EnumHash> result;
-
-    for (const auto& entry : maps.str_to_category)
-        result.emplace(entry.second, entry.first);
-
-    return result;
-}
-
-} // namespace appsettings
\ No newline at end of file
+} // namespace appsettings
@@ -18,13 +18,13 @@
 #pragma once
 
 #include "types/KeyEventType.h"
-#include "utils/HashMap.h"
 #include "utils/StrBoolConverter.h"
 
 #include <QString>
 #include <QStringList>
 #include <QTextStream>
 #include <map>
+#include <vector>
 
 
 namespace appsettings {
@@ -38,34 +38,27 @@ enum class ConfigEntryCategory : unsigned char {
 enum class ConfigEntryGeneralOption : unsigned char {
     FULLSCREEN,
     MOUSE_SUPPORT,
+    PREGEN_THUMBNAILS,
+    STARTUP_HOOK_TIMEOUT,
+    SCRIPT_TIMEOUT,
     LOCALE,
     THEME,
 };
 
-struct ConfigEntryMaps {
-    ConfigEntryMaps();
-
-    using Category = ConfigEntryCategory;
-    using GeneralOption = ConfigEntryGeneralOption;
-
-    const HashMap<QString, Category> str_to_category;
-    const HashMap<QString, GeneralOption> str_to_general_opt;
-    const HashMap<QString, KeyEvent> str_to_key_opt;
-};
-
 
 class SettingsFileContext {
 protected:
     SettingsFileContext();
+    explicit SettingsFileContext(QString config_path);
 
     const QString config_path;
-    const ConfigEntryMaps maps;
 };
 
 
 class LoadContext : public SettingsFileContext {
 public:
     LoadContext();
+    explicit LoadContext(QString config_path);
 
     void load() const;
 
@@ -73,16 +66,18 @@ private:
     void log_error(const size_t lineno, const QString& msg) const;
     void log_unknown_key(const size_t lineno, const QString& key) const;
     void log_needs_bool(const size_t lineno, const QString& key) const;
+    void log_needs_number(const size_t lineno, const QString& key) const;
 
 private:
+    void read_entries(const QString& text) const;
     void handle_entry(const size_t lineno, const QString& key, const std::vector<QString>& vals) const;
     void handle_general_attrib(const size_t lineno, const QString& key, const QString& val,
-                               QStringList& sections) const;
+                               const QStringRef& option) const;
     void handle_provider_attrib(const size_t lineno, const QString& key,
                                 const std::vector<QString>& vals,
-                                QStringList& sections) const;
+                                const QStringRef& sections) const;
     void handle_key_attrib(const size_t lineno, const QString& key, const QString& val,
-                           QStringList& sections) const;
+                           const QStringRef& option) const;
 
 private:
     const StrBoolConverter strconv;
@@ -93,6 +88,7 @@ private:
 class SaveContext : public SettingsFileContext {
 public:
     SaveContext();
+    explicit SaveContext(QString config_path);
 
     void save() const;
 
@@ -102,15 +98,8 @@ private:
     void print_keys(QTextStream& stream) const;
 
 private:
-    using CategoryStrMap = HashMap<ConfigEntryCategory, QString, EnumHash>;
-
     const QString STR_TRUE;
     const QString STR_FALSE;
-    const QString LINE_TEMPLATE;
-
-    const CategoryStrMap category_names;
-
-    CategoryStrMap gen_category_names() const;
 };
 
 } // namespace appsettings
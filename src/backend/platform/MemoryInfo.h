@@ -0,0 +1,31 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QtGlobal>
+
+
+namespace platform {
+/// Contains the platform-specific queries of the system memory state
+namespace memory {
+
+/// Returns the physical memory available for new allocations without
+/// swapping, in bytes, or -1 if it is not known on this platform
+qint64 available_bytes();
+
+} // namespace memory
+} // namespace platform
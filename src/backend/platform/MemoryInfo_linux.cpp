@@ -0,0 +1,47 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "MemoryInfo.h"
+
+#include <QFile>
+
+
+namespace platform {
+namespace memory {
+
+qint64 available_bytes()
+{
+    QFile file(QStringLiteral("/proc/meminfo"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    // eg. "MemAvailable:    1234567 kB", available since Linux 3.14
+    const QByteArray KEY = QByteArrayLiteral("MemAvailable:");
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (!line.startsWith(KEY))
+            continue;
+
+        bool ok = false;
+        const QByteArray value = line.mid(KEY.size()).trimmed().split(' ').constFirst();
+        const qint64 kbytes = value.toLongLong(&ok);
+        return ok ? kbytes * 1024 : -1;
+    }
+    return -1;
+}
+
+} // namespace memory
+} // namespace platform
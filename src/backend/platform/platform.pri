@@ -1,4 +1,5 @@
 HEADERS += \
+    $$PWD/MemoryInfo.h \
     $$PWD/PowerCommands.h \
     $$PWD/TerminalKbd.h \
 
@@ -7,12 +8,16 @@ SOURCES += \
 
 
 win32 {
-    SOURCES += $$PWD/PowerCommands_win.cpp
+    SOURCES += \
+        $$PWD/MemoryInfo_win.cpp \
+        $$PWD/PowerCommands_win.cpp
 }
 else:unix {
-    macx: SOURCES += $$PWD/PowerCommands_mac.cpp
-    else: SOURCES += $$PWD/PowerCommands_linux.cpp
+    macx: SOURCES += $$PWD/MemoryInfo_unimpl.cpp $$PWD/PowerCommands_mac.cpp
+    else: SOURCES += $$PWD/MemoryInfo_linux.cpp $$PWD/PowerCommands_linux.cpp
 }
 else {
-    SOURCES += $$PWD/PowerCommands_unimpl.cpp
-}
\ No newline at end of file
+    SOURCES += \
+        $$PWD/MemoryInfo_unimpl.cpp \
+        $$PWD/PowerCommands_unimpl.cpp
+}
@@ -0,0 +1,63 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "DynamicData.h"
+
+#include "model/gaming/Game.h"
+#include "utils/StdHelpers.h"
+
+
+namespace providers {
+
+void apply_dynamic_data(const DynamicData& data)
+{
+    for (model::Game* const game : data.favorites)
+        game->setFavorite(true);
+
+    for (model::Game* const game : data.whitelists)
+        game->setWhitelist(true);
+
+    // Every file change would make its game recalculate and re-announce
+    // its stats, so the files are updated quietly first, then each file
+    // announces its change while the games are muted, and finally each
+    // affected game refreshes only once
+    std::vector<model::GameFile*> affected_files;
+    affected_files.reserve(data.playstats.size());
+    for (const DynamicData::PlayStats& entry : data.playstats) {
+        Q_ASSERT(entry.gamefile);
+        entry.gamefile->add_playstats(entry.play_count, entry.play_time, entry.last_played);
+        affected_files.push_back(entry.gamefile);
+    }
+    VEC_REMOVE_DUPLICATES(affected_files);
+
+    std::vector<model::Game*> affected_games;
+    affected_games.reserve(affected_files.size());
+    for (model::GameFile* const gamefile : affected_files)
+        affected_games.push_back(static_cast<model::Game*>(gamefile->parent()));
+    VEC_REMOVE_DUPLICATES(affected_games);
+
+    for (model::Game* const game : affected_games)
+        game->blockSignals(true);
+    for (model::GameFile* const gamefile : affected_files)
+        emit gamefile->playStatsChanged();
+    for (model::Game* const game : affected_games) {
+        game->blockSignals(false);
+        game->refresh_playstats();
+    }
+}
+
+} // namespace providers
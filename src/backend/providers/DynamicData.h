@@ -0,0 +1,48 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QDateTime>
+#include <vector>
+
+namespace model { class Game; }
+namespace model { class GameFile; }
+
+
+namespace providers {
+
+/// The results of the dynamic data search. The providers fill this on
+/// a worker thread, without touching the (already QML-bound) model objects;
+/// the changes are then applied on the main thread in one pass.
+struct DynamicData {
+    struct PlayStats {
+        model::GameFile* gamefile;
+        int play_count;
+        qint64 play_time;
+        QDateTime last_played;
+    };
+
+    std::vector<model::Game*> favorites;
+    std::vector<model::Game*> whitelists;
+    std::vector<PlayStats> playstats;
+};
+
+/// Must be called on the thread of the games
+void apply_dynamic_data(const DynamicData&);
+
+} // namespace providers
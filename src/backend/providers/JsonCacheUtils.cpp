@@ -19,31 +19,462 @@
 
 #include "Paths.h"
 #include "LocaleUtils.h"
+#include "utils/HashMap.h"
 
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
 #include <QStringBuilder>
+#include <QtEndian>
+#include <memory>
 
 
 namespace {
-QString cached_json_path(const QString& provider_prefix,
-                         const QString& provider_dir,
-                         const QString& entryname)
+// file header: magic, format version
+constexpr char FILE_MAGIC[8] = { 'J', 'S', 'F', 'C', 'A', 'C', 'H', 'E' };
+constexpr quint32 FILE_VERSION = 1;
+constexpr qint64 FILE_HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(quint32);
+// record header: type, key length, value length
+constexpr qint64 RECORD_HEADER_SIZE = 1 + sizeof(quint32) + sizeof(quint32);
+// the file is compacted when the overwritten records are at least this large,
+// and also larger than the live ones
+constexpr qint64 COMPACT_MIN_WASTE = 256 * 1024;
+
+enum class RecordType : quint8 {
+    JSON_TEXT = 1,
+    JSON_CBOR = 2,
+    REMOVED = 3,
+};
+
+struct Slot {
+    qint64 offset; // of the value
+    quint32 length;
+    RecordType type;
+};
+
+qint64 record_size(const QByteArray& key_utf8, quint32 value_len)
 {
-    Q_ASSERT(!paths::writableCacheDir().isEmpty()); // according to the Qt docs
+    return RECORD_HEADER_SIZE + key_utf8.size() + value_len;
+}
 
-    const QString cache_path = paths::writableCacheDir() % '/' % provider_dir;
+void append_u32(QByteArray& out, quint32 val)
+{
+    char buf[sizeof(quint32)];
+    qToLittleEndian(val, buf);
+    out.append(buf, sizeof(buf));
+}
 
+QByteArray file_header()
+{
+    QByteArray header(FILE_MAGIC, sizeof(FILE_MAGIC));
+    append_u32(header, FILE_VERSION);
+    return header;
+}
+
+QByteArray make_record(RecordType type, const QByteArray& key_utf8, const QByteArray& value)
+{
+    QByteArray record;
+    record.reserve(static_cast<int>(record_size(key_utf8, static_cast<quint32>(value.size()))));
+    record.append(static_cast<char>(type));
+    append_u32(record, static_cast<quint32>(key_utf8.size()));
+    append_u32(record, static_cast<quint32>(value.size()));
+    record.append(key_utf8);
+    record.append(value);
+    return record;
+}
+
+QJsonDocument decode(RecordType type, const QByteArray& bytes, QString& error)
+{
+    if (type == RecordType::JSON_CBOR) {
+        QCborParserError parse_result {};
+        const QCborValue value = QCborValue::fromCbor(bytes, &parse_result);
+        if (parse_result.error != QCborError::NoError) {
+            error = parse_result.errorString();
+            return {};
+        }
+        if (value.isMap())
+            return QJsonDocument(value.toMap().toJsonObject());
+        if (value.isArray())
+            return QJsonDocument(value.toArray().toJsonArray());
+
+        error = QStringLiteral("not an object or array");
+        return {};
+    }
+
+    QJsonParseError parse_result {};
+    QJsonDocument json = QJsonDocument::fromJson(bytes, &parse_result);
+    if (parse_result.error != QJsonParseError::NoError) {
+        error = parse_result.errorString();
+        return {};
+    }
+    return json;
+}
+
+
+class CacheFile {
+public:
+    CacheFile(QString log_prefix, QString dir_path);
+    ~CacheFile();
+
+    bool open();
+    bool put(const QString& key, RecordType type, const QByteArray& value);
+    QJsonDocument read(const QString& key);
+    void remove(const QString& key);
+
+private:
+    const QString m_log_prefix;
+    const QString m_dir_path;
+    const QString m_file_path;
+
+    QMutex m_guard;
+    QFile m_file;
+    uchar* m_map;
+    qint64 m_map_size;
+    HashMap<QString, Slot> m_index;
+    qint64 m_live_bytes;
+    qint64 m_waste_bytes;
+
+    bool reset_file();
+    bool load_index();
+    bool needs_compaction() const;
+    void compact();
+    void remap();
+    void unmap();
+    QByteArray value_at(const Slot&);
+    bool append(RecordType, const QString&, const QByteArray&);
+    void forget(const QString& key, const Slot& slot);
+};
+
+CacheFile::CacheFile(QString log_prefix, QString dir_path)
+    : m_log_prefix(std::move(log_prefix))
+    , m_dir_path(std::move(dir_path))
+    , m_file_path(m_dir_path % QLatin1String("/entries.jsoncache"))
+    , m_map(nullptr)
+    , m_map_size(0)
+    , m_live_bytes(0)
+    , m_waste_bytes(0)
+{}
+
+CacheFile::~CacheFile()
+{
+    unmap();
+}
+
+bool CacheFile::open()
+{
     // NOTE: mkpath() returns true if the dir already exists
-    QDir cache_dir(cache_path);
-    if (!cache_dir.mkpath(QStringLiteral("."))) {
+    if (!QDir(m_dir_path).mkpath(QStringLiteral("."))) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("could not create cache directory `%1`").arg(m_dir_path);
+        return false;
+    }
+
+    m_file.setFileName(m_file_path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("could not open cache file `%1`").arg(m_file_path);
+        return false;
+    }
+
+    const QByteArray header = m_file.read(FILE_HEADER_SIZE);
+    if (header != file_header() && !reset_file())
+        return false;
+
+    if (!load_index())
+        return false;
+
+    if (needs_compaction())
+        compact();
+
+    return true;
+}
+
+bool CacheFile::reset_file()
+{
+    unmap();
+
+    const QByteArray header = file_header();
+    if (!m_file.resize(0) || !m_file.seek(0) || m_file.write(header) != header.size()) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("could not create cache file `%1`").arg(m_file_path);
+        return false;
+    }
+    return true;
+}
+
+bool CacheFile::load_index()
+{
+    m_index.clear();
+    m_live_bytes = 0;
+    m_waste_bytes = 0;
+
+    remap();
+    const qint64 file_size = m_file.size();
+    if (!m_map && file_size > FILE_HEADER_SIZE) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("could not map cache file `%1`, the cache is cleared").arg(m_file_path);
+        return reset_file();
+    }
+
+    qint64 pos = FILE_HEADER_SIZE;
+    while (pos + RECORD_HEADER_SIZE <= file_size) {
+        const uchar* const record = m_map + pos;
+        const auto type = static_cast<RecordType>(record[0]);
+        const quint32 key_len = qFromLittleEndian<quint32>(record + 1);
+        const quint32 value_len = qFromLittleEndian<quint32>(record + 1 + sizeof(quint32));
+
+        const bool valid_type = type == RecordType::JSON_TEXT
+            || type == RecordType::JSON_CBOR
+            || type == RecordType::REMOVED;
+        const qint64 end = pos + RECORD_HEADER_SIZE + key_len + value_len;
+        if (!valid_type || key_len == 0 || file_size < end)
+            break;
+
+        const QString key = QString::fromUtf8(reinterpret_cast<const char*>(record + RECORD_HEADER_SIZE),
+                                              static_cast<int>(key_len));
+        const auto it = m_index.find(key);
+        if (it != m_index.cend()) {
+            forget(key, it->second);
+            m_index.erase(it);
+        }
+
+        if (type == RecordType::REMOVED) {
+            m_waste_bytes += end - pos;
+        }
+        else {
+            m_index.emplace(key, Slot { pos + RECORD_HEADER_SIZE + key_len, value_len, type });
+            m_live_bytes += end - pos;
+        }
+        pos = end;
+    }
+
+    // a partially written record at the end is dropped
+    if (pos < file_size) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("cache file `%1` is damaged after offset %2, the rest is dropped")
+                .arg(m_file_path, QString::number(pos));
+        unmap();
+        if (!m_file.resize(pos))
+            return false;
+    }
+
+    return true;
+}
+
+bool CacheFile::needs_compaction() const
+{
+    return m_waste_bytes >= COMPACT_MIN_WASTE && m_waste_bytes > m_live_bytes;
+}
+
+void CacheFile::compact()
+{
+    QSaveFile out_file(m_file_path);
+    if (!out_file.open(QIODevice::WriteOnly))
+        return;
+
+    HashMap<QString, Slot> new_index;
+    new_index.reserve(m_index.size());
+
+    QByteArray out_bytes = file_header();
+    for (const auto& entry : m_index) {
+        const QByteArray key_utf8 = entry.first.toUtf8();
+        const QByteArray value = value_at(entry.second);
+        const qint64 offset = out_bytes.size() + RECORD_HEADER_SIZE + key_utf8.size();
+        out_bytes.append(make_record(entry.second.type, key_utf8, value));
+        new_index.emplace(entry.first, Slot { offset, entry.second.length, entry.second.type });
+    }
+
+    // the old file has to be released before it can be replaced on some platforms
+    unmap();
+    m_file.close();
+
+    const bool success = out_file.write(out_bytes) == out_bytes.size() && out_file.commit();
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        m_index.clear();
+        return;
+    }
+    if (!success) {
+        remap();
+        return;
+    }
+
+    qInfo().noquote()
+        << m_log_prefix
+        << tr_log("compacted cache file `%1`, %2 KiB freed")
+            .arg(m_file_path, QString::number(m_waste_bytes / 1024));
+
+    m_index.swap(new_index);
+    m_waste_bytes = 0;
+    remap();
+}
+
+void CacheFile::unmap()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+
+    m_map = nullptr;
+    m_map_size = 0;
+}
+
+void CacheFile::remap()
+{
+    unmap();
+
+    const qint64 file_size = m_file.size();
+    if (file_size <= 0)
+        return;
+
+    m_map = m_file.map(0, file_size);
+    if (m_map)
+        m_map_size = file_size;
+}
+
+QByteArray CacheFile::value_at(const Slot& slot)
+{
+    // the records written since the last mapping are not visible yet
+    if (m_map_size < slot.offset + slot.length)
+        remap();
+
+    if (m_map) {
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(m_map + slot.offset),
+                                       static_cast<int>(slot.length));
+    }
+
+    // without a mapping, fall back to reading the file
+    if (!m_file.seek(slot.offset))
+        return {};
+    return m_file.read(slot.length);
+}
+
+bool CacheFile::append(RecordType type, const QString& key, const QByteArray& value)
+{
+    const QByteArray key_utf8 = key.toUtf8();
+    const QByteArray record = make_record(type, key_utf8, value);
+
+    const qint64 pos = m_file.size();
+    if (!m_file.seek(pos) || m_file.write(record) != record.size()) {
+        qWarning().noquote()
+            << m_log_prefix
+            << tr_log("writing cache file `%1` failed").arg(m_file_path);
+        unmap();
+        m_file.resize(pos);
+        return false;
+    }
+
+    const auto it = m_index.find(key);
+    if (it != m_index.cend()) {
+        forget(key, it->second);
+        m_index.erase(it);
+    }
+
+    if (type == RecordType::REMOVED) {
+        m_waste_bytes += record.size();
+    }
+    else {
+        m_index.emplace(key, Slot { pos + RECORD_HEADER_SIZE + key_utf8.size(), static_cast<quint32>(value.size()), type });
+        m_live_bytes += record.size();
+    }
+
+    // in long sessions the overwritten entries could pile up otherwise
+    if (needs_compaction())
+        compact();
+
+    return true;
+}
+
+void CacheFile::forget(const QString& key, const Slot& slot)
+{
+    const qint64 size = record_size(key.toUtf8(), slot.length);
+    m_live_bytes -= size;
+    m_waste_bytes += size;
+}
+
+bool CacheFile::put(const QString& key, RecordType type, const QByteArray& value)
+{
+    Q_ASSERT(type != RecordType::REMOVED);
+
+    const QMutexLocker lock(&m_guard);
+    return append(type, key, value);
+}
+
+QJsonDocument CacheFile::read(const QString& key)
+{
+    const QMutexLocker lock(&m_guard);
+
+    const auto it = m_index.find(key);
+    if (it == m_index.cend())
+        return {};
+
+    // the raw data points into the mapping, which stays in place while locked
+    QString error;
+    QJsonDocument json = decode(it->second.type, value_at(it->second), error);
+    if (!error.isEmpty()) {
         qWarning().noquote()
-            << provider_prefix
-            << tr_log("could not create cache directory `%1`").arg(cache_path);
-        return QString();
+            << m_log_prefix
+            << tr_log("could not parse cached entry `%1` in `%2`").arg(key, m_file_path)
+            << error;
+        append(RecordType::REMOVED, key, {});
+        return {};
     }
 
-    return cache_path % QLatin1Char('/') % entryname % QLatin1String(".json");
+    return json;
+}
+
+void CacheFile::remove(const QString& key)
+{
+    const QMutexLocker lock(&m_guard);
+
+    if (m_index.count(key))
+        append(RecordType::REMOVED, key, {});
+}
+
+
+QString provider_cache_dir(const QString& provider_dir)
+{
+    Q_ASSERT(!paths::writableCacheDir().isEmpty()); // according to the Qt docs
+    return paths::writableCacheDir() % '/' % provider_dir;
+}
+
+// Returns the cache file of the provider, or null if it could not be opened
+CacheFile* cache_file_for(const QString& provider_prefix, const QString& provider_dir)
+{
+    static QMutex guard;
+    static HashMap<QString, std::unique_ptr<CacheFile>> files;
+
+    const QMutexLocker lock(&guard);
+
+    const auto it = files.find(provider_dir);
+    if (it != files.cend())
+        return it->second.get();
+
+    // a failed open is not retried
+    std::unique_ptr<CacheFile> file(new CacheFile(provider_prefix, provider_cache_dir(provider_dir)));
+    if (!file->open())
+        file.reset();
+
+    CacheFile* const result = file.get();
+    files.emplace(provider_dir, std::move(file));
+    return result;
+}
+
+// Entries cached by older versions are stored as separate files
+QString legacy_json_path(const QString& provider_dir, const QString& entryname)
+{
+    return provider_cache_dir(provider_dir) % QLatin1Char('/') % entryname % QLatin1String(".json");
 }
 } // namespace
 
@@ -55,21 +486,32 @@ void cache_json(const QString& provider_prefix,
                 const QString& entryname,
                 const QByteArray& bytes)
 {
-    const QString json_path = cached_json_path(provider_prefix, provider_dir, entryname);
+    CacheFile* const cache = cache_file_for(provider_prefix, provider_dir);
+    if (cache)
+        cache->put(entryname, RecordType::JSON_TEXT, bytes);
+}
 
-    QFile json_file(json_path);
-    if (!json_file.open(QIODevice::WriteOnly)) {
-        qWarning().noquote()
-            << provider_prefix
-            << tr_log("could not create cache file `%1`").arg(json_path);
+void cache_json(const QString& provider_prefix,
+                const QString& provider_dir,
+                const QString& entryname,
+                const QJsonDocument& json,
+                JsonCacheFormat format)
+{
+    CacheFile* const cache = cache_file_for(provider_prefix, provider_dir);
+    if (!cache)
         return;
-    }
 
-    if (json_file.write(bytes) != bytes.length()) {
-        qWarning().noquote()
-            << provider_prefix
-            << tr_log("writing cache file `%1` failed").arg(json_path);
-        json_file.remove();
+    switch (format) {
+        case JsonCacheFormat::TEXT:
+            cache->put(entryname, RecordType::JSON_TEXT, json.toJson(QJsonDocument::Compact));
+            break;
+        case JsonCacheFormat::CBOR: {
+            const QCborValue cbor = json.isArray()
+                ? QCborValue(QCborArray::fromJsonArray(json.array()))
+                : QCborValue(QCborMap::fromJsonObject(json.object()));
+            cache->put(entryname, RecordType::JSON_CBOR, cbor.toCbor());
+            break;
+        }
     }
 }
 
@@ -77,33 +519,39 @@ QJsonDocument read_json_from_cache(const QString& provider_prefix,
                                    const QString& provider_dir,
                                    const QString& entryname)
 {
-    const QString json_path = cached_json_path(provider_prefix, provider_dir, entryname);
+    CacheFile* const cache = cache_file_for(provider_prefix, provider_dir);
+    if (!cache)
+        return {};
 
-    QFile json_file(json_path);
-    if (!json_file.open(QIODevice::ReadOnly))
+    QJsonDocument json = cache->read(entryname);
+    if (!json.isNull())
+        return json;
+
+    // move the entry over from the old storage, if there's one
+    const QString legacy_path = legacy_json_path(provider_dir, entryname);
+    if (!QFileInfo::exists(legacy_path))
         return {};
 
-    QJsonParseError parse_result {};
-    auto json = QJsonDocument::fromJson(json_file.readAll(), &parse_result);
-    if (parse_result.error != QJsonParseError::NoError) {
-        qWarning().noquote()
-            << provider_prefix
-            << tr_log("could not parse cached file `%1`").arg(json_path)
-            << parse_result.errorString();
-        json_file.remove();
+    QFile legacy_file(legacy_path);
+    if (!legacy_file.open(QIODevice::ReadOnly))
         return {};
-    }
 
-    return json;
+    const QByteArray bytes = legacy_file.readAll();
+    legacy_file.remove();
+
+    cache->put(entryname, RecordType::JSON_TEXT, bytes);
+    return cache->read(entryname);
 }
 
 void delete_cached_json(const QString& provider_prefix,
                         const QString& provider_dir,
                         const QString& entryname)
 {
-    const QString json_path = cached_json_path(provider_prefix, provider_dir, entryname);
+    CacheFile* const cache = cache_file_for(provider_prefix, provider_dir);
+    if (cache)
+        cache->remove(entryname);
 
-    QFile::remove(json_path);
+    QFile::remove(legacy_json_path(provider_dir, entryname));
 }
 
 } // namespace providers
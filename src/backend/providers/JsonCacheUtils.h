@@ -23,10 +23,28 @@
 
 namespace providers {
 
+/// The encoding of a cached entry
+enum class JsonCacheFormat : unsigned char {
+    TEXT,
+    CBOR,
+};
+
+// The cached entries of a provider are stored together in a single,
+// append-only file under the cache dir, which is memory mapped for reading.
+// The file is compacted when the overwritten entries take up most of it,
+// checked when it's opened and after every write.
+
+/// Stores the JSON text as is
 void cache_json(const QString& provider_prefix,
                 const QString& provider_dir,
                 const QString& entryname,
                 const QByteArray& bytes);
+/// Stores the document in the selected format
+void cache_json(const QString& provider_prefix,
+                const QString& provider_dir,
+                const QString& entryname,
+                const QJsonDocument& json,
+                JsonCacheFormat format = JsonCacheFormat::CBOR);
 QJsonDocument read_json_from_cache(const QString& provider_prefix,
                                    const QString& provider_dir,
                                    const QString& entryname);
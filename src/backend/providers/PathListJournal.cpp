@@ -0,0 +1,345 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "PathListJournal.h"
+
+#include "AppSettings.h"
+#include "LocaleUtils.h"
+#include "Paths.h"
+#include "model/gaming/Game.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrent>
+
+
+namespace {
+// the changes of quick repeated presses are saved together
+static constexpr int FLUSH_DELAY_MS = 1000;
+// the journal is folded into the list after this many changes
+static constexpr int COMPACT_LIMIT = 256;
+
+QString written_path(const QString& full_path)
+{
+    return AppSettings::general.portable
+        ? QDir(paths::writableConfigDir()).relativeFilePath(full_path)
+        : full_path;
+}
+
+QString resolved_path(const QString& written)
+{
+    return QFileInfo(paths::writableConfigDir(), written).canonicalFilePath();
+}
+} // namespace
+
+
+namespace providers {
+
+PathListJournal::PathListJournal(QString log_prefix, QString file_header, QObject* parent)
+    : QObject(parent)
+    , m_log_prefix(std::move(log_prefix))
+    , m_file_header(std::move(file_header))
+    , m_journal_line_cnt(0)
+    , m_processing(false)
+{
+    m_flush_timer.setSingleShot(true);
+    m_flush_timer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flush_timer, &QTimer::timeout,
+            this, &PathListJournal::flush);
+}
+
+PathListJournal::~PathListJournal()
+{
+    save();
+}
+
+void PathListJournal::setFilePath(QString path)
+{
+    m_file_path = std::move(path);
+}
+
+QString PathListJournal::journal_path() const
+{
+    return m_file_path + QStringLiteral(".journal");
+}
+
+void PathListJournal::apply_line(const QString& line)
+{
+    const QString path = resolved_path(line.mid(1));
+    if (path.isEmpty())
+        return;
+
+    if (line.at(0) == QLatin1Char('+'))
+        m_paths.insert(path);
+    else if (line.at(0) == QLatin1Char('-'))
+        m_paths.remove(path);
+}
+
+void PathListJournal::load()
+{
+    const QMutexLocker lock(&m_data_guard);
+
+    m_paths.clear();
+    m_journal_line_cnt = 0;
+
+    if (QFileInfo::exists(m_file_path)) {
+        QFile list_file(m_file_path);
+        if (list_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream stream(&list_file);
+            QString line;
+            while (stream.readLineInto(&line)) {
+                if (line.isEmpty() || line.startsWith('#'))
+                    continue;
+
+                QString path = resolved_path(line);
+                if (!path.isEmpty())
+                    m_paths.insert(std::move(path));
+            }
+        }
+        else {
+            qWarning().noquote() << m_log_prefix
+                << tr_log("could not open `%1` for reading").arg(m_file_path);
+        }
+    }
+
+    QFile journal_file(journal_path());
+    if (journal_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&journal_file);
+        QString line;
+        while (stream.readLineInto(&line)) {
+            if (line.size() < 2)
+                continue;
+
+            m_journal_line_cnt++;
+            apply_line(line);
+        }
+    }
+
+    // changes not yet written out still count
+    for (const QString& line : qAsConst(m_unsaved_lines))
+        apply_line(line);
+}
+
+bool PathListJournal::setGame(const model::Game& game, bool included)
+{
+    const QMutexLocker lock(&m_data_guard);
+    bool changed = false;
+
+    for (const model::GameFile* const file : game.filesConst()) {
+        const QString full_path = file->fileinfo().canonicalFilePath();
+        if (Q_UNLIKELY(full_path.isEmpty()))
+            continue;
+
+        if (included == m_paths.contains(full_path))
+            continue;
+
+        if (included)
+            m_paths.insert(full_path);
+        else
+            m_paths.remove(full_path);
+
+        const QChar op = included ? QLatin1Char('+') : QLatin1Char('-');
+        m_unsaved_lines << (op + written_path(full_path));
+        changed = true;
+    }
+
+    if (changed) {
+        m_flush_timer.start();
+
+        // the pending changes are also saved if the app quits in the meantime
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                this, &PathListJournal::save, Qt::UniqueConnection);
+    }
+
+    return changed;
+}
+
+QStringList PathListJournal::list_lines() const
+{
+    QStringList lines;
+    lines.reserve(m_paths.size());
+    for (const QString& path : m_paths)
+        lines << written_path(path);
+
+    lines.sort();
+    lines.prepend(m_file_header);
+    return lines;
+}
+
+PathListJournal::WriteTask PathListJournal::take_unsaved_lines()
+{
+    WriteTask task;
+    task.file_path = m_file_path;
+    task.rewrite = false;
+
+    task.folded_line_cnt = 0;
+
+    // the counter is only reset once the new list is written
+    m_journal_line_cnt += m_unsaved_lines.size();
+    if (m_journal_line_cnt > COMPACT_LIMIT) {
+        task.rewrite = true;
+        task.list_lines = list_lines();
+        task.folded_line_cnt = m_journal_line_cnt;
+    }
+    task.journal_lines.swap(m_unsaved_lines);
+    return task;
+}
+
+void PathListJournal::finish_task(const WriteTask& task, bool list_rewritten)
+{
+    // the lines added since the task was made are still in the journal
+    if (list_rewritten)
+        m_journal_line_cnt = qMax(0, m_journal_line_cnt - task.folded_line_cnt);
+}
+
+void PathListJournal::flush()
+{
+    const QMutexLocker data_lock(&m_data_guard);
+    if (m_unsaved_lines.isEmpty() || m_file_path.isEmpty())
+        return;
+
+    WriteTask task = take_unsaved_lines();
+
+    QMutexLocker lock(&m_task_guard);
+    m_pending_tasks.push_back(std::move(task));
+    if (!m_processing) {
+        m_processing = true;
+        start_processing();
+    }
+}
+
+void PathListJournal::save()
+{
+    m_flush_timer.stop();
+    m_future.waitForFinished();
+
+    // NOTE: written on the calling thread, as this may run after
+    // the thread pool is gone
+    const QMutexLocker lock(&m_data_guard);
+    if (m_unsaved_lines.isEmpty() || m_file_path.isEmpty())
+        return;
+
+    const WriteTask task = take_unsaved_lines();
+    finish_task(task, run_task(task));
+}
+
+void PathListJournal::compact()
+{
+    m_flush_timer.stop();
+    m_future.waitForFinished();
+
+    const QMutexLocker lock(&m_data_guard);
+
+    // nothing to fold into the list
+    if (m_file_path.isEmpty() || (m_journal_line_cnt == 0 && m_unsaved_lines.isEmpty()))
+        return;
+
+    WriteTask task;
+    task.file_path = m_file_path;
+    task.rewrite = true;
+    task.list_lines = list_lines();
+    task.journal_lines.swap(m_unsaved_lines);
+    // if the list can't be written, the changes go to the journal
+    m_journal_line_cnt += task.journal_lines.size();
+    task.folded_line_cnt = m_journal_line_cnt;
+
+    finish_task(task, run_task(task));
+}
+
+void PathListJournal::start_processing()
+{
+    m_future = QtConcurrent::run([this]{
+        emit startedWriting();
+
+        while (true) {
+            std::vector<WriteTask> tasks;
+            {
+                QMutexLocker lock(&m_task_guard);
+                if (m_pending_tasks.empty()) {
+                    m_processing = false;
+                    break;
+                }
+                tasks.swap(m_pending_tasks);
+            }
+
+            for (const WriteTask& task : tasks) {
+                const bool list_rewritten = run_task(task);
+
+                const QMutexLocker data_lock(&m_data_guard);
+                finish_task(task, list_rewritten);
+            }
+        }
+
+        emit finishedWriting();
+    });
+}
+
+bool PathListJournal::run_task(const WriteTask& task)
+{
+    const QString journal_file_path = task.file_path + QStringLiteral(".journal");
+
+    if (task.rewrite) {
+        if (rewrite_list(task)) {
+            // the journal is only removed once the new list is in place
+            QFile::remove(journal_file_path);
+            return true;
+        }
+
+        // the old list and the journal are still valid, the changes are
+        // kept by appending them as usual
+        qWarning().noquote() << m_log_prefix
+            << tr_log("could not write `%1`, the changes are kept in the journal")
+                      .arg(task.file_path);
+    }
+
+    if (task.journal_lines.isEmpty())
+        return false;
+
+    QFile journal_file(journal_file_path);
+    if (!journal_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning().noquote() << m_log_prefix
+            << tr_log("could not open `%1` for writing, changes are not saved")
+                      .arg(journal_file_path);
+        return false;
+    }
+
+    QTextStream stream(&journal_file);
+    for (const QString& line : task.journal_lines)
+        stream << line << '\n';
+    return false;
+}
+
+bool PathListJournal::rewrite_list(const WriteTask& task)
+{
+    QSaveFile list_file(task.file_path);
+    if (!list_file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&list_file);
+    for (const QString& line : task.list_lines)
+        stream << line << '\n';
+    stream.flush();
+
+    return list_file.commit();
+}
+
+} // namespace providers
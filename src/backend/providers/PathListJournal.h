@@ -0,0 +1,108 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QFuture>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <vector>
+
+namespace model { class Game; }
+
+
+namespace providers {
+
+/// A persistent set of game file paths, as used by the favorites and
+/// whitelists.
+///
+/// The set itself is kept in memory. The file on the disk is a plain list of
+/// paths, one per line; changes are appended to a `<file>.journal` next to it
+/// (`+path` or `-path` per line), which is folded back into the list when it
+/// gets long, or when `compact()` is called. Writes are debounced and done
+/// on a worker thread.
+class PathListJournal : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PathListJournal(QString log_prefix, QString file_header, QObject* parent = nullptr);
+    ~PathListJournal();
+
+    void setFilePath(QString);
+    const QString& filePath() const { return m_file_path; }
+
+    /// Reads the list and replays the journal; call before using the set
+    void load();
+    const QSet<QString>& paths() const { return m_paths; }
+
+    /// Adds or removes the files of the game; returns true if this was a change
+    bool setGame(const model::Game&, bool included);
+
+    /// Saves every pending change and rewrites the list, synchronously
+    void compact();
+
+public slots:
+    /// Saves the pending changes synchronously, without waiting for the timer
+    void save();
+
+signals:
+    void startedWriting();
+    void finishedWriting();
+
+private slots:
+    void flush();
+
+private:
+    const QString m_log_prefix;
+    const QString m_file_header;
+    QString m_file_path;
+
+    // the list is loaded on the scanner thread, while a flush may be running
+    QMutex m_data_guard;
+    QSet<QString> m_paths;
+    QStringList m_unsaved_lines;
+    int m_journal_line_cnt;
+    QTimer m_flush_timer;
+
+    struct WriteTask {
+        QString file_path;
+        QStringList journal_lines;
+        bool rewrite;
+        QStringList list_lines;
+        // the journal lines the new list includes
+        int folded_line_cnt;
+    };
+    std::vector<WriteTask> m_pending_tasks;
+    bool m_processing;
+    QMutex m_task_guard;
+    QFuture<void> m_future;
+
+    QString journal_path() const;
+    QStringList list_lines() const;
+    WriteTask take_unsaved_lines();
+    void apply_line(const QString&);
+    /// Returns true if the list was rewritten
+    bool run_task(const WriteTask&);
+    bool rewrite_list(const WriteTask&);
+    void finish_task(const WriteTask&, bool list_rewritten);
+    void start_processing();
+};
+
+} // namespace providers
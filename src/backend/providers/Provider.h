@@ -29,6 +29,7 @@ namespace model { class Collection; }
 namespace model { class Game; }
 namespace model { class GameFile; }
 namespace providers { class SearchContext; }
+namespace providers { struct DynamicData; }
 
 
 namespace providers {
@@ -62,15 +63,18 @@ public:
     virtual Provider& findStaticData(SearchContext&) { return *this; }
 
     /// Initialization third stage:
-    /// Find data that may change during the runtime for all games
+    /// Find data that may change during the runtime for all games.
+    /// Runs on a worker thread: the results should be collected into the
+    /// DynamicData, instead of modifying the games directly.
     virtual Provider& findDynamicData(const QVector<model::Collection*>&,
                                       const QVector<model::Game*>&,
-                                      const HashMap<QString, model::GameFile*>&) { return *this; }
+                                      const HashMap<QString, model::GameFile*>&,
+                                      DynamicData&) { return *this; }
 
 
     // events
-    virtual void onGameFavoriteChanged(const QVector<model::Game*>&) {}
-    virtual void onGameWhitelistChanged(const QVector<model::Game*>&) {}
+    virtual void onGameFavoriteChanged(model::Game* const) {}
+    virtual void onGameWhitelistChanged(model::Game* const) {}
     virtual void onGameLaunched(model::GameFile* const) {}
     virtual void onGameFinished(model::GameFile* const) {}
 
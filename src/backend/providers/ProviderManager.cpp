@@ -21,9 +21,11 @@
 #include "LocaleUtils.h"
 #include "SearchContext.h"
 #include "model/gaming/Collection.h"
+#include "model/gaming/Facets.h"
 #include "model/gaming/Game.h"
 #include "utils/HashMap.h"
 #include "utils/StdHelpers.h"
+#include "utils/Tracing.h"
 
 #include <QDebug>
 #include <QtConcurrent/QtConcurrent>
@@ -45,6 +47,8 @@ std::vector<ProviderPtr> enabled_providers()
 
 void postprocess_list_results(providers::SearchContext& sctx)
 {
+    const tracing::Span span("SearchContext::finalize_lists");
+
     QElapsedTimer timer;
     timer.start();
 
@@ -62,7 +66,10 @@ void run_list_providers(providers::SearchContext& ctx, const std::vector<Provide
         if (!(ptr->flags() & providers::PROVIDES_GAMES))
             continue;
 
+        tracing::Span span(ptr->name(), QLatin1String(": findLists"));
         ptr->findLists(ctx);
+        span.end();
+
         qInfo().noquote() << tr_log("%1: finished game searching in %2ms")
             .arg(ptr->name(), QString::number(timer.restart()));
     }
@@ -76,7 +83,10 @@ void run_asset_providers(providers::SearchContext& sctx, const std::vector<Provi
         if (!(provider->flags() & providers::PROVIDES_ASSETS))
             continue;
 
+        tracing::Span span(provider->name(), QLatin1String(": findStaticData"));
         provider->findStaticData(sctx);
+        span.end();
+
         qInfo().noquote() << tr_log("%1: finished asset searching in %2ms")
             .arg(provider->name(), QString::number(timer.restart()));
     }
@@ -106,6 +116,8 @@ HashMap<QString, model::GameFile*> build_path_map(const QVector<model::Game*>& g
 std::tuple<QVector<model::Collection*>, QVector<model::Game*>>
 prepare_output(providers::SearchContext& sctx, QThread* const target_thread)
 {
+    const tracing::Span span("SearchContext::consume");
+
     QVector<model::Collection*> collections;
     QVector<model::Game*> games;
     std::tie(collections, games) = sctx.consume();
@@ -122,28 +134,37 @@ prepare_output(providers::SearchContext& sctx, QThread* const target_thread)
 
 ProviderManager::ProviderManager(QObject* parent)
     : QObject(parent)
+    , m_applying_dynamic_data(false)
 {
     for (const auto& provider : AppSettings::providers) {
         connect(provider.get(), &providers::Provider::gameCountChanged,
                 this, &ProviderManager::gameCountChanged);
     }
+
+    // the results of the worker are applied on the main thread
+    connect(this, &ProviderManager::dynamicDataFound,
+            this, &ProviderManager::onDynamicDataFound,
+            Qt::QueuedConnection);
 }
 
 void ProviderManager::startStaticSearch(
     QVector<model::Collection*>& out_collections,
-    QVector<model::Game*>& out_games)
+    QVector<model::Game*>& out_games,
+    model::FacetIndex& out_facets)
 {
     Q_ASSERT(!m_future.isRunning());
 
-    m_future = QtConcurrent::run([this, &out_collections, &out_games]{
+    m_future = QtConcurrent::run([this, &out_collections, &out_games, &out_facets]{
         providers::SearchContext ctx;
 
         QElapsedTimer timer;
         timer.start();
 
         const std::vector<ProviderPtr> providers = enabled_providers();
-        for (const auto& provider : providers)
+        for (const auto& provider : providers) {
+            const tracing::Span span(provider->name(), QLatin1String(": load"));
             provider->load();
+        }
 
         run_list_providers(ctx, providers);
         postprocess_list_results(ctx); // TODO: C++17
@@ -155,9 +176,13 @@ void ProviderManager::startStaticSearch(
         QVector<model::Collection*> collections;
         QVector<model::Game*> games;
         std::tie(collections, games) = prepare_output(ctx, this->thread());
+        tracing::Span facets_span("build_facet_index");
+        model::FacetIndex facets = model::build_facet_index(games);
+        facets_span.end();
 
         std::swap(collections, out_collections);
         std::swap(games, out_games);
+        std::swap(facets, out_facets);
         emit staticDataReady();
     });
 }
@@ -168,33 +193,56 @@ void ProviderManager::startDynamicSearch(const QVector<model::Game*>& games,
     Q_ASSERT(!m_future.isRunning());
 
     m_future = QtConcurrent::run([this, &games, &collections]{
+        const tracing::Span span("ProviderManager: dynamic data search");
+
         QElapsedTimer timer;
         timer.start();
 
+        providers::DynamicData data;
         const HashMap<QString, model::GameFile*> path_map = build_path_map(games);
         for (const auto& provider : AppSettings::providers)
-            provider->findDynamicData(collections, games, path_map);
+            provider->findDynamicData(collections, games, path_map, data);
 
-        emit dynamicDataReady(timer.elapsed());
+        m_dynamic_data = std::move(data);
+        emit dynamicDataFound(timer.elapsed());
     });
 }
 
-void ProviderManager::onGameFavoriteChanged(const QVector<model::Game*>& all_games)
+void ProviderManager::onDynamicDataFound(qint64 search_time)
 {
-    if (m_future.isRunning())
+    tracing::Span span("ProviderManager: applying dynamic data");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    providers::DynamicData data;
+    std::swap(data, m_dynamic_data);
+
+    // applying the data should not trigger saving it again
+    m_applying_dynamic_data = true;
+    providers::apply_dynamic_data(data);
+    m_applying_dynamic_data = false;
+    span.end();
+
+    emit dynamicDataReady(search_time + timer.elapsed());
+}
+
+void ProviderManager::onGameFavoriteChanged(model::Game* const game)
+{
+    if (m_future.isRunning() || m_applying_dynamic_data)
         return;
 
     for (const auto& provider : AppSettings::providers)
-        provider->onGameFavoriteChanged(all_games);
+        provider->onGameFavoriteChanged(game);
 }
 
-void ProviderManager::onGameWhitelistChanged(const QVector<model::Game*>& all_games)
+void ProviderManager::onGameWhitelistChanged(model::Game* const game)
 {
-    if (m_future.isRunning())
+    if (m_future.isRunning() || m_applying_dynamic_data)
         return;
 
     for (const auto& provider : AppSettings::providers)
-        provider->onGameWhitelistChanged(all_games);
+        provider->onGameWhitelistChanged(game);
 }
 
 void ProviderManager::onGameLaunched(model::GameFile* const game)
@@ -214,3 +262,11 @@ void ProviderManager::onGameFinished(model::GameFile* const game)
     for (const auto& provider : AppSettings::providers)
         provider->onGameFinished(game);
 }
+
+void ProviderManager::unloadProviders()
+{
+    m_future.waitForFinished();
+
+    for (const auto& provider : AppSettings::providers)
+        provider->unload();
+}
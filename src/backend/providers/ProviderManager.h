@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "DynamicData.h"
 #include "Provider.h"
 
 #include <QObject>
@@ -26,6 +27,7 @@
 
 namespace model { class Collection; }
 namespace model { class Game; }
+namespace model { struct FacetIndex; }
 
 
 class ProviderManager : public QObject {
@@ -34,13 +36,14 @@ class ProviderManager : public QObject {
 public:
     explicit ProviderManager(QObject* parent);
 
-    void startStaticSearch(QVector<model::Collection*>&, QVector<model::Game*>&);
+    void startStaticSearch(QVector<model::Collection*>&, QVector<model::Game*>&, model::FacetIndex&);
     void startDynamicSearch(const QVector<model::Game*>&, const QVector<model::Collection*>&);
 
     void onGameLaunched(model::GameFile* const);
     void onGameFinished(model::GameFile* const);
-    void onGameFavoriteChanged(const QVector<model::Game*>&);
-    void onGameWhitelistChanged(const QVector<model::Game*>&);    
+    void onGameFavoriteChanged(model::Game* const);
+    void onGameWhitelistChanged(model::Game* const);
+    void unloadProviders();
 
 signals:
     void gameCountChanged(int);
@@ -51,6 +54,15 @@ signals:
     void staticDataReady();
     void dynamicDataReady(qint64);
 
+    // internal
+    void dynamicDataFound(qint64);
+
+private slots:
+    void onDynamicDataFound(qint64);
+
 private:
     QFuture<void> m_future;
+
+    providers::DynamicData m_dynamic_data;
+    bool m_applying_dynamic_data;
 };
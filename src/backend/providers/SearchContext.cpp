@@ -19,8 +19,51 @@
 
 #include "LocaleUtils.h"
 #include "model/gaming/Game.h"
+#include "utils/CommandTemplate.h"
 #include "utils/StdHelpers.h"
 
+#include <QDebug>
+
+
+namespace {
+using TemplatePtr = std::shared_ptr<const utils::CommandTemplate>;
+
+TemplatePtr cached_template(
+    HashMap<QString, TemplatePtr>& cache,
+    const QString& text,
+    utils::CommandTemplate (*parse)(const QString&))
+{
+    const auto it = cache.find(text);
+    if (it != cache.cend())
+        return it->second;
+
+    TemplatePtr result = std::make_shared<const utils::CommandTemplate>(parse(text));
+    if (!result->unknownPlaceholders().isEmpty()) {
+        qWarning().noquote()
+            << tr_log("The launch parameter `%1` contains unsupported placeholders (%2), they will be used as they are")
+                      .arg(text, result->unknownPlaceholders().join(QLatin1String(", ")));
+    }
+
+    cache.emplace(text, result);
+    return result;
+}
+
+void prepare_launch_templates(const HashMap<size_t, providers::PendingGame>& games)
+{
+    // most games of a collection share the same command
+    HashMap<QString, TemplatePtr> cmd_cache;
+    HashMap<QString, TemplatePtr> workdir_cache;
+
+    for (const auto& entry : games) {
+        model::Game& game = entry.second.inner();
+        game.setLaunchCmdTemplate(
+            cached_template(cmd_cache, game.launchCmd(), &utils::CommandTemplate::fromCommand));
+        game.setLaunchWorkdirTemplate(
+            cached_template(workdir_cache, game.launchWorkdir(), &utils::CommandTemplate::fromText));
+    }
+}
+} // namespace
+
 
 namespace providers {
 PendingGame::PendingGame(size_t id, model::Game* ptr)
@@ -206,6 +249,7 @@ SearchContext& SearchContext::finalize_lists()
         entry.second.inner().setGames(std::move(games));
     }
 
+    prepare_launch_templates(m_games);
     return *this;
 }
 
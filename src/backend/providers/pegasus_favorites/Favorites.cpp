@@ -17,16 +17,10 @@
 
 #include "Favorites.h"
 
-#include "AppSettings.h"
-#include "LocaleUtils.h"
 #include "Paths.h"
 #include "model/gaming/Game.h"
-
-#include <QDebug>
-#include <QFile>
-#include <QFileInfo>
-#include <QTextStream>
-#include <QtConcurrent/QtConcurrent>
+#include "providers/DynamicData.h"
+#include "utils/StdHelpers.h"
 
 
 namespace {
@@ -44,108 +38,50 @@ namespace favorites {
 
 Favorites::Favorites(QObject* parent)
     : Provider(QLatin1String("pegasus_favorites"), QStringLiteral("Favorites"), INTERNAL | PROVIDES_DYNDATA, parent)
-{}
+    , m_db(QLatin1String(MSG_PREFIX), QStringLiteral("# List of favorites, one path per line"))
+{
+    connect(&m_db, &PathListJournal::startedWriting,
+            this, &Favorites::startedWriting);
+    connect(&m_db, &PathListJournal::finishedWriting,
+            this, &Favorites::finishedWriting);
+}
 
 Provider& Favorites::load() {
     return load_with_dbpath(default_db_path());
 }
 Provider& Favorites::load_with_dbpath(QString db_path) {
-    m_db_path = std::move(db_path);
+    m_db.setFilePath(std::move(db_path));
     return *this;
 }
 Provider& Favorites::unload() {
-    m_db_path.clear();
+    // saves the pending changes too
+    m_db.compact();
+    m_db.setFilePath(QString());
     return *this;
 }
 
 Provider& Favorites::findDynamicData(const QVector<model::Collection*>&,
                                      const QVector<model::Game*>&,
-                                     const HashMap<QString, model::GameFile*>& path_map)
+                                     const HashMap<QString, model::GameFile*>& path_map,
+                                     DynamicData& out_data)
 {
-    if (!QFileInfo::exists(m_db_path))
-        return *this;
+    m_db.load();
 
-    QFile db_file(m_db_path);
-    if (!db_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning().noquote() << MSG_PREFIX
-            << tr_log("could not open `%1` for reading, favorites are not loaded.")
-                      .arg(m_db_path);
-        return *this;
-    }
-
-    QTextStream db_stream(&db_file);
-    QString line;
-    while (db_stream.readLineInto(&line)) {
-        if (line.startsWith('#'))
-            continue;
-
-        const QString path = QFileInfo(paths::writableConfigDir(), line).canonicalFilePath();
-        if (path_map.count(path)) {
-            model::Game* const parent = static_cast<model::Game*>(path_map.at(path)->parent());
-            parent->setFavorite(true);
-        }
+    for (const QString& path : m_db.paths()) {
+        const auto it = path_map.find(path);
+        if (it != path_map.cend())
+            out_data.favorites.push_back(static_cast<model::Game*>(it->second->parent()));
     }
 
+    VEC_REMOVE_DUPLICATES(out_data.favorites);
     return *this;
 }
 
-void Favorites::onGameFavoriteChanged(const QVector<model::Game*>& game_list)
-{
-    const QMutexLocker lock(&m_task_guard);
-    const QDir config_dir(paths::writableConfigDir());
-
-    m_pending_task.clear();
-    m_pending_task << QStringLiteral("# List of favorites, one path per line");
-    for (const model::Game* const game : game_list) {
-        if (game->isFavorite()) {
-            for (const model::GameFile* const file : game->filesConst()) {
-                const QString full_path = file->fileinfo().canonicalFilePath();
-                const QString written_path = AppSettings::general.portable
-                    ? config_dir.relativeFilePath(full_path)
-                    : full_path;
-                if (Q_LIKELY(!written_path.isEmpty()))
-                    m_pending_task << written_path;
-            }
-        }
-    }
-
-    if (m_active_task.isEmpty())
-        start_processing();
-}
-
-void Favorites::start_processing()
+void Favorites::onGameFavoriteChanged(model::Game* const game)
 {
-    m_active_task = m_pending_task;
-    m_pending_task.clear();
-
-    QtConcurrent::run([this]{
-        emit startedWriting();
-
-        while (true) {
-            QFile db_file(m_db_path);
-            if (!db_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                qWarning().noquote() << MSG_PREFIX
-                    << tr_log("could not open `%1` for writing, favorites are not saved.")
-                              .arg(m_db_path);
-                break;
-            }
-
-            QTextStream db_stream(&db_file);
-            for (const QString& fav : qAsConst(m_active_task))
-                db_stream << fav << endl;
-
-            QMutexLocker lock(&m_task_guard);
-            m_active_task.clear();
-            if (m_pending_task.isEmpty())
-                break;
-
-            m_active_task = m_pending_task;
-            m_pending_task.clear();
-        }
-
-        emit finishedWriting();
-    });
+    Q_ASSERT(game);
+    m_db.setGame(*game, game->isFavorite());
 }
 
 } // namespace favorites
-} // namespace providers
\ No newline at end of file
+} // namespace providers
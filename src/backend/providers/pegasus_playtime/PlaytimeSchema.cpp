@@ -0,0 +1,144 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "PlaytimeSchema.h"
+
+#include "LocaleUtils.h"
+#include "utils/SqliteDb.h"
+
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+
+
+namespace {
+static constexpr auto MSG_PREFIX = "Playtime:";
+
+bool exec_schema_query(SqliteDb& channel, const QString& sql)
+{
+    QSqlQuery query(channel.handle());
+    if (!query.exec(sql)) {
+        qWarning().noquote() << MSG_PREFIX << tr_log("failed to create database tables");
+        providers::playtime::print_query_error(query);
+        return false;
+    }
+    return true;
+}
+
+bool create_paths_table(SqliteDb& channel)
+{
+    return exec_schema_query(channel, QStringLiteral(
+        "CREATE TABLE paths"
+          "(" "id INTEGER PRIMARY KEY"
+          "," "path TEXT UNIQUE NOT NULL"
+        ");"
+    ));
+}
+
+bool create_plays_table(SqliteDb& channel)
+{
+    return exec_schema_query(channel, QStringLiteral(
+        "CREATE TABLE plays"
+          "(" "id INTEGER PRIMARY KEY"
+          "," "path_id INTEGER NOT NULL REFERENCES plays(id)"
+          "," "start_time INTEGER NOT NULL"
+          "," "duration INTEGER NOT NULL"
+        ");"
+    ));
+}
+
+// The summary is kept up to date by a trigger, so it is always
+// updated in the same transaction as the play entry itself
+bool create_summary_table(SqliteDb& channel)
+{
+    return exec_schema_query(channel, QStringLiteral(
+            "CREATE TABLE play_summary"
+              "(" "path_id INTEGER PRIMARY KEY REFERENCES paths(id)"
+              "," "play_count INTEGER NOT NULL"
+              "," "play_time INTEGER NOT NULL"
+              "," "last_played INTEGER NOT NULL"
+            ");"
+        ))
+        && exec_schema_query(channel, QStringLiteral(
+            "CREATE TRIGGER IF NOT EXISTS plays_update_summary"
+            " AFTER INSERT ON plays"
+            " BEGIN"
+              " INSERT OR IGNORE INTO play_summary VALUES(NEW.path_id, 0, 0, 0);"
+              " UPDATE play_summary SET"
+                " play_count = play_count + 1,"
+                " play_time = play_time + MAX(NEW.duration, 0),"
+                " last_played = MAX(last_played, NEW.start_time + NEW.duration)"
+              " WHERE path_id = NEW.path_id;"
+            " END;"
+        ));
+}
+
+bool fill_summary_table(SqliteDb& channel)
+{
+    return exec_schema_query(channel, QStringLiteral(
+        "INSERT INTO play_summary"
+        " SELECT path_id, COUNT(*), SUM(MAX(duration, 0)), MAX(start_time + duration)"
+        " FROM plays"
+        " GROUP BY path_id;"
+    ));
+}
+} // namespace
+
+
+namespace providers {
+namespace playtime {
+
+void print_query_error(const QSqlQuery& query)
+{
+    const auto error = query.lastError();
+    if (error.isValid())
+        qWarning().noquote() << error.text();
+}
+
+bool ensure_schema(SqliteDb& channel)
+{
+    const bool has_paths = channel.hasTable(QStringLiteral("paths"));
+    const bool has_plays = channel.hasTable(QStringLiteral("plays"));
+    const bool has_summary = channel.hasTable(QStringLiteral("play_summary"));
+    if (has_paths && has_plays && has_summary)
+        return true;
+
+    channel.startTransaction();
+
+    bool success = true;
+    if (success && !has_paths)
+        success = create_paths_table(channel);
+    if (success && !has_plays)
+        success = create_plays_table(channel);
+    if (success && !has_summary) {
+        success = create_summary_table(channel);
+        if (success && has_plays) {
+            qInfo().noquote() << MSG_PREFIX << tr_log("upgrading the database, this may take a moment");
+            success = fill_summary_table(channel);
+        }
+    }
+
+    if (success)
+        channel.commit();
+    else
+        channel.rollback();
+
+    return success;
+}
+
+} // namespace playtime
+} // namespace providers
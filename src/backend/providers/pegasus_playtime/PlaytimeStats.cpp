@@ -17,17 +17,18 @@
 
 #include "PlaytimeStats.h"
 
+#include "PlaytimeSchema.h"
+#include "PlaytimeWriter.h"
 #include "LocaleUtils.h"
 #include "Paths.h"
 #include "model/gaming/Game.h"
+#include "providers/DynamicData.h"
 #include "utils/SqliteDb.h"
 
 #include <QDebug>
 #include <QFileInfo>
 #include <QSqlDatabase>
-#include <QSqlError>
 #include <QSqlQuery>
-#include <QtConcurrent/QtConcurrent>
 
 
 namespace {
@@ -38,105 +39,6 @@ QString default_db_path()
     return paths::writableConfigDir() + QStringLiteral("/stats.db");
 }
 
-void print_query_error(const QSqlQuery& query)
-{
-    const auto error = query.lastError();
-    if (error.isValid())
-        qWarning().noquote() << error.text();
-}
-
-void on_create_table_fail(QSqlQuery& query)
-{
-    qWarning().noquote() << MSG_PREFIX << tr_log("failed to create database tables");
-    print_query_error(query);
-}
-
-bool create_missing_tables(SqliteDb& channel)
-{
-    if (!channel.hasTable(QStringLiteral("paths"))) {
-        QSqlQuery query;
-        query.prepare(QStringLiteral(
-            "CREATE TABLE paths"
-              "(" "id INTEGER PRIMARY KEY"
-              "," "path TEXT UNIQUE NOT NULL"
-            ");"
-        ));
-        if (!query.exec()) {
-            on_create_table_fail(query);
-            return false;
-        }
-    }
-    if (!channel.hasTable(QStringLiteral("plays"))) {
-        QSqlQuery query;
-        query.prepare(QStringLiteral(
-            "CREATE TABLE plays"
-              "(" "id INTEGER PRIMARY KEY"
-              "," "path_id INTEGER NOT NULL REFERENCES plays(id)"
-              "," "start_time INTEGER NOT NULL"
-              "," "duration INTEGER NOT NULL"
-            ");"
-        ));
-        if (!query.exec()) {
-            on_create_table_fail(query);
-            return false;
-        }
-    }
-
-    return true;
-}
-
-int get_path_id(const QString& game_key)
-{
-    {
-        QSqlQuery query;
-        query.prepare(QStringLiteral("SELECT id FROM paths WHERE path = ?;"));
-        query.addBindValue(game_key);
-        if (!query.exec()) {
-            print_query_error(query);
-            return -1;
-        }
-        if (query.next())
-            return query.value(0).toInt();
-    }
-    // no hit -> insert
-    {
-        QSqlQuery query;
-        query.prepare(QStringLiteral("INSERT INTO paths VALUES(null, ?);"));
-        query.addBindValue(game_key);
-        if (!query.exec()) {
-            print_query_error(query);
-            return -1;
-        }
-    }
-    {
-        QSqlQuery query;
-        query.prepare(QStringLiteral("SELECT last_insert_rowid() FROM paths;"));
-        if (!query.exec()) {
-            print_query_error(query);
-            return -1;
-        }
-        if (query.next())
-            return query.value(0).toInt();
-    }
-
-    return -1;
-}
-
-void save_play_entry(const int path_id, const QDateTime& start_time, const qint64 duration)
-{
-    Q_ASSERT(path_id != -1);
-    Q_ASSERT(start_time.isValid());
-    Q_ASSERT(0 <= duration);
-
-    QSqlQuery query;
-    query.prepare(QStringLiteral("INSERT INTO plays VALUES(null, ?, ?, ?);"));
-    query.addBindValue(path_id);
-    query.addBindValue(start_time.toSecsSinceEpoch());
-    query.addBindValue(duration);
-    if (!query.exec())
-        print_query_error(query);
-}
-
 void update_modelgame(model::GameFile* const gamefile, const QDateTime& start_time, const qint64 duration)
 {
     Q_ASSERT(gamefile);
@@ -151,7 +53,35 @@ namespace playtime {
 
 PlaytimeStats::PlaytimeStats(QObject* parent)
     : Provider(QLatin1String("pegasus_playtime"), QStringLiteral("Playtime"), INTERNAL | PROVIDES_DYNDATA, parent)
-{}
+    , m_writer(new PlaytimeWriter())
+{
+    m_writer->moveToThread(&m_writer_thread);
+    connect(&m_writer_thread, &QThread::finished,
+            m_writer, &QObject::deleteLater);
+
+    connect(m_writer, &PlaytimeWriter::startedWriting,
+            this, &PlaytimeStats::startedWriting);
+    connect(m_writer, &PlaytimeWriter::finishedWriting,
+            this, &PlaytimeStats::finishedWriting);
+
+    // NOTE: the providers are created during static initialization,
+    // the thread is started when the first entry arrives
+    m_writer_thread.setObjectName(QStringLiteral("PlaytimeWriter"));
+}
+
+PlaytimeStats::~PlaytimeStats()
+{
+    if (!m_writer_thread.isRunning()) {
+        // nothing was played, the thread's `finished` would never delete it
+        delete m_writer;
+        return;
+    }
+
+    // lets the writer finish the queued entries
+    m_writer->flush();
+    m_writer_thread.quit();
+    m_writer_thread.wait();
+}
 
 Provider& PlaytimeStats::load() {
     return load_with_dbpath(default_db_path());
@@ -161,13 +91,18 @@ Provider& PlaytimeStats::load_with_dbpath(QString db_path) {
     return *this;
 }
 Provider& PlaytimeStats::unload() {
+    // saves the pending entries too
+    if (m_writer_thread.isRunning())
+        m_writer->flush();
+
     m_db_path.clear();
     return *this;
 }
 
 Provider& PlaytimeStats::findDynamicData(const QVector<model::Collection*>&,
                                          const QVector<model::Game*>&,
-                                         const HashMap<QString, model::GameFile*>& path_map)
+                                         const HashMap<QString, model::GameFile*>& path_map,
+                                         DynamicData& out_data)
 {
     if (!QFileInfo::exists(m_db_path))
         return *this;
@@ -182,44 +117,43 @@ Provider& PlaytimeStats::findDynamicData(const QVector<model::Collection*>&,
     // No entries yet
     if (!channel.hasTable(QStringLiteral("paths")) || !channel.hasTable(QStringLiteral("plays")))
         return *this;
+    // Databases of older versions only have the play entries; if the summary
+    // cannot be added (eg. the file is read-only or locked), the play entries
+    // are summed up on the fly instead
+    const bool has_summary = ensure_schema(channel);
 
 
     QSqlQuery query;
-    query.prepare(QStringLiteral(
-        "SELECT paths.path, plays.start_time, plays.duration"
-        " FROM plays"
-        " INNER JOIN paths ON plays.path_id=paths.id;"
-    ));
+    query.prepare(has_summary
+        ? QStringLiteral(
+            "SELECT paths.path, play_summary.play_count, play_summary.play_time, play_summary.last_played"
+            " FROM play_summary"
+            " INNER JOIN paths ON play_summary.path_id=paths.id;")
+        : QStringLiteral(
+            "SELECT paths.path, COUNT(*), SUM(MAX(plays.duration, 0)), MAX(plays.start_time + plays.duration)"
+            " FROM plays"
+            " INNER JOIN paths ON plays.path_id=paths.id"
+            " GROUP BY plays.path_id;"));
     if (!query.exec()) {
         print_query_error(query);
         return *this;
     }
 
-    struct Stats {
-        int playcount { 0 };
-        qint64 playtime { 0 };
-        QDateTime last_played;
-    };
-    HashMap<QString, Stats> stat_map;
-
     while (query.next()) {
         const QString path = query.value(0).toString();
-        if (!path_map.count(path))
+        const auto it = path_map.find(path);
+        if (it == path_map.cend())
             continue;
 
-        const qint64 start_epoch = query.value(1).toLongLong();
-        const qint64 duration = query.value(2).toLongLong();
-
-        Stats& stats = stat_map[path];
-        stats.last_played = QDateTime::fromSecsSinceEpoch(start_epoch + duration);
-        stats.playtime += std::max(static_cast<qint64>(0), duration);
-        stats.playcount++;
-    }
-    // trigger update only once
-    for (const auto& pair : stat_map) {
-        model::GameFile* gamefile = path_map.at(pair.first);
-        const Stats& stats = stat_map.at(pair.first);
-        gamefile->update_playstats(stats.playcount, stats.playtime, stats.last_played);
+        const int playcount = query.value(1).toInt();
+        const qint64 playtime = query.value(2).toLongLong();
+        const qint64 last_played_epoch = query.value(3).toLongLong();
+        out_data.playstats.push_back({
+            it->second,
+            playcount,
+            playtime,
+            QDateTime::fromSecsSinceEpoch(last_played_epoch),
+        });
     }
 
     return *this;
@@ -236,66 +170,19 @@ void PlaytimeStats::onGameFinished(model::GameFile* const gamefile)
     Q_ASSERT(gamefile);
     Q_ASSERT(m_last_launch_time.isValid());
 
-    QMutexLocker lock(&m_queue_guard);
-
     const auto now = QDateTime::currentDateTimeUtc();
     const auto duration = m_last_launch_time.secsTo(now);
 
-    m_pending_tasks.emplace_back(
-        gamefile,
-        m_last_launch_time,
-        duration
-    );
-
-    if (m_active_tasks.empty())
-        start_processing();
-}
-
-void PlaytimeStats::start_processing()
-{
-    Q_ASSERT(m_active_tasks.empty());
-
-    m_active_tasks.swap(m_pending_tasks);
-
-    QtConcurrent::run([this]{
-        emit startedWriting();
-
-        while (!m_active_tasks.empty()) {
-            for (const QueueEntry& entry : m_active_tasks)
-                update_modelgame(entry.gamefile, entry.launch_time, entry.duration);
-
-            SqliteDb channel(m_db_path);
-            if (!channel.open()) {
-                qWarning().noquote() << MSG_PREFIX
-                    << tr_log("Could not open or create `%1`, play time will not be saved")
-                              .arg(m_db_path);
-                break;
-            }
+    // the model is updated right away, only the database write is deferred
+    update_modelgame(gamefile, m_last_launch_time, duration);
 
-            channel.startTransaction();
-
-            if (!create_missing_tables(channel)) {
-                channel.rollback();
-                break;
-            }
-
-            for (const QueueEntry& entry : m_active_tasks) {
-                const QString path = entry.gamefile->fileinfo().canonicalFilePath();
-                const int path_id = get_path_id(path);
-                if (path_id >= 0)
-                    save_play_entry(path_id, entry.launch_time, entry.duration);
-            }
-
-            channel.commit();
-
-            // pick up new tasks
-            QMutexLocker lock(&m_queue_guard);
-            m_active_tasks.clear();
-            m_active_tasks.swap(m_pending_tasks);
-        }
-
-        emit finishedWriting();
-    });
+    if (!m_writer_thread.isRunning())
+        m_writer_thread.start(QThread::LowPriority);
+    m_writer->enqueue(
+        m_db_path,
+        gamefile->fileinfo().canonicalFilePath(),
+        m_last_launch_time,
+        duration);
 }
 
 } // namespace playtime
@@ -20,17 +20,21 @@
 #include "providers/Provider.h"
 
 #include <QDateTime>
-#include <QMutex>
+#include <QThread>
 
 
 namespace providers {
 namespace playtime {
 
+class PlaytimeWriter;
+
+
 class PlaytimeStats : public Provider {
     Q_OBJECT
 
 public:
     explicit PlaytimeStats(QObject* parent = nullptr);
+    ~PlaytimeStats();
 
     Provider& load() final;
     Provider& unload() final;
@@ -38,7 +42,8 @@ public:
 
     Provider& findDynamicData(const QVector<model::Collection*>&,
                               const QVector<model::Game*>&,
-                              const HashMap<QString, model::GameFile*>&) final;
+                              const HashMap<QString, model::GameFile*>&,
+                              DynamicData&) final;
     void onGameLaunched(model::GameFile* const) final;
     void onGameFinished(model::GameFile* const) final;
 
@@ -51,23 +56,9 @@ private:
 
     QDateTime m_last_launch_time;
 
-    struct QueueEntry {
-        model::GameFile* const gamefile;
-        const QDateTime launch_time;
-        const qint64 duration;
-
-        QueueEntry(model::GameFile* const gamefile, QDateTime launch_time, qint64 duration)
-            : gamefile(std::move(gamefile))
-            , launch_time(std::move(launch_time))
-            , duration(std::move(duration))
-        {}
-    };
-    std::vector<QueueEntry> m_pending_tasks;
-    std::vector<QueueEntry> m_active_tasks;
-    QMutex m_queue_guard;
-
-    void start_processing();
+    QThread m_writer_thread;
+    PlaytimeWriter* const m_writer;
 };
 
 } // namespace playtime
-} // namespace providers
\ No newline at end of file
+} // namespace providers
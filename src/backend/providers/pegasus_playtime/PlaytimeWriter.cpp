@@ -0,0 +1,308 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "PlaytimeWriter.h"
+
+#include "PlaytimeSchema.h"
+#include "LocaleUtils.h"
+#include "utils/SqliteDb.h"
+
+#include <QDebug>
+#include <QSqlQuery>
+#include <QThread>
+
+
+namespace {
+static constexpr auto MSG_PREFIX = "Playtime:";
+
+bool exec_pragma(QSqlDatabase& db, const QString& pragma)
+{
+    QSqlQuery query(db);
+    if (!query.exec(pragma)) {
+        providers::playtime::print_query_error(query);
+        return false;
+    }
+    return true;
+}
+
+// `RETURNING` is available since SQLite 3.35
+bool supports_returning(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    if (!query.exec(QStringLiteral("SELECT sqlite_version();")) || !query.next())
+        return false;
+
+    const QStringList parts = query.value(0).toString().split(QLatin1Char('.'));
+    if (parts.size() < 2)
+        return false;
+
+    const int major = parts.at(0).toInt();
+    const int minor = parts.at(1).toInt();
+    return major > 3 || (major == 3 && minor >= 35);
+}
+} // namespace
+
+
+namespace providers {
+namespace playtime {
+
+PlaytimeWriter::PlaytimeWriter(QObject* parent)
+    : QObject(parent)
+    , m_write_scheduled(false)
+    , m_has_returning(false)
+{}
+
+PlaytimeWriter::~PlaytimeWriter()
+{
+    close_db();
+}
+
+void PlaytimeWriter::enqueue(QString db_path, QString game_path, QDateTime start_time, qint64 duration)
+{
+    QMutexLocker lock(&m_queue_guard);
+
+    m_pending_tasks.push_back({
+        std::move(db_path),
+        std::move(game_path),
+        std::move(start_time),
+        duration,
+    });
+
+    if (!m_write_scheduled) {
+        m_write_scheduled = true;
+        QMetaObject::invokeMethod(this, "processQueue", Qt::QueuedConnection);
+    }
+}
+
+void PlaytimeWriter::flush()
+{
+    Q_ASSERT(QThread::currentThread() != thread());
+    QMetaObject::invokeMethod(this, "processQueue", Qt::BlockingQueuedConnection);
+}
+
+void PlaytimeWriter::processQueue()
+{
+    {
+        // already written by an earlier call
+        QMutexLocker lock(&m_queue_guard);
+        if (m_pending_tasks.empty()) {
+            m_write_scheduled = false;
+            return;
+        }
+    }
+
+    emit startedWriting();
+
+    while (true) {
+        std::vector<QueueEntry> batch;
+        {
+            QMutexLocker lock(&m_queue_guard);
+            if (m_pending_tasks.empty()) {
+                m_write_scheduled = false;
+                break;
+            }
+            batch.swap(m_pending_tasks);
+        }
+        write_batch(batch);
+    }
+
+    emit finishedWriting();
+}
+
+void PlaytimeWriter::write_batch(const std::vector<QueueEntry>& batch)
+{
+    bool in_transaction = false;
+    // the ids of the paths added in the current transaction
+    std::vector<QString> new_paths;
+
+    for (const QueueEntry& entry : batch) {
+        if (!m_db || entry.db_path != m_db_path) {
+            if (in_transaction) {
+                commit_batch(new_paths);
+                in_transaction = false;
+            }
+            if (!open_db(entry.db_path)) {
+                qWarning().noquote() << MSG_PREFIX
+                    << tr_log("Could not open or create `%1`, play time will not be saved")
+                              .arg(entry.db_path);
+                continue;
+            }
+        }
+        if (!in_transaction)
+            in_transaction = m_db->startTransaction();
+
+        const bool path_known = m_path_ids.find(entry.game_path) != m_path_ids.cend();
+        const qint64 path_id = get_path_id(entry.game_path);
+        if (path_id < 0)
+            continue;
+
+        if (!path_known)
+            new_paths.push_back(entry.game_path);
+
+        // a failed insert may have been rolled back together with the path
+        if (!save_play_entry(path_id, entry.start_time, entry.duration) && !path_known) {
+            m_path_ids.erase(entry.game_path);
+            new_paths.pop_back();
+        }
+    }
+
+    if (in_transaction)
+        commit_batch(new_paths);
+}
+
+void PlaytimeWriter::commit_batch(std::vector<QString>& new_paths)
+{
+    Q_ASSERT(m_db);
+
+    // the paths added in a failed transaction do not exist in the database
+    if (!m_db->commit()) {
+        qWarning().noquote() << MSG_PREFIX
+            << tr_log("Failed to save the play time entries to `%1`").arg(m_db_path);
+        m_db->rollback();
+        for (const QString& path : new_paths)
+            m_path_ids.erase(path);
+    }
+    new_paths.clear();
+}
+
+bool PlaytimeWriter::open_db(const QString& db_path)
+{
+    close_db();
+
+    const QString connection_name = QStringLiteral("playtime_writer_%1")
+        .arg(reinterpret_cast<quintptr>(this), 0, 16);
+    m_db.reset(new SqliteDb(db_path, connection_name));
+    if (!m_db->open()) {
+        m_db.reset();
+        return false;
+    }
+
+    // WAL lets the startup reader run in parallel with the writes,
+    // and with it a sync per transaction commit is not needed
+    exec_pragma(m_db->handle(), QStringLiteral("PRAGMA journal_mode=WAL;"));
+    exec_pragma(m_db->handle(), QStringLiteral("PRAGMA synchronous=NORMAL;"));
+
+    if (!ensure_schema(*m_db) || !prepare_queries()) {
+        close_db();
+        return false;
+    }
+
+    m_db_path = db_path;
+    return true;
+}
+
+void PlaytimeWriter::close_db()
+{
+    // the queries have to be gone before the connection is removed
+    m_query_upsert_path.reset();
+    m_query_select_path.reset();
+    m_query_insert_play.reset();
+    m_db.reset();
+
+    m_db_path.clear();
+    m_path_ids.clear();
+}
+
+bool PlaytimeWriter::prepare_queries()
+{
+    QSqlDatabase& db = m_db->handle();
+    m_has_returning = supports_returning(db);
+
+    m_query_upsert_path.reset(new QSqlQuery(db));
+    const bool upsert_ok = m_has_returning
+        ? m_query_upsert_path->prepare(QStringLiteral(
+            "INSERT INTO paths(path) VALUES(?)"
+            " ON CONFLICT(path) DO UPDATE SET path=excluded.path"
+            " RETURNING id;"))
+        : m_query_upsert_path->prepare(QStringLiteral(
+            "INSERT OR IGNORE INTO paths(path) VALUES(?);"));
+    if (!upsert_ok) {
+        print_query_error(*m_query_upsert_path);
+        return false;
+    }
+
+    m_query_select_path.reset(new QSqlQuery(db));
+    if (!m_query_select_path->prepare(QStringLiteral("SELECT id FROM paths WHERE path = ?;"))) {
+        print_query_error(*m_query_select_path);
+        return false;
+    }
+
+    m_query_insert_play.reset(new QSqlQuery(db));
+    if (!m_query_insert_play->prepare(QStringLiteral("INSERT INTO plays VALUES(null, ?, ?, ?);"))) {
+        print_query_error(*m_query_insert_play);
+        return false;
+    }
+
+    return true;
+}
+
+qint64 PlaytimeWriter::get_path_id(const QString& game_path)
+{
+    const auto it = m_path_ids.find(game_path);
+    if (it != m_path_ids.cend())
+        return it->second;
+
+    qint64 path_id = -1;
+
+    QSqlQuery& upsert = *m_query_upsert_path;
+    upsert.addBindValue(game_path);
+    if (!upsert.exec()) {
+        print_query_error(upsert);
+        return -1;
+    }
+    if (m_has_returning) {
+        if (upsert.next())
+            path_id = upsert.value(0).toLongLong();
+        upsert.finish();
+    }
+    else {
+        QSqlQuery& select = *m_query_select_path;
+        select.addBindValue(game_path);
+        if (!select.exec()) {
+            print_query_error(select);
+            return -1;
+        }
+        if (select.next())
+            path_id = select.value(0).toLongLong();
+        select.finish();
+    }
+
+    if (path_id >= 0)
+        m_path_ids.emplace(game_path, path_id);
+
+    return path_id;
+}
+
+bool PlaytimeWriter::save_play_entry(qint64 path_id, const QDateTime& start_time, qint64 duration)
+{
+    Q_ASSERT(path_id >= 0);
+    Q_ASSERT(start_time.isValid());
+    Q_ASSERT(0 <= duration);
+
+    QSqlQuery& query = *m_query_insert_play;
+    query.addBindValue(path_id);
+    query.addBindValue(start_time.toSecsSinceEpoch());
+    query.addBindValue(duration);
+    if (!query.exec()) {
+        print_query_error(query);
+        return false;
+    }
+    return true;
+}
+
+} // namespace playtime
+} // namespace providers
@@ -0,0 +1,90 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "utils/HashMap.h"
+
+#include <QDateTime>
+#include <QMutex>
+#include <QObject>
+#include <memory>
+#include <vector>
+
+class QSqlQuery;
+class SqliteDb;
+
+
+namespace providers {
+namespace playtime {
+
+/// Saves play sessions to the database.
+///
+/// Lives on its own thread and keeps a single connection with its prepared
+/// statements open between writes, so recording a session never waits for
+/// the disk on the caller side.
+class PlaytimeWriter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PlaytimeWriter(QObject* parent = nullptr);
+    ~PlaytimeWriter();
+
+    /// Thread safe; queues a play entry and schedules a write on the writer thread
+    void enqueue(QString db_path, QString game_path, QDateTime start_time, qint64 duration);
+    /// Blocks until the queued entries are written; call from outside the
+    /// writer thread, while that thread is running
+    void flush();
+
+signals:
+    void startedWriting();
+    void finishedWriting();
+
+private slots:
+    void processQueue();
+
+private:
+    struct QueueEntry {
+        QString db_path;
+        QString game_path;
+        QDateTime start_time;
+        qint64 duration;
+    };
+    std::vector<QueueEntry> m_pending_tasks;
+    bool m_write_scheduled;
+    QMutex m_queue_guard;
+
+    // the rest is only touched on the writer thread
+    QString m_db_path;
+    std::unique_ptr<SqliteDb> m_db;
+    std::unique_ptr<QSqlQuery> m_query_upsert_path;
+    std::unique_ptr<QSqlQuery> m_query_select_path;
+    std::unique_ptr<QSqlQuery> m_query_insert_play;
+    bool m_has_returning;
+    HashMap<QString, qint64> m_path_ids;
+
+    bool open_db(const QString&);
+    void close_db();
+    bool prepare_queries();
+    qint64 get_path_id(const QString&);
+    bool save_play_entry(qint64, const QDateTime&, qint64);
+    void write_batch(const std::vector<QueueEntry>&);
+    void commit_batch(std::vector<QString>& new_paths);
+};
+
+} // namespace playtime
+} // namespace providers
@@ -1,2 +1,9 @@
-HEADERS += $$PWD/PlaytimeStats.h
-SOURCES += $$PWD/PlaytimeStats.cpp
+HEADERS += \
+    $$PWD/PlaytimeSchema.h \
+    $$PWD/PlaytimeStats.h \
+    $$PWD/PlaytimeWriter.h \
+
+SOURCES += \
+    $$PWD/PlaytimeSchema.cpp \
+    $$PWD/PlaytimeStats.cpp \
+    $$PWD/PlaytimeWriter.cpp \
@@ -17,10 +17,9 @@
 
 #pragma once
 
+#include "providers/PathListJournal.h"
 #include "providers/Provider.h"
 
-#include <QMutex>
-
 
 namespace providers {
 namespace whitelists {
@@ -37,22 +36,17 @@ public:
 
     Provider& findDynamicData(const QVector<model::Collection*>&,
                               const QVector<model::Game*>&,
-                              const HashMap<QString, model::GameFile*>&) final;
+                              const HashMap<QString, model::GameFile*>&,
+                              DynamicData&) final;
 
-    void onGameWhitelistChanged(const QVector<model::Game*>&) final;
+    void onGameWhitelistChanged(model::Game* const) final;
 
 signals:
     void startedWriting();
     void finishedWriting();
 
 private:
-    QString m_db_path;
-
-    QStringList m_pending_task;
-    QStringList m_active_task;
-    QMutex m_task_guard;
-
-    void start_processing();
+    PathListJournal m_db;
 };
 
 } // namespace whitelists
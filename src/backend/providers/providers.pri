@@ -1,9 +1,13 @@
 HEADERS += \
+    $$PWD/DynamicData.h \
+    $$PWD/PathListJournal.h \
     $$PWD/Provider.h \
     $$PWD/ProviderManager.h \
     $$PWD/SearchContext.h \
 
 SOURCES += \
+    $$PWD/DynamicData.cpp \
+    $$PWD/PathListJournal.cpp \
     $$PWD/Provider.cpp \
     $$PWD/ProviderManager.cpp \
     $$PWD/SearchContext.cpp \
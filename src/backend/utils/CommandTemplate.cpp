@@ -0,0 +1,173 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "CommandTemplate.h"
+
+#include "CommandTokenizer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <algorithm>
+#include <iterator>
+
+
+namespace {
+const QProcessEnvironment& system_env()
+{
+    // reading the environment is not free, and it doesn't change while running
+    static const QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    return env;
+}
+
+struct FileValues {
+    explicit FileValues(const QFileInfo& finfo)
+        : path(QDir::toNativeSeparators(finfo.absoluteFilePath()))
+        , name(finfo.fileName())
+        , basename(finfo.completeBaseName())
+        , dir(QDir::toNativeSeparators(finfo.absolutePath()))
+    {}
+
+    const QString path;
+    const QString name;
+    const QString basename;
+    const QString dir;
+};
+} // namespace
+
+
+namespace utils {
+
+CommandTemplate::CommandTemplate() = default;
+
+CommandTemplate CommandTemplate::fromCommand(const QString& command)
+{
+    CommandTemplate result;
+    for (const QString& token : tokenize_command(command))
+        result.add_arg(token);
+    return result;
+}
+
+CommandTemplate CommandTemplate::fromText(const QString& text)
+{
+    CommandTemplate result;
+    if (!text.isEmpty())
+        result.add_arg(text);
+    return result;
+}
+
+void CommandTemplate::add_arg(const QString& str)
+{
+    const QLatin1String ENV_PREFIX("{env.");
+    const std::pair<QLatin1String, SegmentType> FILE_PLACEHOLDERS[] {
+        { QLatin1String("{file.path}"), SegmentType::FILE_PATH },
+        { QLatin1String("{file.name}"), SegmentType::FILE_NAME },
+        { QLatin1String("{file.basename}"), SegmentType::FILE_BASENAME },
+        { QLatin1String("{file.dir}"), SegmentType::FILE_DIR },
+    };
+
+    Arg arg;
+    QString text;
+
+    int text_start = 0;
+    int search_from = 0;
+    while (true) {
+        const int open_pos = str.indexOf(QLatin1Char('{'), search_from);
+        if (open_pos < 0)
+            break;
+
+        search_from = open_pos + 1;
+        const QStringRef rest = str.midRef(open_pos);
+
+        auto placeholder_it = std::find_if(std::begin(FILE_PLACEHOLDERS), std::end(FILE_PLACEHOLDERS),
+            [&rest](const std::pair<QLatin1String, SegmentType>& entry){ return rest.startsWith(entry.first); });
+        if (placeholder_it != std::end(FILE_PLACEHOLDERS)) {
+            text += str.midRef(text_start, open_pos - text_start);
+            if (!text.isEmpty())
+                arg.push_back({ SegmentType::TEXT, std::move(text) });
+            text = QString();
+
+            arg.push_back({ placeholder_it->second, QString() });
+            text_start = open_pos + placeholder_it->first.size();
+            search_from = text_start;
+            continue;
+        }
+
+        const int close_pos = str.indexOf(QLatin1Char('}'), open_pos);
+        if (close_pos < 0)
+            break;
+
+        if (rest.startsWith(ENV_PREFIX) && open_pos + ENV_PREFIX.size() < close_pos) {
+            const QString var_name = str.mid(open_pos + ENV_PREFIX.size(), close_pos - open_pos - ENV_PREFIX.size());
+            text += str.midRef(text_start, open_pos - text_start);
+            text += system_env().value(var_name);
+
+            text_start = close_pos + 1;
+            search_from = text_start;
+            continue;
+        }
+
+        if (rest.startsWith(QLatin1String("{file.")))
+            m_unknown_placeholders << str.mid(open_pos, close_pos - open_pos + 1);
+    }
+
+    text += str.midRef(text_start);
+    if (!text.isEmpty())
+        arg.push_back({ SegmentType::TEXT, std::move(text) });
+
+    m_args.push_back(std::move(arg));
+}
+
+QStringList CommandTemplate::expand(const QFileInfo& finfo) const
+{
+    const FileValues values(finfo);
+
+    QStringList result;
+    result.reserve(static_cast<int>(m_args.size()));
+
+    for (const Arg& arg : m_args) {
+        QString out;
+        for (const Segment& segment : arg) {
+            switch (segment.type) {
+                case SegmentType::TEXT:
+                    out += segment.text;
+                    break;
+                case SegmentType::FILE_PATH:
+                    out += values.path;
+                    break;
+                case SegmentType::FILE_NAME:
+                    out += values.name;
+                    break;
+                case SegmentType::FILE_BASENAME:
+                    out += values.basename;
+                    break;
+                case SegmentType::FILE_DIR:
+                    out += values.dir;
+                    break;
+            }
+        }
+        result.append(std::move(out));
+    }
+
+    return result;
+}
+
+QString CommandTemplate::expandText(const QFileInfo& finfo) const
+{
+    return expand(finfo).join(QLatin1Char(' '));
+}
+
+} // namespace utils
@@ -0,0 +1,69 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class QFileInfo;
+
+
+namespace utils {
+
+/// A launch command (or working directory) prepared in advance
+///
+/// The text is split into arguments, the `{file.*}` placeholders are located,
+/// and the `{env.*}` ones are replaced with the value of the environment
+/// variable. Filling it for a game file then only needs simple appends.
+class CommandTemplate {
+public:
+    CommandTemplate();
+
+    /// Splits the text to arguments, like a shell command
+    static CommandTemplate fromCommand(const QString&);
+    /// Keeps the whole text as a single argument
+    static CommandTemplate fromText(const QString&);
+
+    bool isEmpty() const { return m_args.empty(); }
+    /// The `{...}` items that are not supported, and left unchanged
+    const QStringList& unknownPlaceholders() const { return m_unknown_placeholders; }
+
+    QStringList expand(const QFileInfo&) const;
+    QString expandText(const QFileInfo&) const;
+
+private:
+    enum class SegmentType : unsigned char {
+        TEXT,
+        FILE_PATH,
+        FILE_NAME,
+        FILE_BASENAME,
+        FILE_DIR,
+    };
+    struct Segment {
+        SegmentType type;
+        QString text;
+    };
+    using Arg = std::vector<Segment>;
+
+    std::vector<Arg> m_args;
+    QStringList m_unknown_placeholders;
+
+    void add_arg(const QString&);
+};
+
+} // namespace utils
@@ -19,12 +19,17 @@
 
 #include "utils/StdHelpers.h"
 
+#include <QDirIterator>
+#include <QMutex>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+
 namespace {
-void remove_if(QFileInfoList& list, const std::function<bool(const QFileInfo&)>& predicate)
-{
-    const auto start_it = std::remove_if(list.begin(), list.end(), predicate);
-    list.erase(start_it, list.end());
-}
+// the number of rows added to the model at once
+static constexpr size_t CHUNK_SIZE = 512;
+// the number of directories kept in memory
+static constexpr size_t RECENT_LISTINGS = 8;
 
 std::vector<QString> drives()
 {
@@ -53,6 +58,32 @@ bool is_drive_root(const QString& path, const std::vector<QString>& drives)
 {
     return VEC_CONTAINS(drives, path);
 }
+
+void read_dir(FolderListing& listing, const QStringList& name_filters, const std::atomic<bool>& cancelled)
+{
+    constexpr auto filters = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable;
+
+    QDirIterator dir_it(listing.path, filters);
+    while (dir_it.hasNext() && !cancelled) {
+        dir_it.next();
+        const QFileInfo finfo = dir_it.fileInfo();
+        const bool is_dir = finfo.isDir();
+
+        QString name = finfo.fileName();
+        if (!is_dir && !name_filters.contains(name))
+            continue;
+
+        listing.entries.emplace_back(std::move(name), is_dir);
+    }
+
+    // directories first, then by name
+    std::sort(listing.entries.begin(), listing.entries.end(),
+        [](const FolderListEntry& a, const FolderListEntry& b) {
+            if (a.is_dir != b.is_dir)
+                return a.is_dir;
+            return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+        });
+}
 } // namespace
 
 
@@ -62,20 +93,47 @@ FolderListEntry::FolderListEntry(QString name, bool is_dir)
 {}
 
 
+struct FolderListModel::WorkerTarget {
+    QMutex guard;
+    FolderListModel* model;
+
+    explicit WorkerTarget(FolderListModel* model) : model(model) {}
+
+    // The call is queued while the model is known to be alive; if it gets
+    // destroyed before running it, Qt drops the posted call with it
+    template<typename Func>
+    void post(Func&& func) {
+        const QMutexLocker lock(&guard);
+        if (model)
+            QMetaObject::invokeMethod(model, std::forward<Func>(func), Qt::QueuedConnection);
+    }
+};
+
+
 FolderListModel::FolderListModel(QObject* parent)
     : QAbstractListModel(parent)
     , m_dir(startup_dir())
+    , m_loading(false)
     , m_drives_cache(drives())
     , m_role_names({
         { EntryName, "name" },
         { EntryIsDir, "isDir" },
     })
+    , m_request_id(0)
+    , m_worker_target(std::make_shared<WorkerTarget>(this))
 {
-    m_dir.setSorting(QDir::Name | QDir::DirsFirst | QDir::IgnoreCase);
-    m_dir.setFilter(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Readable);
     setNameFilters(m_name_filters);
 }
 
+FolderListModel::~FolderListModel()
+{
+    if (m_request_cancelled)
+        *m_request_cancelled = true;
+
+    const QMutexLocker lock(&m_worker_target->guard);
+    m_worker_target->model = nullptr;
+}
+
 int FolderListModel::rowCount(const QModelIndex&) const
 {
     return static_cast<int>(m_files.size());
@@ -103,43 +161,198 @@ QVariant FolderListModel::data(const QModelIndex& index, int role) const
 
 void FolderListModel::cd(const QString& dirName)
 {
+    const bool goto_root = (dirName == QLatin1String("..")) && is_drive_root(m_dir_path, m_drives_cache);
+    if (goto_root) {
+        show_drives();
+        return;
+    }
+
+    // the directory is checked on the worker thread, and if it can't be
+    // read, the previous one is restored and the drives are shown instead
+    const QString path = QDir::cleanPath(m_dir.absoluteFilePath(dirName));
+    m_dir.setPath(path);
+    new_request();
+
     beginResetModel();
     m_files.clear();
+    // adding dotdot manually to avoid getting stuck in the file system
+    m_files.emplace_back(QStringLiteral(".."), true);
+    endResetModel();
 
-    bool goto_root = (dirName == QLatin1String("..")) && is_drive_root(m_dir_path, m_drives_cache);
-    if (!goto_root) {
-        // try to step into the directory, otherwise fallback to the root
-        goto_root = (m_dir.cd(dirName) == false);
-        // TODO: update the drives cache here on error
-    }
+    m_dir_path = QDir::toNativeSeparators(path);
+    emit folderChanged();
+    set_loading(true);
 
-    if (goto_root) {
-        m_dir_path = QDir::toNativeSeparators(QStringLiteral("/"));
-        for (const QString& drive : m_drives_cache)
-            m_files.emplace_back(drive, true);
+    const std::shared_ptr<const FolderListing> recent = find_recent(path);
+    m_shown_listing = recent;
+    if (recent)
+        insert_chunk(m_request_id, recent, 0);
+
+    start_listing(path, recent ? recent->modified : QDateTime());
+}
+
+void FolderListModel::new_request()
+{
+    if (m_request_cancelled)
+        *m_request_cancelled = true;
+
+    m_request_id++;
+    m_request_cancelled = std::make_shared<std::atomic<bool>>(false);
+}
+
+void FolderListModel::start_listing(const QString& path, const QDateTime& known_modified)
+{
+    const quint32 request_id = m_request_id;
+    const std::shared_ptr<std::atomic<bool>> cancelled = m_request_cancelled;
+    const QStringList name_filters = m_name_filters;
+    const std::shared_ptr<WorkerTarget> target = m_worker_target;
+
+    QtConcurrent::run([target, path, known_modified, request_id, cancelled, name_filters]{
+        const QFileInfo dir_finfo(path);
+        if (!dir_finfo.isDir() || !dir_finfo.isReadable()) {
+            if (!*cancelled)
+                target->post([target, request_id]{ target->model->on_listing_failed(request_id); });
+            return;
+        }
+
+        // the recently seen contents are still up to date
+        const QDateTime modified = dir_finfo.lastModified();
+        if (known_modified.isValid() && modified == known_modified)
+            return;
+
+        auto listing = std::make_shared<FolderListing>();
+        listing->path = path;
+        listing->modified = modified;
+        read_dir(*listing, name_filters, *cancelled);
+
+        if (!*cancelled) {
+            std::shared_ptr<const FolderListing> result = std::move(listing);
+            target->post([target, request_id, result]{ target->model->on_listed(request_id, result); });
+        }
+    });
+}
+
+void FolderListModel::on_listed(quint32 request_id, std::shared_ptr<const FolderListing> listing)
+{
+    if (request_id != m_request_id)
+        return;
+
+    add_recent(listing);
+
+    // the recent contents might be shown already
+    if (m_files.size() > 1) {
+        beginResetModel();
+        m_files.erase(std::next(m_files.begin()), m_files.end());
+        endResetModel();
     }
-    else {
-        m_dir_path = QDir::toNativeSeparators(m_dir.absolutePath());
 
-        auto filist = m_dir.entryInfoList();
-        remove_if(filist, [this](const QFileInfo& fi){
-            return !fi.isDir() && !m_name_filters.contains(fi.fileName());
-        });
+    set_loading(true);
+    m_shown_listing = listing;
+    insert_chunk(request_id, std::move(listing), 0);
+}
 
-        // adding dotdot manually to avoid getting stuck in the file system
-        m_files.emplace_back(QStringLiteral(".."), true);
+void FolderListModel::on_listing_failed(quint32 request_id)
+{
+    if (request_id != m_request_id)
+        return;
+
+    const QString path = m_dir.absolutePath();
+    m_recent_listings.erase(
+        std::remove_if(m_recent_listings.begin(), m_recent_listings.end(),
+            [&path](const std::shared_ptr<const FolderListing>& listing){ return listing->path == path; }),
+        m_recent_listings.end());
+
+    // like QDir::cd, a failed step keeps the last directory that could be
+    // read, so the relative paths resolve from there
+    m_dir.setPath(m_recent_listings.empty()
+        ? startup_dir().absolutePath()
+        : m_recent_listings.front()->path);
+
+    // TODO: update the drives cache here on error
+    show_drives();
+}
 
-        for (const auto& fi : qAsConst(filist))
-            m_files.emplace_back(fi.fileName(), fi.isDir());
+void FolderListModel::insert_chunk(quint32 request_id, std::shared_ptr<const FolderListing> listing, size_t from)
+{
+    // a newer listing may have replaced this one
+    if (request_id != m_request_id || listing != m_shown_listing)
+        return;
+
+    const size_t to = std::min(from + CHUNK_SIZE, listing->entries.size());
+    if (from < to) {
+        const int first_row = static_cast<int>(m_files.size());
+        beginInsertRows(QModelIndex(), first_row, first_row + static_cast<int>(to - from) - 1);
+        for (size_t i = from; i < to; i++)
+            m_files.emplace_back(listing->entries[i].name, listing->entries[i].is_dir);
+        endInsertRows();
     }
 
+    if (to < listing->entries.size()) {
+        // the rest is added after the queued events, eg. painting, ran
+        QMetaObject::invokeMethod(this, [this, request_id, listing, to]{
+            insert_chunk(request_id, listing, to);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    set_loading(false);
+}
+
+void FolderListModel::show_drives()
+{
+    new_request();
+    m_shown_listing.reset();
+
+    beginResetModel();
+    m_files.clear();
+    for (const QString& drive : m_drives_cache)
+        m_files.emplace_back(drive, true);
     endResetModel();
+
+    m_dir_path = QDir::toNativeSeparators(QStringLiteral("/"));
     emit folderChanged();
+    set_loading(false);
+}
+
+void FolderListModel::set_loading(bool loading)
+{
+    if (m_loading == loading)
+        return;
+
+    m_loading = loading;
+    emit loadingChanged();
+}
+
+std::shared_ptr<const FolderListing> FolderListModel::find_recent(const QString& path)
+{
+    const auto it = std::find_if(m_recent_listings.begin(), m_recent_listings.end(),
+        [&path](const std::shared_ptr<const FolderListing>& listing){ return listing->path == path; });
+    if (it == m_recent_listings.end())
+        return nullptr;
+
+    std::rotate(m_recent_listings.begin(), it, std::next(it));
+    return m_recent_listings.front();
+}
+
+void FolderListModel::add_recent(std::shared_ptr<const FolderListing> listing)
+{
+    const QString& path = listing->path;
+    m_recent_listings.erase(
+        std::remove_if(m_recent_listings.begin(), m_recent_listings.end(),
+            [&path](const std::shared_ptr<const FolderListing>& other){ return other->path == path; }),
+        m_recent_listings.end());
+
+    m_recent_listings.insert(m_recent_listings.begin(), std::move(listing));
+    if (m_recent_listings.size() > RECENT_LISTINGS)
+        m_recent_listings.resize(RECENT_LISTINGS);
 }
 
 void FolderListModel::setNameFilters(QStringList nameFilters)
 {
     m_name_filters = std::move(nameFilters);
     emit nameFiltersChanged();
+
+    // the recent contents were filtered differently
+    m_recent_listings.clear();
     cd(QStringLiteral("."));
 }
@@ -20,7 +20,11 @@
 #include "utils/MoveOnly.h"
 
 #include <QAbstractListModel>
+#include <QDateTime>
 #include <QDir>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 
 struct FolderListEntry {
@@ -32,16 +36,29 @@ struct FolderListEntry {
     MOVE_ONLY(FolderListEntry)
 };
 
+struct FolderListing {
+    QString path;
+    QDateTime modified;
+    std::vector<FolderListEntry> entries;
+};
+
 
+/// Lists the contents of a directory for the file picker
+///
+/// The directories are read on a worker thread, and the entries are added
+/// to the model in smaller parts. The last few visited directories are kept
+/// in memory, and are shown right away while being checked for changes.
 class FolderListModel : public QAbstractListModel {
     Q_OBJECT
     Q_PROPERTY(QString folder READ folder NOTIFY folderChanged)
     Q_PROPERTY(QStringList nameFilters
                READ nameFilters WRITE setNameFilters
                NOTIFY nameFiltersChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
 
 public:
     explicit FolderListModel(QObject* parent = nullptr);
+    ~FolderListModel();
 
     enum Roles {
         EntryName = Qt::UserRole + 1,
@@ -57,17 +74,44 @@ public:
     QString folder() const { return m_dir_path; }
     const QStringList& nameFilters() const { return m_name_filters; }
     void setNameFilters(QStringList);
+    bool loading() const { return m_loading; }
 
 signals:
     void folderChanged();
     void nameFiltersChanged();
+    void loadingChanged();
 
 private:
     QDir m_dir;
     QString m_dir_path;
     std::vector<FolderListEntry> m_files;
     QStringList m_name_filters;
+    bool m_loading;
 
     const std::vector<QString> m_drives_cache;
     const QHash<int, QByteArray> m_role_names;
+
+    // the requests still running are cancelled when a new one starts
+    quint32 m_request_id;
+    std::shared_ptr<std::atomic<bool>> m_request_cancelled;
+
+    // the workers reach the model only through this, which is cleared on
+    // destruction instead of waiting for them (eg. on a hung network mount)
+    struct WorkerTarget;
+    const std::shared_ptr<WorkerTarget> m_worker_target;
+
+    // most recent first
+    std::vector<std::shared_ptr<const FolderListing>> m_recent_listings;
+    std::shared_ptr<const FolderListing> m_shown_listing;
+
+    void new_request();
+    void start_listing(const QString&, const QDateTime&);
+    void on_listed(quint32, std::shared_ptr<const FolderListing>);
+    void on_listing_failed(quint32);
+    void insert_chunk(quint32, std::shared_ptr<const FolderListing>, size_t);
+    void show_drives();
+    void set_loading(bool);
+
+    std::shared_ptr<const FolderListing> find_recent(const QString&);
+    void add_recent(std::shared_ptr<const FolderListing>);
 };
@@ -26,6 +26,12 @@ SqliteDb::SqliteDb(const QString& db_path)
     m_db.setDatabaseName(db_path);
 }
 
+SqliteDb::SqliteDb(const QString& db_path, const QString& connection_name)
+    : m_db(QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection_name))
+{
+    m_db.setDatabaseName(db_path);
+}
+
 SqliteDb::~SqliteDb()
 {
     if (!m_db.isOpen())
@@ -27,10 +27,13 @@
 class SqliteDb {
 public:
     explicit SqliteDb(const QString& db_path);
+    explicit SqliteDb(const QString& db_path, const QString& connection_name);
     ~SqliteDb();
 
     MOVE_ONLY(SqliteDb)
 
+    QSqlDatabase& handle() { return m_db; }
+
     bool open() { return m_db.open(); }
     bool startTransaction() { return m_db.transaction(); }
     bool rollback() { return m_db.rollback(); }
@@ -0,0 +1,241 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "Tracing.h"
+
+#include "LocaleUtils.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+
+namespace {
+struct Event {
+    QByteArray name;
+    char phase;
+    qint64 time_us;
+    qint64 duration_us;
+    int thread_id;
+};
+
+struct TraceState {
+    std::atomic_bool enabled { false };
+    QElapsedTimer clock;
+    QString out_path;
+
+    QMutex guard;
+    std::vector<Event> events;
+    std::vector<std::pair<int, QString>> thread_names;
+    int last_thread_id = 0;
+
+    std::atomic_int milestones_left { 0 };
+};
+
+TraceState& state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+qint64 now_us()
+{
+    return state().clock.nsecsElapsed() / 1000;
+}
+
+QString current_thread_name(int thread_id)
+{
+    QThread* const thread = QThread::currentThread();
+    if (!thread->objectName().isEmpty())
+        return thread->objectName();
+
+    const QCoreApplication* const app = QCoreApplication::instance();
+    if (app && app->thread() == thread)
+        return QStringLiteral("main");
+
+    return QStringLiteral("worker %1").arg(thread_id);
+}
+
+// Small, stable ids are easier to read in the viewers than the native ones
+int current_thread_id(TraceState& trace)
+{
+    static thread_local int thread_id = 0;
+    if (thread_id == 0) {
+        thread_id = ++trace.last_thread_id;
+        trace.thread_names.emplace_back(thread_id, current_thread_name(thread_id));
+    }
+    return thread_id;
+}
+
+void record(QByteArray name, char phase, qint64 time_us, qint64 duration_us)
+{
+    TraceState& trace = state();
+
+    const QMutexLocker lock(&trace.guard);
+    if (!trace.enabled)
+        return;
+
+    const int thread_id = current_thread_id(trace);
+    trace.events.push_back({ std::move(name), phase, time_us, duration_us, thread_id });
+}
+
+QJsonObject event_to_json(const QString& name, const char phase, qint64 time_us, int thread_id)
+{
+    return QJsonObject {
+        { QStringLiteral("name"), name },
+        { QStringLiteral("ph"), QString(QLatin1Char(phase)) },
+        { QStringLiteral("ts"), time_us },
+        { QStringLiteral("pid"), static_cast<qint64>(QCoreApplication::applicationPid()) },
+        { QStringLiteral("tid"), thread_id },
+    };
+}
+} // namespace
+
+
+namespace tracing {
+
+void enable(QString out_path)
+{
+    TraceState& trace = state();
+
+    const QMutexLocker lock(&trace.guard);
+    trace.out_path = std::move(out_path);
+    trace.clock.start();
+    trace.enabled = true;
+}
+
+bool enabled()
+{
+    return state().enabled;
+}
+
+void instant(const char* name)
+{
+    if (enabled())
+        record(QByteArray(name), 'i', now_us(), 0);
+}
+
+void expect_milestones(int count)
+{
+    state().milestones_left = count;
+}
+
+void milestone(const char* name)
+{
+    if (!enabled())
+        return;
+
+    record(QByteArray(name), 'i', now_us(), 0);
+    if (--state().milestones_left == 0)
+        save();
+}
+
+void save()
+{
+    TraceState& trace = state();
+
+    std::vector<Event> events;
+    std::vector<std::pair<int, QString>> thread_names;
+    QString out_path;
+    {
+        const QMutexLocker lock(&trace.guard);
+        if (!trace.enabled)
+            return;
+
+        trace.enabled = false;
+        events.swap(trace.events);
+        thread_names.swap(trace.thread_names);
+        out_path.swap(trace.out_path);
+    }
+
+    QJsonArray json_events;
+    for (const auto& entry : thread_names) {
+        QJsonObject json = event_to_json(QStringLiteral("thread_name"), 'M', 0, entry.first);
+        json.insert(QStringLiteral("args"), QJsonObject {{ QStringLiteral("name"), entry.second }});
+        json_events.append(json);
+    }
+    for (const Event& event : events) {
+        QJsonObject json = event_to_json(QString::fromUtf8(event.name), event.phase, event.time_us, event.thread_id);
+        if (event.phase == 'X')
+            json.insert(QStringLiteral("dur"), event.duration_us);
+        else
+            json.insert(QStringLiteral("s"), QStringLiteral("p"));
+        json_events.append(json);
+    }
+
+    const QJsonObject json_root {
+        { QStringLiteral("traceEvents"), json_events },
+        { QStringLiteral("displayTimeUnit"), QStringLiteral("ms") },
+    };
+
+    QSaveFile file(out_path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(json_root).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit())
+    {
+        qWarning().noquote() << tr_log("Could not write the startup trace to `%1`").arg(out_path);
+        return;
+    }
+
+    qInfo().noquote() << tr_log("Startup trace saved to `%1`").arg(out_path);
+}
+
+
+Span::Span(const char* name)
+    : m_start_us(enabled() ? now_us() : -1)
+{
+    if (m_start_us >= 0)
+        m_name = name;
+}
+
+Span::Span(const QString& name)
+    : m_start_us(enabled() ? now_us() : -1)
+{
+    if (m_start_us >= 0)
+        m_name = name.toUtf8();
+}
+
+Span::Span(const QString& prefix, QLatin1String suffix)
+    : m_start_us(enabled() ? now_us() : -1)
+{
+    if (m_start_us >= 0)
+        m_name = (prefix + suffix).toUtf8();
+}
+
+Span::~Span()
+{
+    end();
+}
+
+void Span::end()
+{
+    if (m_start_us < 0)
+        return;
+
+    const qint64 end_us = now_us();
+    record(std::move(m_name), 'X', m_start_us, end_us - m_start_us);
+    m_start_us = -1;
+}
+
+} // namespace tracing
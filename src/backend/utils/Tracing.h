@@ -0,0 +1,67 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "NoCopyNoMove.h"
+
+#include <QByteArray>
+#include <QString>
+
+
+/// Records the timeline of the startup, for performance analysis
+///
+/// Recording is off by default, and the calls below do nothing. When turned
+/// on, the events are collected in memory (from any thread), then saved as a
+/// Chrome trace JSON file, which can be opened in `chrome://tracing` or Perfetto.
+namespace tracing {
+
+/// Starts recording, the events will be written to `out_path`
+void enable(QString out_path);
+bool enabled();
+
+/// Records a single point in time
+void instant(const char* name);
+
+/// Sets the number of milestones the startup has to reach before the trace
+/// is saved automatically
+void expect_milestones(int count);
+/// Records a point in time like `instant`; the trace is saved after the last
+/// expected milestone, in whichever order they happen
+void milestone(const char* name);
+
+/// Writes out the recorded events and stops recording
+void save();
+
+
+/// Records the time between its creation and destruction (or `end()`)
+class Span {
+public:
+    explicit Span(const char* name);
+    explicit Span(const QString& name);
+    /// The name is only put together when recording is on
+    Span(const QString& prefix, QLatin1String suffix);
+    ~Span();
+    NO_COPY_NO_MOVE(Span)
+
+    void end();
+
+private:
+    QByteArray m_name;
+    qint64 m_start_us;
+};
+
+} // namespace tracing
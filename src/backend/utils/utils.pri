@@ -1,4 +1,5 @@
 HEADERS += \
+    $$PWD/CommandTemplate.h \
     $$PWD/CommandTokenizer.h \
     $$PWD/FakeQKeyEvent.h \
     $$PWD/FolderListModel.h \
@@ -12,8 +13,10 @@ HEADERS += \
     $$PWD/StdHelpers.h \
     $$PWD/StdStringHelpers.h \
     $$PWD/StrBoolConverter.h \
+    $$PWD/Tracing.h \
 
 SOURCES += \
+    $$PWD/CommandTemplate.cpp \
     $$PWD/CommandTokenizer.cpp \
     $$PWD/FakeQKeyEvent.cpp \
     $$PWD/FolderListModel.cpp \
@@ -22,3 +25,4 @@ SOURCES += \
     $$PWD/SqliteDb.cpp \
     $$PWD/StdStringHelpers.cpp \
     $$PWD/StrBoolConverter.cpp \
+    $$PWD/Tracing.cpp \
@@ -50,6 +50,13 @@ id: root
         return "";
     }
 
+    // Local images are loaded as pre-scaled thumbnails from the disk cache
+    function thumbnail(url) {
+        if (url && url.startsWith("file:"))
+            return "image://thumbnail/" + encodeURIComponent(url);
+        return url || "";
+    }
+
     property bool selected
     Behavior on scale { NumberAnimation { duration: 100 } }
     property var gameData
@@ -75,7 +82,7 @@ id: root
             anchors.margins: vpx(2)
 
             asynchronous: true
-            source: boxArt(gameData)
+            source: thumbnail(boxArt(gameData))
             sourceSize { width: root.width; height: root.height }
             fillMode: Image.PreserveAspectFit
             anchors.horizontalCenter: parent.horizontalCenter
@@ -43,6 +43,13 @@ id: root
         return "";
     }
 
+    // Local images are loaded as pre-scaled thumbnails from the disk cache
+    function thumbnail(url) {
+        if (url && url.startsWith("file:"))
+            return "image://thumbnail/" + encodeURIComponent(url);
+        return url || "";
+    }
+
     signal activated
     signal highlighted
     signal unhighlighted
@@ -92,7 +99,7 @@ id: root
 
             anchors.fill: parent
             anchors.margins: vpx(2)
-            source: modelData ? modelData.assets.screenshots[0] || modelData.assets.background || "" : ""
+            source: modelData ? thumbnail(modelData.assets.screenshots[0] || modelData.assets.background) : ""
             fillMode: Image.PreserveAspectCrop
             sourceSize: Qt.size(screenshot.width, screenshot.height)
             smooth: false
@@ -107,7 +114,7 @@ id: root
             anchors.centerIn: parent
             anchors.margins: root.width/10
             property var logoImage: (gameData && gameData.collections.get(0).shortName === "retropie") ? gameData.assets.boxFront : (gameData.collections.get(0).shortName === "steam") ? logo(gameData) : gameData.assets.logo
-            source: modelData ? logoImage || "" : ""
+            source: modelData ? thumbnail(logoImage) : ""
             sourceSize: Qt.size(favelogo.width, favelogo.height)
             fillMode: Image.PreserveAspectFit
             asynchronous: true
@@ -233,6 +233,23 @@ id: root
                 positionViewAtIndex(currentIndex, ListView.Visible);
             }
 
+            // Load the artwork of the next rows in advance, so fast scrolling doesn't wait for the images
+            property int prevIndex: 0
+            onCurrentIndexChanged: {
+                if (currentIndex >= 0) {
+                    const itemWidth = cellWidth;
+                    const itemHeight = cellHeight - titleMargin;
+                    const sizes = showBoxes
+                        ? { "boxFront": Qt.size(itemWidth, itemHeight) }
+                        : {
+                            "screenshot": Qt.size(itemWidth - vpx(4), itemHeight - vpx(4)),
+                            "logo": Qt.size(itemWidth * 0.8, itemHeight - itemWidth / 5),
+                        };
+                    api.prefetch.prefetch(model, currentIndex, currentIndex < prevIndex ? -1 : 1, numColumns * 3, sizes);
+                }
+                prevIndex = currentIndex;
+            }
+
             populate: Transition {
                 NumberAnimation { property: "opacity"; from: 0; to: 1.0; duration: 400 }
             }
@@ -30,10 +30,15 @@ id: root
     property string     sortBy:     "sortTitle"
     property bool       descending
 
-    property var allowedDevs:   []//Utils.uniqueGameValues('developerList').filter(e => e.selected).map(e => e.name)
-    property var allowedPubs:   []//Utils.uniqueGameValues('publisherList').filter(e => e.selected).map(e => e.name)
-    property var allowedGenres: []//Utils.uniqueGameValues('genreList').filter(e => e.selected).map(e => e.name)
-    property var allowedTags:   []//Utils.uniqueGameValues('tagList').filter(e => e.selected).map(e => e.name)
+    property var allowedDevs:   []
+    property var allowedPubs:   []
+    property var allowedGenres: []
+    property var allowedTags:   []
+    // per-game match flags, looked up from the backend facet index
+    readonly property var allowedDevMask:   allowedDevs.length ? api.facets.gameMask('developer', allowedDevs) : []
+    readonly property var allowedPubMask:   allowedPubs.length ? api.facets.gameMask('publisher', allowedPubs) : []
+    readonly property var allowedGenreMask: allowedGenres.length ? api.facets.gameMask('genre', allowedGenres) : []
+    readonly property var allowedTagMask:   allowedTags.length ? api.facets.gameMask('tag', allowedTags) : []
     /*readonly property var allowedCollGames: {
         const allowedCollNames = api.collections.toVarArray().map(coll => coll.name);
         const allowedColls = api.collections.toVarArray().filter(e => allowedCollNames.includes(e.name));
@@ -52,19 +57,19 @@ id: root
             },
             ExpressionFilter {
                 enabled: allowedDevs.length
-                expression: allowedDevs && developerList.some(v => allowedDevs.includes(v))
+                expression: allowedDevMask[index] === true
             },
             ExpressionFilter {
                 enabled: allowedPubs.length
-                expression: allowedPubs && publisherList.some(v => allowedPubs.includes(v))
+                expression: allowedPubMask[index] === true
             },
             ExpressionFilter {
                 enabled: allowedGenres.length
-                expression: allowedGenres && genreList.some(v => allowedGenres.includes(v))
+                expression: allowedGenreMask[index] === true
             },
             ExpressionFilter {
                 enabled: allowedTags.length
-                expression: allowedTags && tagList.some(v => allowedTags.includes(v))
+                expression: allowedTagMask[index] === true
             },
             ExpressionFilter {
                 enabled: years.length
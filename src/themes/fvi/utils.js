@@ -217,6 +217,11 @@ function shuffle(model){
 }
 
 function uniqueGameValues(fieldName) {
+  // developer/publisher/genre/tag lists are precomputed by the backend
+  const facet = api.facets.values(fieldName);
+  if (facet.length)
+    return facet;
+
   const set = new Set();
   api.allGames.toVarArray().forEach(game => {
       game[fieldName].forEach(v => set.add(v));
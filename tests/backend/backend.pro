@@ -3,7 +3,11 @@ TEMPLATE = subdirs
 SUBDIRS += \
     api \
     configfile \
+    folderlistmodel \
+    imggen \
     model \
     processlauncher \
     providers \
+    scriptrunner \
+    settingsfile \
     utils \
@@ -0,0 +1,180 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "utils/FolderListModel.h"
+
+
+namespace {
+// more than two chunks of the model
+constexpr int LARGE_DIR_SIZE = 1200;
+
+QStringList row_names(const FolderListModel& model)
+{
+    QStringList out;
+    for (int i = 0; i < model.rowCount(); i++)
+        out << model.data(model.index(i), FolderListModel::EntryName).toString();
+    return out;
+}
+
+bool touch(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly);
+}
+} // namespace
+
+
+class test_FolderListModel : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void listing();
+    void chunked_insert();
+    void cancel();
+    void destroy_while_listing();
+    void failed_cd();
+
+private:
+    QTemporaryDir m_tmpdir;
+    QString m_small_dir;
+    QString m_large_dir;
+};
+
+void test_FolderListModel::initTestCase()
+{
+    QVERIFY(m_tmpdir.isValid());
+
+    m_small_dir = m_tmpdir.filePath(QStringLiteral("small"));
+    QVERIFY(QDir().mkpath(m_small_dir + QStringLiteral("/Beta")));
+    QVERIFY(QDir().mkpath(m_small_dir + QStringLiteral("/alpha")));
+    QVERIFY(touch(m_small_dir + QStringLiteral("/b.txt")));
+    QVERIFY(touch(m_small_dir + QStringLiteral("/a.txt")));
+    QVERIFY(touch(m_small_dir + QStringLiteral("/ignored.txt")));
+
+    m_large_dir = m_tmpdir.filePath(QStringLiteral("large"));
+    for (int i = 0; i < LARGE_DIR_SIZE; i++) {
+        const QString name = QStringLiteral("dir%1").arg(i, 4, 10, QLatin1Char('0'));
+        QVERIFY(QDir().mkpath(m_large_dir + QLatin1Char('/') + name));
+    }
+}
+
+void test_FolderListModel::listing()
+{
+    FolderListModel model;
+    model.setNameFilters({ QStringLiteral("a.txt"), QStringLiteral("b.txt") });
+
+    model.cd(m_small_dir);
+    QCOMPARE(model.folder(), QDir::toNativeSeparators(m_small_dir));
+    QVERIFY(model.loading());
+    // only the way back is known before the worker finishes
+    QCOMPARE(row_names(model), QStringList { QStringLiteral("..") });
+
+    QTRY_VERIFY(!model.loading());
+    const QStringList expected {
+        QStringLiteral(".."),
+        QStringLiteral("alpha"),
+        QStringLiteral("Beta"),
+        QStringLiteral("a.txt"),
+        QStringLiteral("b.txt"),
+    };
+    QCOMPARE(row_names(model), expected);
+    QCOMPARE(model.data(model.index(1), FolderListModel::EntryIsDir).toBool(), true);
+    QCOMPARE(model.data(model.index(3), FolderListModel::EntryIsDir).toBool(), false);
+}
+
+void test_FolderListModel::chunked_insert()
+{
+    FolderListModel model;
+    QSignalSpy insert_spy(&model, &FolderListModel::rowsInserted);
+
+    model.cd(m_large_dir);
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(model.rowCount(), LARGE_DIR_SIZE + 1);
+    QCOMPARE(model.data(model.index(LARGE_DIR_SIZE), FolderListModel::EntryName).toString(),
+             QStringLiteral("dir%1").arg(LARGE_DIR_SIZE - 1));
+
+    // the rows are added in parts, each one after the previous
+    QVERIFY(insert_spy.count() > 1);
+    int next_row = 1;
+    for (const QList<QVariant>& args : qAsConst(insert_spy)) {
+        QCOMPARE(args.at(1).toInt(), next_row);
+        next_row = args.at(2).toInt() + 1;
+    }
+    QCOMPARE(next_row, LARGE_DIR_SIZE + 1);
+}
+
+void test_FolderListModel::cancel()
+{
+    FolderListModel model;
+    model.setNameFilters({ QStringLiteral("a.txt") });
+
+    // the large directory is left before it could be shown
+    model.cd(m_large_dir);
+    model.cd(m_small_dir);
+    QTRY_VERIFY(!model.loading());
+
+    const QStringList expected {
+        QStringLiteral(".."),
+        QStringLiteral("alpha"),
+        QStringLiteral("Beta"),
+        QStringLiteral("a.txt"),
+    };
+    QCOMPARE(row_names(model), expected);
+
+    // nothing arrives late from the first listing
+    QTest::qWait(200);
+    QCOMPARE(row_names(model), expected);
+    QCOMPARE(model.folder(), QDir::toNativeSeparators(m_small_dir));
+}
+
+void test_FolderListModel::destroy_while_listing()
+{
+    auto model = new FolderListModel();
+    model->cd(m_large_dir);
+    delete model;
+
+    // the worker can finish on its own, without anything to report to
+    QTest::qWait(200);
+}
+
+void test_FolderListModel::failed_cd()
+{
+    FolderListModel model;
+    model.cd(m_small_dir);
+    QTRY_VERIFY(!model.loading());
+
+    // the drives are shown instead
+    model.cd(QStringLiteral("missing"));
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(model.folder(), QDir::toNativeSeparators(QStringLiteral("/")));
+    QVERIFY(model.rowCount() > 0);
+    QVERIFY(!row_names(model).contains(QStringLiteral("..")));
+
+    // relative paths continue from the last directory that could be read
+    model.cd(QStringLiteral("alpha"));
+    QCOMPARE(model.folder(), QDir::toNativeSeparators(m_small_dir + QStringLiteral("/alpha")));
+    QTRY_VERIFY(!model.loading());
+    QCOMPARE(row_names(model), QStringList { QStringLiteral("..") });
+}
+
+
+QTEST_MAIN(test_FolderListModel)
+#include "test_FolderListModel.moc"
@@ -0,0 +1,276 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "Paths.h"
+#include "imggen/Thumbnails.h"
+
+
+namespace {
+const std::atomic_bool NOT_CANCELED(false);
+
+QString thumbnail_dir()
+{
+    return paths::writableCacheDir() + QStringLiteral("/thumbnails");
+}
+
+QStringList thumbnail_files()
+{
+    return QDir(thumbnail_dir()).entryList(
+        { QStringLiteral("*.jpg"), QStringLiteral("*.png") },
+        QDir::Files, QDir::Time);
+}
+
+void remove_thumbnail_files()
+{
+    for (const QString& name : thumbnail_files())
+        QFile::remove(QDir(thumbnail_dir()).filePath(name));
+}
+
+bool write_image(const QString& path, const QSize& size, bool alpha)
+{
+    QImage image(size, alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    image.fill(alpha ? QColor(255, 0, 0, 128) : QColor(0, 0, 255));
+    return image.save(path, "PNG");
+}
+
+bool set_mtime(const QString& path, const QDateTime& time)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadWrite)
+        && file.setFileTime(time, QFileDevice::FileModificationTime);
+}
+} // namespace
+
+
+class test_Thumbnails : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void scaled_size();
+    void scaled_size_data();
+
+    void load_downscaled();
+    void load_downscaled_data();
+    void load_small();
+    void cache_hit();
+    void cache_invalidated();
+    void memory_cache();
+    void create_small();
+    void prune();
+
+private:
+    QTemporaryDir m_image_dir;
+
+    QString image_path(const QString& name) const { return m_image_dir.filePath(name); }
+};
+
+void test_Thumbnails::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_image_dir.isValid());
+}
+
+void test_Thumbnails::init()
+{
+    remove_thumbnail_files();
+    thumbnails::clear_memory();
+}
+
+void test_Thumbnails::cleanupTestCase()
+{
+    init();
+}
+
+
+void test_Thumbnails::scaled_size_data()
+{
+    QTest::addColumn<QSize>("orig");
+    QTest::addColumn<QSize>("requested");
+    QTest::addColumn<QSize>("expected");
+
+    QTest::newRow("width only") << QSize(400, 300) << QSize(100, 0) << QSize(100, 75);
+    QTest::newRow("height only") << QSize(400, 300) << QSize(0, 100) << QSize(133, 100);
+    QTest::newRow("covers both") << QSize(400, 300) << QSize(100, 100) << QSize(133, 100);
+    QTest::newRow("exact") << QSize(400, 300) << QSize(400, 300) << QSize(400, 300);
+    QTest::newRow("larger") << QSize(400, 300) << QSize(800, 600) << QSize(400, 300);
+    QTest::newRow("one side larger") << QSize(1000, 10) << QSize(100, 100) << QSize(1000, 10);
+    QTest::newRow("unconstrained") << QSize(400, 300) << QSize(0, 0) << QSize(400, 300);
+    QTest::newRow("at least one pixel") << QSize(1000, 1) << QSize(10, 0) << QSize(10, 1);
+}
+
+void test_Thumbnails::scaled_size()
+{
+    QFETCH(QSize, orig);
+    QFETCH(QSize, requested);
+    QFETCH(QSize, expected);
+
+    QCOMPARE(thumbnails::scaled_size(orig, requested), expected);
+}
+
+void test_Thumbnails::load_downscaled_data()
+{
+    QTest::addColumn<bool>("alpha");
+    QTest::addColumn<QString>("cached_ext");
+
+    QTest::newRow("opaque") << false << QStringLiteral(".jpg");
+    QTest::newRow("transparent") << true << QStringLiteral(".png");
+}
+
+void test_Thumbnails::load_downscaled()
+{
+    QFETCH(bool, alpha);
+    QFETCH(QString, cached_ext);
+
+    const QString path = image_path(QStringLiteral("downscaled.png"));
+    QVERIFY(write_image(path, QSize(400, 300), alpha));
+
+    const QImage image = thumbnails::load(path, QSize(100, 0), NOT_CANCELED);
+    QCOMPARE(image.size(), QSize(100, 75));
+    QCOMPARE(image.hasAlphaChannel(), alpha);
+
+    const QStringList files = thumbnail_files();
+    QCOMPARE(files.size(), 1);
+    QVERIFY(files.first().endsWith(cached_ext));
+}
+
+void test_Thumbnails::load_small()
+{
+    const QString path = image_path(QStringLiteral("small.png"));
+    QVERIFY(write_image(path, QSize(50, 40), false));
+
+    // used as it is, nothing is stored
+    const QImage image = thumbnails::load(path, QSize(100, 100), NOT_CANCELED);
+    QCOMPARE(image.size(), QSize(50, 40));
+    QVERIFY(thumbnail_files().isEmpty());
+}
+
+void test_Thumbnails::cache_hit()
+{
+    const QString path = image_path(QStringLiteral("hit.png"));
+    QVERIFY(write_image(path, QSize(400, 300), false));
+    QVERIFY(thumbnails::create(path, QSize(100, 0), NOT_CANCELED));
+    QCOMPARE(thumbnail_files().size(), 1);
+
+    // same path, size and modification time, but the contents can't be
+    // decoded anymore, so the results can only come from the cache
+    const QFileInfo finfo(path);
+    const QDateTime mtime = finfo.lastModified();
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(QByteArray(static_cast<int>(finfo.size()), 'x')), finfo.size());
+    }
+    QVERIFY(set_mtime(path, mtime));
+
+    QVERIFY(thumbnails::create(path, QSize(100, 0), NOT_CANCELED));
+    QCOMPARE(thumbnails::load(path, QSize(100, 0), NOT_CANCELED).size(), QSize(100, 75));
+    QCOMPARE(thumbnail_files().size(), 1);
+
+    // another size is a miss
+    QVERIFY(!thumbnails::create(path, QSize(50, 0), NOT_CANCELED));
+    QVERIFY(thumbnails::load(path, QSize(50, 0), NOT_CANCELED).isNull());
+}
+
+void test_Thumbnails::cache_invalidated()
+{
+    const QString path = image_path(QStringLiteral("changed.png"));
+    QVERIFY(write_image(path, QSize(400, 300), false));
+    QCOMPARE(thumbnails::load(path, QSize(100, 0), NOT_CANCELED).size(), QSize(100, 75));
+
+    // a new image at the same path
+    QVERIFY(write_image(path, QSize(400, 200), false));
+    QVERIFY(set_mtime(path, QFileInfo(path).lastModified().addSecs(10)));
+
+    QCOMPARE(thumbnails::load(path, QSize(100, 0), NOT_CANCELED).size(), QSize(100, 50));
+    QCOMPARE(thumbnail_files().size(), 2);
+}
+
+void test_Thumbnails::memory_cache()
+{
+    const QString path = image_path(QStringLiteral("memory.png"));
+    QVERIFY(write_image(path, QSize(400, 300), false));
+    QVERIFY(!thumbnails::load(path, QSize(100, 0), NOT_CANCELED).isNull());
+
+    // the disk copy is not needed while the image is kept in memory
+    remove_thumbnail_files();
+    QVERIFY(!thumbnails::load(path, QSize(100, 0), NOT_CANCELED).isNull());
+    QVERIFY(thumbnail_files().isEmpty());
+
+    // but it's recreated after the memory is cleared
+    thumbnails::clear_memory();
+    QVERIFY(!thumbnails::load(path, QSize(100, 0), NOT_CANCELED).isNull());
+    QCOMPARE(thumbnail_files().size(), 1);
+}
+
+void test_Thumbnails::create_small()
+{
+    const QString path = image_path(QStringLiteral("create_small.png"));
+    QVERIFY(write_image(path, QSize(50, 40), false));
+
+    QVERIFY(thumbnails::create(path, QSize(100, 100), NOT_CANCELED));
+    QVERIFY(thumbnail_files().isEmpty());
+
+    QVERIFY(!thumbnails::create(image_path(QStringLiteral("missing.png")), QSize(100, 100), NOT_CANCELED));
+
+    const std::atomic_bool canceled(true);
+    QVERIFY(!thumbnails::create(path, QSize(20, 0), canceled));
+    QVERIFY(thumbnail_files().isEmpty());
+}
+
+void test_Thumbnails::prune()
+{
+    const QString path = image_path(QStringLiteral("prune.png"));
+    QVERIFY(write_image(path, QSize(400, 300), false));
+
+    const QVector<QSize> sizes { QSize(100, 0), QSize(90, 0), QSize(80, 0), QSize(70, 0) };
+    for (const QSize& size : sizes)
+        QVERIFY(thumbnails::create(path, size, NOT_CANCELED));
+    QCOMPARE(thumbnail_files().size(), sizes.size());
+
+    // make the files look used in a known order, the first one the oldest
+    const QDateTime now = QDateTime::currentDateTime();
+    QStringList files = thumbnail_files();
+    std::sort(files.begin(), files.end());
+    for (int i = 0; i < files.size(); i++)
+        QVERIFY(set_mtime(QDir(thumbnail_dir()).filePath(files.at(i)), now.addSecs(i - files.size())));
+
+    const QString newest = files.at(files.size() - 1);
+    const QString second_newest = files.at(files.size() - 2);
+    const qint64 kept_bytes = QFileInfo(QDir(thumbnail_dir()).filePath(newest)).size()
+        + QFileInfo(QDir(thumbnail_dir()).filePath(second_newest)).size();
+
+    QCOMPARE(thumbnails::prune_disk_cache(kept_bytes), files.size() - 2);
+
+    QStringList remaining = thumbnail_files();
+    remaining.sort();
+    QStringList expected { second_newest, newest };
+    expected.sort();
+    QCOMPARE(remaining, expected);
+
+    // under the limit, nothing else is removed
+    QCOMPARE(thumbnails::prune_disk_cache(kept_bytes), 0);
+}
+
+
+QTEST_MAIN(test_Thumbnails)
+#include "test_Thumbnails.moc"
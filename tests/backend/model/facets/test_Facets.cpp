@@ -0,0 +1,123 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "model/gaming/Facets.h"
+#include "model/gaming/Game.h"
+
+
+class test_Facets : public QObject {
+    Q_OBJECT
+
+private slots:
+    void empty();
+    void values();
+    void postings();
+    void mask();
+    void unknownField();
+
+private:
+    QVector<model::Game*> make_games(QObject* parent);
+};
+
+QVector<model::Game*> test_Facets::make_games(QObject* parent)
+{
+    auto game_a = new model::Game("a", parent);
+    game_a->genreList() << "Puzzle" << "Action" << "Puzzle";
+    game_a->developerList() << "Dev 1";
+
+    auto game_b = new model::Game("b", parent);
+    game_b->genreList() << "Action";
+    game_b->developerList() << "Dev 2";
+    game_b->tagList() << "retro";
+
+    auto game_c = new model::Game("c", parent);
+    game_c->genreList() << "Racing" << "Action";
+    game_c->developerList() << "Dev 1";
+
+    return { game_a, game_b, game_c };
+}
+
+void test_Facets::empty()
+{
+    model::Facets facets;
+    QVERIFY(facets.genres().isEmpty());
+    QCOMPARE(facets.count("genre", "Action"), 0);
+    QVERIFY(facets.games("genre", "Action").isEmpty());
+}
+
+void test_Facets::values()
+{
+    QObject parent;
+    model::Facets facets;
+
+    QSignalSpy spy(&facets, &model::Facets::facetsChanged);
+    QVERIFY(spy.isValid());
+
+    facets.setIndex(model::build_facet_index(make_games(&parent)));
+    QCOMPARE(spy.count(), 1);
+
+    QCOMPARE(facets.genres(), QStringList({"Action", "Puzzle", "Racing"}));
+    QCOMPARE(facets.developers(), QStringList({"Dev 1", "Dev 2"}));
+    QCOMPARE(facets.tags(), QStringList({"retro"}));
+    QVERIFY(facets.publishers().isEmpty());
+
+    QCOMPARE(facets.values("genreList"), facets.genres());
+    QCOMPARE(facets.property("genres").toStringList(), facets.genres());
+}
+
+void test_Facets::postings()
+{
+    QObject parent;
+    model::Facets facets;
+    facets.setIndex(model::build_facet_index(make_games(&parent)));
+
+    QCOMPARE(facets.count("genre", "Action"), 3);
+    QCOMPARE(facets.count("genre", "Puzzle"), 1);
+    QCOMPARE(facets.count("developer", "Dev 1"), 2);
+    QCOMPARE(facets.count("genre", "Sports"), 0);
+
+    QCOMPARE(facets.games("genre", "Action"), QVariantList({0, 1, 2}));
+    QCOMPARE(facets.games("developer", "Dev 1"), QVariantList({0, 2}));
+}
+
+void test_Facets::mask()
+{
+    QObject parent;
+    model::Facets facets;
+    facets.setIndex(model::build_facet_index(make_games(&parent)));
+
+    QCOMPARE(facets.gameMask("genre", {"Puzzle", "Racing"}), QVariantList({true, false, true}));
+    QCOMPARE(facets.gameMask("tag", {"retro"}), QVariantList({false, true, false}));
+    QCOMPARE(facets.gameMask("tag", {}), QVariantList({false, false, false}));
+}
+
+void test_Facets::unknownField()
+{
+    QObject parent;
+    model::Facets facets;
+    facets.setIndex(model::build_facet_index(make_games(&parent)));
+
+    QVERIFY(facets.values("title").isEmpty());
+    QCOMPARE(facets.count("title", "a"), 0);
+    QVERIFY(facets.gameMask("title", {"a"}).isEmpty());
+}
+
+
+QTEST_MAIN(test_Facets)
+#include "test_Facets.moc"
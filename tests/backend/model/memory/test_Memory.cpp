@@ -34,6 +34,7 @@ private slots:
     void json_data();
 
     void settings_file();
+    void settings_file_batched();
 };
 
 void test_Memory::set_new()
@@ -183,6 +184,37 @@ void test_Memory::settings_file()
     json_file.remove();
 }
 
+void test_Memory::settings_file_batched()
+{
+    QString temp_path = QDir::tempPath();
+    if (!temp_path.endsWith('/'))
+        temp_path += '/';
+
+    const QString json_path = temp_path + "QtAutoTestC.json";
+    QFile(json_path).remove();
+
+
+    Container c(temp_path);
+    c.memory()->changeTheme("/path/to/QtAutoTestC/");
+
+    // the changes are not written right away
+
+    for (int i = 0; i < 100; i++)
+        c.memory()->set("cursor", i);
+    QCOMPARE(c.memory()->get("cursor"), QVariant(99));
+    QCOMPARE(QFileInfo::exists(json_path), false);
+
+    // only the last state is saved
+
+    c.memory()->save();
+    QCOMPARE(QFileInfo::exists(json_path), true);
+    QFile json_file(json_path);
+    json_file.open(QFile::ReadOnly);
+    QCOMPARE(json_file.readAll(), QByteArrayLiteral(R"({"cursor":99})"));
+
+    json_file.remove();
+}
+
 
 QTEST_MAIN(test_Memory)
 #include "test_Memory.moc"
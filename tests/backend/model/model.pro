@@ -2,6 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     collection \
+    facets \
     game \
     gameassets \
     locales \
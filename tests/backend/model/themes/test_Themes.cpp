@@ -17,6 +17,8 @@
 
 #include <QtTest/QtTest>
 
+#include "AppSettings.h"
+#include "Paths.h"
 #include "model/internal/settings/Themes.h"
 
 
@@ -31,6 +33,12 @@ private slots:
 
     void indexChange();
     void indexChange_data();
+
+    void lazyDiscovery();
+    void storedTheme();
+    void storedThemeMissing();
+    void debugThemeFirst();
+    void debugThemeFirst_data();
 };
 
 void test_Themes::initTestCase()
@@ -75,6 +83,105 @@ void test_Themes::indexChange_data()
     QTest::newRow("out of range (neg)") << -999;
 }
 
+void test_Themes::lazyDiscovery()
+{
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Found theme .*"));
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Theme set to .*"));
+
+    model::Themes themes;
+    const auto before = themes.currentQmlPath();
+    QCOMPARE(themes.rowCount(), 1);
+    QVERIFY(themes.canFetchMore(QModelIndex()));
+
+    themes.fetchMore(QModelIndex());
+    QVERIFY(!themes.canFetchMore(QModelIndex()));
+    QVERIFY(themes.rowCount() >= 1);
+
+    QCOMPARE(themes.currentQmlPath(), before);
+    const QModelIndex current = themes.index(themes.currentIndex());
+    QCOMPARE(themes.data(current, model::Themes::Name).toString(), themes.currentName());
+}
+
+void test_Themes::storedTheme()
+{
+    QTemporaryDir theme_dir;
+    QVERIFY(theme_dir.isValid());
+    {
+        QFile meta_file(theme_dir.filePath(QStringLiteral("theme.cfg")));
+        QVERIFY(meta_file.open(QIODevice::WriteOnly | QIODevice::Text));
+        meta_file.write("name: Stored theme\n");
+
+        QFile qml_file(theme_dir.filePath(QStringLiteral("theme.qml")));
+        QVERIFY(qml_file.open(QIODevice::WriteOnly | QIODevice::Text));
+        qml_file.write("import QtQuick 2.0\nItem {}\n");
+    }
+
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Theme set to .*"));
+
+    const QString prev_theme = AppSettings::general.theme;
+    AppSettings::general.theme = theme_dir.path();
+
+    model::Themes themes;
+    AppSettings::general.theme = prev_theme;
+
+    QCOMPARE(themes.currentName(), QStringLiteral("Stored theme"));
+}
+
+void test_Themes::storedThemeMissing()
+{
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Requested theme .* not found, falling back to default"));
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Theme set to .*"));
+
+    const QString prev_theme = AppSettings::general.theme;
+    AppSettings::general.theme = QStringLiteral("/this/theme/does/not/exist");
+
+    model::Themes themes;
+    AppSettings::general.theme = prev_theme;
+
+    QVERIFY(themes.currentIndex() >= 0);
+    QVERIFY(!themes.currentQmlPath().isEmpty());
+}
+
+void test_Themes::debugThemeFirst_data()
+{
+    QTest::addColumn<QString>("stored_theme");
+
+    QTest::newRow("nothing stored") << AppSettings::general.DEFAULT_THEME;
+    QTest::newRow("default stored") << QFileInfo(paths::writableConfigDir(), AppSettings::general.DEFAULT_THEME).absoluteFilePath();
+    QTest::newRow("empty") << QString();
+}
+
+void test_Themes::debugThemeFirst()
+{
+    QFETCH(QString, stored_theme);
+
+    const QString debug_dir = QFileInfo(paths::writableConfigDir(), AppSettings::general.DEBUG_THEME).absoluteFilePath();
+    if (QFileInfo::exists(debug_dir))
+        QSKIP("a debug theme is installed already");
+
+    QVERIFY(QDir().mkpath(debug_dir));
+    {
+        QFile meta_file(QDir(debug_dir).filePath(QStringLiteral("theme.cfg")));
+        QVERIFY(meta_file.open(QIODevice::WriteOnly | QIODevice::Text));
+        meta_file.write("name: Debug theme\n");
+
+        QFile qml_file(QDir(debug_dir).filePath(QStringLiteral("theme.qml")));
+        QVERIFY(qml_file.open(QIODevice::WriteOnly | QIODevice::Text));
+        qml_file.write("import QtQuick 2.0\nItem {}\n");
+    }
+
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Theme set to .*"));
+
+    const QString prev_theme = AppSettings::general.theme;
+    AppSettings::general.theme = stored_theme;
+
+    model::Themes themes;
+    AppSettings::general.theme = prev_theme;
+    QDir(debug_dir).removeRecursively();
+
+    QCOMPARE(themes.currentName(), QStringLiteral("Debug theme"));
+}
+
 
 QTEST_MAIN(test_Themes)
 #include "test_Themes.moc"
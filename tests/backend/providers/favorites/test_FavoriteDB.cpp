@@ -19,6 +19,7 @@
 
 #include "model/gaming/Collection.h"
 #include "model/gaming/Game.h"
+#include "providers/DynamicData.h"
 #include "providers/pegasus_favorites/Favorites.h"
 #include "utils/HashMap.h"
 
@@ -29,6 +30,8 @@ class test_FavoriteDB : public QObject {
 private slots:
     void write();
     void rewrite_empty();
+    void write_on_exit();
+    void rewrite_failed();
     void read();
 
 private:
@@ -94,13 +97,18 @@ void test_FavoriteDB::write()
     QVERIFY(spy_start.isValid());
     QVERIFY(spy_end.isValid());
 
-    favorite_db.onGameFavoriteChanged(games);
+    favorite_db.onGameFavoriteChanged(games.at(1));
+    favorite_db.onGameFavoriteChanged(games.at(2));
 
+    // the changes are saved together
     QVERIFY(spy_start.count() || spy_start.wait());
     QVERIFY(spy_end.count() || spy_end.wait());
     QCOMPARE(spy_start.count(), 1);
     QCOMPARE(spy_end.count(), 1);
 
+    // folds the journal into the list
+    favorite_db.unload();
+
 
     QFile db_file(db_path);
     QVERIFY(db_file.open(QFile::ReadOnly | QFile::Text));
@@ -140,12 +148,13 @@ void test_FavoriteDB::rewrite_empty()
     QVERIFY(spy_end.isValid());
 
     games.at(1)->setFavorite(true);
-    favorite_db.onGameFavoriteChanged(games);
+    favorite_db.onGameFavoriteChanged(games.at(1));
 
     games.at(1)->setFavorite(false);
-    favorite_db.onGameFavoriteChanged(games);
+    favorite_db.onGameFavoriteChanged(games.at(1));
 
-    QVERIFY(spy_end.count() == 2 || spy_end.wait());
+    QVERIFY(spy_end.count() == 1 || spy_end.wait());
+    favorite_db.unload();
 
 
     QFile db_file(db_path);
@@ -163,6 +172,82 @@ void test_FavoriteDB::rewrite_empty()
     QFile::remove(db_path);
 }
 
+void test_FavoriteDB::write_on_exit()
+{
+    QVector<model::Collection*> collections;
+    QVector<model::Game*> games;
+    create_dummy_data(collections, games);
+
+    QTemporaryFile tmp_file;
+    tmp_file.setAutoRemove(false);
+    QVERIFY(tmp_file.open());
+
+    const QString db_path = tmp_file.fileName();
+    tmp_file.close();
+
+    // the change is saved without waiting for the timer
+    {
+        providers::favorites::Favorites favorite_db;
+        favorite_db.load_with_dbpath(db_path);
+
+        games.at(1)->setFavorite(true);
+        favorite_db.onGameFavoriteChanged(games.at(1));
+    }
+
+
+    QFile journal_file(db_path + QStringLiteral(".journal"));
+    QVERIFY(journal_file.open(QFile::ReadOnly | QFile::Text));
+
+    QTextStream journal_stream(&journal_file);
+    QStringList found_lines;
+    QString line;
+    while (journal_stream.readLineInto(&line))
+        found_lines << line;
+
+    QCOMPARE(found_lines, QStringList({ QStringLiteral("+:/coll1dummy2") }));
+
+    journal_file.close();
+    QFile::remove(journal_file.fileName());
+    QFile::remove(db_path);
+}
+
+void test_FavoriteDB::rewrite_failed()
+{
+    QVector<model::Collection*> collections;
+    QVector<model::Game*> games;
+    create_dummy_data(collections, games);
+
+    // the list cannot be replaced, as there's a directory in its place
+    QTemporaryDir tmp_dir;
+    QVERIFY(tmp_dir.isValid());
+    const QString db_path = tmp_dir.filePath(QStringLiteral("favorites.txt"));
+    QVERIFY(QDir().mkpath(db_path));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(".*could not write `.*`, the changes are kept in the journal"));
+    {
+        providers::favorites::Favorites favorite_db;
+        favorite_db.load_with_dbpath(db_path);
+
+        games.at(1)->setFavorite(true);
+        favorite_db.onGameFavoriteChanged(games.at(1));
+
+        // tries to fold the journal into the list
+        favorite_db.unload();
+    }
+
+
+    QFile journal_file(db_path + QStringLiteral(".journal"));
+    QVERIFY(journal_file.open(QFile::ReadOnly | QFile::Text));
+
+    QTextStream journal_stream(&journal_file);
+    QStringList found_lines;
+    QString line;
+    while (journal_stream.readLineInto(&line))
+        found_lines << line;
+
+    QCOMPARE(found_lines, QStringList({ QStringLiteral("+:/coll1dummy2") }));
+}
+
 void test_FavoriteDB::read()
 {
     QVector<model::Collection*> collections;
@@ -193,7 +278,9 @@ void test_FavoriteDB::read()
         path_map.emplace(std::move(path), gamefile);
     }
 
-    favorite_db.findDynamicData({}, games, path_map);
+    providers::DynamicData dyndata;
+    favorite_db.findDynamicData({}, games, path_map, dyndata);
+    providers::apply_dynamic_data(dyndata);
 
     QVERIFY(!games[0]->isFavorite());
     QVERIFY(games[1]->isFavorite());
@@ -0,0 +1,8 @@
+TARGET = test_JsonCache
+SOURCES = \
+    $${TARGET}.cpp \
+    $${TOP_SRCDIR}/src/backend/providers/JsonCacheUtils.cpp
+HEADERS = \
+    $${TOP_SRCDIR}/src/backend/providers/JsonCacheUtils.h
+
+include($${TOP_SRCDIR}/tests/cxxtest_common.pri)
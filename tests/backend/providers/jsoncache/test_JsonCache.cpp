@@ -0,0 +1,223 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "Paths.h"
+#include "providers/JsonCacheUtils.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+Q_DECLARE_METATYPE(providers::JsonCacheFormat)
+
+
+namespace {
+const QString LOG_PREFIX = QStringLiteral("JsonCacheTest:");
+
+// every test uses its own directory, as the opened cache files are kept
+// for the whole program run
+QString cache_dir_path(const QString& provider_dir)
+{
+    return paths::writableCacheDir() + QLatin1Char('/') + provider_dir;
+}
+
+QString cache_file_path(const QString& provider_dir)
+{
+    return cache_dir_path(provider_dir) + QStringLiteral("/entries.jsoncache");
+}
+
+QJsonDocument sample_object(const QString& value)
+{
+    return QJsonDocument(QJsonObject {
+        { QStringLiteral("name"), value },
+        { QStringLiteral("count"), 42 },
+        { QStringLiteral("list"), QJsonArray { 1, QStringLiteral("two"), true } },
+    });
+}
+} // namespace
+
+
+class test_JsonCache : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void put_read();
+    void put_read_data();
+    void put_raw_text();
+    void overwrite_remove();
+    void truncated_tail();
+    void compaction();
+    void legacy_migration();
+
+private:
+    QStringList m_used_dirs;
+
+    QString use_dir(const QString& name);
+};
+
+void test_JsonCache::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void test_JsonCache::cleanupTestCase()
+{
+    for (const QString& dir : qAsConst(m_used_dirs))
+        QDir(cache_dir_path(dir)).removeRecursively();
+}
+
+QString test_JsonCache::use_dir(const QString& name)
+{
+    const QString dir = QStringLiteral("test_jsoncache_") + name;
+    QDir(cache_dir_path(dir)).removeRecursively();
+    m_used_dirs << dir;
+    return dir;
+}
+
+void test_JsonCache::put_read_data()
+{
+    QTest::addColumn<providers::JsonCacheFormat>("format");
+    QTest::addColumn<QString>("dir");
+
+    QTest::newRow("text") << providers::JsonCacheFormat::TEXT << QStringLiteral("text");
+    QTest::newRow("cbor") << providers::JsonCacheFormat::CBOR << QStringLiteral("cbor");
+}
+
+void test_JsonCache::put_read()
+{
+    QFETCH(providers::JsonCacheFormat, format);
+    QFETCH(QString, dir);
+
+    const QString provider_dir = use_dir(dir);
+    const QJsonDocument object = sample_object(QStringLiteral("first"));
+    const QJsonDocument array(QJsonArray { 1, 2, QStringLiteral("three") });
+
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("object"), object, format);
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("array"), array, format);
+
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("object")), object);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("array")), array);
+    QVERIFY(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("missing")).isNull());
+}
+
+void test_JsonCache::put_raw_text()
+{
+    const QString provider_dir = use_dir(QStringLiteral("raw"));
+    const QJsonDocument expected = sample_object(QStringLiteral("raw"));
+
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), expected.toJson());
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), expected);
+}
+
+void test_JsonCache::overwrite_remove()
+{
+    const QString provider_dir = use_dir(QStringLiteral("overwrite"));
+    const QJsonDocument first = sample_object(QStringLiteral("first"));
+    const QJsonDocument second = sample_object(QStringLiteral("second"));
+
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), first);
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("other"), first);
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), second, providers::JsonCacheFormat::TEXT);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), second);
+
+    providers::delete_cached_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"));
+    QVERIFY(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")).isNull());
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("other")), first);
+
+    // can be added again after removal
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), first);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), first);
+}
+
+void test_JsonCache::truncated_tail()
+{
+    const QString source_dir = use_dir(QStringLiteral("truncate_source"));
+    const QString provider_dir = use_dir(QStringLiteral("truncate"));
+    const QJsonDocument first = sample_object(QStringLiteral("first"));
+    const QJsonDocument second = sample_object(QStringLiteral("second"));
+
+    providers::cache_json(LOG_PREFIX, source_dir, QStringLiteral("first"), first);
+    providers::cache_json(LOG_PREFIX, source_dir, QStringLiteral("second"), second);
+
+    // a copy with the last record partially written, as after a crash
+    QVERIFY(QDir().mkpath(cache_dir_path(provider_dir)));
+    QVERIFY(QFile::copy(cache_file_path(source_dir), cache_file_path(provider_dir)));
+    {
+        QFile file(cache_file_path(provider_dir));
+        QVERIFY(file.resize(file.size() - 3));
+    }
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(".* is damaged after offset \\d+, the rest is dropped"));
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("first")), first);
+    QVERIFY(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("second")).isNull());
+
+    // the damaged part is gone, new entries are readable after the rest
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("second"), second);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("second")), second);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("first")), first);
+}
+
+void test_JsonCache::compaction()
+{
+    const QString provider_dir = use_dir(QStringLiteral("compaction"));
+    const QJsonDocument large = sample_object(QString(512 * 1024, QLatin1Char('x')));
+    const QJsonDocument small = sample_object(QStringLiteral("small"));
+
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("kept"), small);
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), large);
+    QVERIFY(QFileInfo(cache_file_path(provider_dir)).size() > 512 * 1024);
+
+    // the large entry becomes waste, which is now most of the file
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression(".*compacted cache file .*"));
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("entry"), small);
+    QVERIFY(QFileInfo(cache_file_path(provider_dir)).size() < 4 * 1024);
+
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), small);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("kept")), small);
+
+    // the entries written after the compaction are found too
+    providers::cache_json(LOG_PREFIX, provider_dir, QStringLiteral("new"), small);
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("new")), small);
+}
+
+void test_JsonCache::legacy_migration()
+{
+    const QString provider_dir = use_dir(QStringLiteral("legacy"));
+    const QJsonDocument expected = sample_object(QStringLiteral("legacy"));
+
+    const QString legacy_path = cache_dir_path(provider_dir) + QStringLiteral("/entry.json");
+    QVERIFY(QDir().mkpath(cache_dir_path(provider_dir)));
+    {
+        QFile file(legacy_path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QVERIFY(file.write(expected.toJson()) > 0);
+    }
+
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), expected);
+    QVERIFY(!QFileInfo::exists(legacy_path));
+
+    // now it's read from the cache file
+    QCOMPARE(providers::read_json_from_cache(LOG_PREFIX, provider_dir, QStringLiteral("entry")), expected);
+}
+
+
+QTEST_MAIN(test_JsonCache)
+#include "test_JsonCache.moc"
@@ -19,9 +19,13 @@
 
 #include "model/gaming/Collection.h"
 #include "model/gaming/Game.h"
+#include "providers/DynamicData.h"
+#include "providers/pegasus_playtime/PlaytimeSchema.h"
 #include "providers/pegasus_playtime/PlaytimeStats.h"
+#include "utils/SqliteDb.h"
 
 #include <QSqlDatabase>
+#include <QSqlQuery>
 
 using PlaytimeStats = providers::playtime::PlaytimeStats;
 
@@ -62,6 +66,36 @@ void create_dummy_data(QVector<model::Collection*>& collections,
     games.at(1)->setCollections({ collections.at(1) });
 }
 
+int count_plays(const QString& db_path, const QString& game_path)
+{
+    SqliteDb channel(db_path, QStringLiteral("test_count"));
+    if (!channel.open())
+        return -1;
+
+    QSqlQuery query(channel.handle());
+    query.prepare(QStringLiteral(
+        "SELECT COUNT(*) FROM plays"
+        " INNER JOIN paths ON plays.path_id=paths.id"
+        " WHERE paths.path = ?;"));
+    query.addBindValue(game_path);
+    if (!query.exec() || !query.next())
+        return -1;
+
+    return query.value(0).toInt();
+}
+
+// the files of the resources are read-only, so are their copies
+QString copy_test_db(bool writable)
+{
+    const QString db_path = QDir::tempPath() + QStringLiteral("/data.db");
+    QFile::setPermissions(db_path, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    QFile::remove(db_path);
+    QFile::copy(QStringLiteral(":/data.db"), db_path);
+    if (writable)
+        QFile::setPermissions(db_path, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    return db_path;
+}
+
 } // namespace
 
 
@@ -70,8 +104,13 @@ class test_Playtime : public QObject {
 
 private slots:
     void read();
+    void read_readonly();
+    void upgrade_old_schema();
+    void summary_trigger();
     void write();
     void write_queue();
+    void write_readback();
+    void write_on_exit();
 };
 
 void test_Playtime::read()
@@ -81,18 +120,107 @@ void test_Playtime::read()
     HashMap<QString, model::GameFile*> path_map;
     create_dummy_data(collections, games, path_map, this);
 
-    const QString db_path = QDir::tempPath() + QStringLiteral("/data.db");
-    QFile::remove(db_path);
-    QFile::copy(QStringLiteral(":/data.db"), db_path);
+    const QString db_path = copy_test_db(true);
 
 
     PlaytimeStats playtime;
     playtime.load_with_dbpath(db_path);
-    playtime.findDynamicData(collections, games, path_map);
+    providers::DynamicData dyndata;
+    playtime.findDynamicData(collections, games, path_map, dyndata);
+
+    // both the game and the file stats should notify their bindings once
+    model::GameFile* const gamefile = games.at(0)->filesConst().first();
+    QSignalSpy game_spy(games.at(0), &model::Game::playStatsChanged);
+    QSignalSpy file_spy(gamefile, &model::GameFile::playStatsChanged);
+    QVERIFY(game_spy.isValid() && file_spy.isValid());
+
+    providers::apply_dynamic_data(dyndata);
 
     QCOMPARE(games.at(0)->playCount(), 4);
     QCOMPARE(games.at(0)->playTime(), 35 /*sec*/);
     QCOMPARE(games.at(0)->lastPlayed(), QDateTime::fromSecsSinceEpoch(1531755039));
+    QCOMPARE(gamefile->playCount(), 4);
+    QCOMPARE(game_spy.count(), 1);
+    QCOMPARE(file_spy.count(), 1);
+}
+
+void test_Playtime::read_readonly()
+{
+    QVector<model::Collection*> collections;
+    QVector<model::Game*> games;
+    HashMap<QString, model::GameFile*> path_map;
+    create_dummy_data(collections, games, path_map, this);
+
+    // the summary table cannot be added, the stats are summed up from the plays
+    const QString db_path = copy_test_db(false);
+
+
+    PlaytimeStats playtime;
+    playtime.load_with_dbpath(db_path);
+    providers::DynamicData dyndata;
+    playtime.findDynamicData(collections, games, path_map, dyndata);
+    providers::apply_dynamic_data(dyndata);
+
+    QCOMPARE(games.at(0)->playCount(), 4);
+    QCOMPARE(games.at(0)->playTime(), 35 /*sec*/);
+    QCOMPARE(games.at(0)->lastPlayed(), QDateTime::fromSecsSinceEpoch(1531755039));
+}
+
+void test_Playtime::upgrade_old_schema()
+{
+    QVector<model::Collection*> collections;
+    QVector<model::Game*> games;
+    HashMap<QString, model::GameFile*> path_map;
+    create_dummy_data(collections, games, path_map, this);
+
+    const QString db_path = copy_test_db(true);
+
+    {
+        PlaytimeStats playtime;
+        playtime.load_with_dbpath(db_path);
+        providers::DynamicData dyndata;
+        playtime.findDynamicData(collections, games, path_map, dyndata);
+    }
+
+
+    SqliteDb channel(db_path, QStringLiteral("test_upgrade"));
+    QVERIFY(channel.open());
+    QVERIFY(channel.hasTable(QStringLiteral("play_summary")));
+
+    QSqlQuery query(channel.handle());
+    QVERIFY(query.exec(QStringLiteral(
+        "SELECT paths.path, play_count, play_time, last_played"
+        " FROM play_summary"
+        " INNER JOIN paths ON play_summary.path_id=paths.id;")));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toString(), QStringLiteral("dummy1"));
+    QCOMPARE(query.value(1).toInt(), 4);
+    QCOMPARE(query.value(2).toLongLong(), 35);
+    QCOMPARE(query.value(3).toLongLong(), 1531755039);
+    QVERIFY(!query.next());
+}
+
+void test_Playtime::summary_trigger()
+{
+    QTemporaryFile db_file;
+    QVERIFY(db_file.open());
+
+    SqliteDb channel(db_file.fileName(), QStringLiteral("test_trigger"));
+    QVERIFY(channel.open());
+    QVERIFY(providers::playtime::ensure_schema(channel));
+
+    QSqlQuery query(channel.handle());
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO paths VALUES(1, 'dummy1');")));
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO plays VALUES(null, 1, 1000, 30);")));
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO plays VALUES(null, 1, 5000, -5);")));
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO plays VALUES(null, 1, 2000, 60);")));
+
+    QVERIFY(query.exec(QStringLiteral(
+        "SELECT play_count, play_time, last_played FROM play_summary WHERE path_id = 1;")));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 3);
+    QCOMPARE(query.value(1).toLongLong(), 90); // negative durations are not counted
+    QCOMPARE(query.value(2).toLongLong(), 4995);
 }
 
 void test_Playtime::write()
@@ -161,6 +289,62 @@ void test_Playtime::write_queue()
     QCOMPARE(games.at(0)->property("playCount").toInt(), 3);
 }
 
+void test_Playtime::write_readback()
+{
+    QTemporaryFile game_file;
+    QVERIFY(game_file.open());
+    model::Game* const game = create_game(game_file.fileName(), this);
+    model::GameFile* const gamefile = game->filesConst().first();
+    const QString game_path = gamefile->fileinfo().canonicalFilePath();
+
+    QTemporaryFile db_file;
+    QVERIFY(db_file.open());
+
+
+    PlaytimeStats playtime;
+    playtime.load_with_dbpath(db_file.fileName());
+
+    QSignalSpy spy_end(&playtime, &providers::playtime::PlaytimeStats::finishedWriting);
+    QVERIFY(spy_end.isValid());
+
+    playtime.onGameLaunched(gamefile);
+    playtime.onGameFinished(gamefile);
+    playtime.onGameLaunched(gamefile);
+    playtime.onGameFinished(gamefile);
+
+    QVERIFY(spy_end.count() || spy_end.wait());
+    QCOMPARE(count_plays(db_file.fileName(), game_path), 2);
+}
+
+void test_Playtime::write_on_exit()
+{
+    QTemporaryFile game_file;
+    QVERIFY(game_file.open());
+    model::Game* const game = create_game(game_file.fileName(), this);
+    model::GameFile* const gamefile = game->filesConst().first();
+    const QString game_path = gamefile->fileinfo().canonicalFilePath();
+
+    QTemporaryFile db_file;
+    QVERIFY(db_file.open());
+
+    // the queued entries are written before the provider is gone
+    {
+        PlaytimeStats playtime;
+        playtime.load_with_dbpath(db_file.fileName());
+        playtime.onGameLaunched(gamefile);
+        playtime.onGameFinished(gamefile);
+    }
+    QCOMPARE(count_plays(db_file.fileName(), game_path), 1);
+
+    // same for unloading
+    PlaytimeStats playtime;
+    playtime.load_with_dbpath(db_file.fileName());
+    playtime.onGameLaunched(gamefile);
+    playtime.onGameFinished(gamefile);
+    playtime.unload();
+    QCOMPARE(count_plays(db_file.fileName(), game_path), 2);
+}
+
 
 QTEST_MAIN(test_Playtime)
 #include "test_Playtime.moc"
\ No newline at end of file
@@ -1,5 +1,6 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
+    jsoncache \
     pegasus \
     playtime \
@@ -0,0 +1,185 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "AppSettings.h"
+#include "Paths.h"
+#include "ScriptRunner.h"
+
+
+namespace {
+QString script_dir(const QString& event_dir)
+{
+    return paths::writableConfigDir() + QStringLiteral("/scripts/") + event_dir;
+}
+
+// The scripts get the log file as their first argument, and the path of a
+// file to wait for as the second one
+bool write_script(const QString& event_dir, const QString& name, const QByteArray& body)
+{
+    if (!QDir().mkpath(script_dir(event_dir)))
+        return false;
+
+    QFile file(script_dir(event_dir) + QLatin1Char('/') + name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write("#!/bin/sh\n" + body + '\n');
+    return file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+}
+
+QByteArray log_line(const QByteArray& text)
+{
+    return "echo " + text + " >> \"$1\"";
+}
+} // namespace
+
+
+class test_ScriptRunner : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void run_order();
+    void timeout();
+    // enables the cache for the rest of the tests
+    void cache_invalidation();
+
+private:
+    QTemporaryDir m_tmpdir;
+
+    QString log_path() const { return m_tmpdir.filePath(QStringLiteral("log.txt")); }
+    QString release_path() const { return m_tmpdir.filePath(QStringLiteral("release")); }
+    QStringList read_log() const;
+    QStringList run_and_read(ScriptEvent);
+};
+
+void test_ScriptRunner::initTestCase()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("The test scripts need a POSIX shell");
+#endif
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_tmpdir.isValid());
+    QVERIFY(paths::configDirs().contains(paths::writableConfigDir()));
+    cleanupTestCase();
+}
+
+void test_ScriptRunner::init()
+{
+    AppSettings::general.script_timeout_ms = 0;
+    QFile::remove(log_path());
+    QFile::remove(release_path());
+}
+
+void test_ScriptRunner::cleanupTestCase()
+{
+    QDir(paths::writableConfigDir() + QStringLiteral("/scripts")).removeRecursively();
+}
+
+QStringList test_ScriptRunner::read_log() const
+{
+    QFile file(log_path());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return {};
+
+    return QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'), QString::SkipEmptyParts);
+}
+
+QStringList test_ScriptRunner::run_and_read(ScriptEvent event)
+{
+    QFile::remove(log_path());
+    ScriptRunner::run(event, { log_path(), release_path() });
+    return read_log();
+}
+
+
+void test_ScriptRunner::run_order()
+{
+    const QString dir = QStringLiteral("settings-changed");
+    QVERIFY(write_script(dir, QStringLiteral("20-second.sh"), log_line("second")));
+    QVERIFY(write_script(dir, QStringLiteral("10-first.sh"), log_line("first")));
+    // the marker is only recognized after the first dot
+    QVERIFY(write_script(dir, QStringLiteral("parallel.sh"), log_line("named-parallel")));
+    // started first, but waited for only after the sequential ones
+    QVERIFY(write_script(dir, QStringLiteral("00-par.parallel.sh"), "sleep 0.5\n" + log_line("parallel")));
+    // not waited for at all; the first marker decides
+    QVERIFY(write_script(dir, QStringLiteral("30-det.detached.parallel.sh"),
+        "i=0\n"
+        "while [ ! -e \"$2\" ] && [ $i -lt 200 ]; do sleep 0.05; i=$((i+1)); done\n"
+        + log_line("detached")));
+
+    const QStringList expected {
+        QStringLiteral("first"),
+        QStringLiteral("second"),
+        QStringLiteral("named-parallel"),
+        QStringLiteral("parallel"),
+    };
+    QCOMPARE(run_and_read(ScriptEvent::SETTINGS_CHANGED), expected);
+
+    QFile release(release_path());
+    QVERIFY(release.open(QIODevice::WriteOnly));
+    release.close();
+    QTRY_COMPARE(read_log(), QStringList(expected) << QStringLiteral("detached"));
+}
+
+void test_ScriptRunner::timeout()
+{
+    const QString dir = QStringLiteral("controls-changed");
+    QVERIFY(write_script(dir, QStringLiteral("10-slow.sh"), "sleep 5\n" + log_line("slow")));
+    QVERIFY(write_script(dir, QStringLiteral("20-fast.sh"), log_line("fast")));
+
+    AppSettings::general.script_timeout_ms = 200;
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("`.*10-slow\\.sh` did not finish in 200 ms, stopping it"));
+
+    QElapsedTimer timer;
+    timer.start();
+    QCOMPARE(run_and_read(ScriptEvent::CONTROLS_CHANGED), QStringList { QStringLiteral("fast") });
+    QVERIFY(timer.elapsed() < 5000);
+}
+
+void test_ScriptRunner::cache_invalidation()
+{
+    ScriptRunner::watchScriptDirs();
+
+    const QString dir = QStringLiteral("game-start");
+    QVERIFY(write_script(dir, QStringLiteral("10-a.sh"), log_line("a")));
+    QCOMPARE(run_and_read(ScriptEvent::PROCESS_STARTED), QStringList { QStringLiteral("a") });
+    // lets the found directories get watched
+    QTest::qWait(100);
+
+    // the change is not seen until the watcher reports it
+    QVERIFY(write_script(dir, QStringLiteral("20-b.sh"), log_line("b")));
+    QCOMPARE(run_and_read(ScriptEvent::PROCESS_STARTED), QStringList { QStringLiteral("a") });
+    QTRY_COMPARE(run_and_read(ScriptEvent::PROCESS_STARTED),
+                 (QStringList { QStringLiteral("a"), QStringLiteral("b") }));
+
+    // a missing event directory is noticed when it gets created
+    QVERIFY(run_and_read(ScriptEvent::QUIT).isEmpty());
+    QTest::qWait(100);
+    QVERIFY(write_script(QStringLiteral("quit"), QStringLiteral("10-c.sh"), log_line("c")));
+    QVERIFY(run_and_read(ScriptEvent::QUIT).isEmpty());
+    QTRY_COMPARE(run_and_read(ScriptEvent::QUIT), QStringList { QStringLiteral("c") });
+}
+
+
+QTEST_MAIN(test_ScriptRunner)
+#include "test_ScriptRunner.moc"
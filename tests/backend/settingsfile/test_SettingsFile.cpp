@@ -0,0 +1,305 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "AppSettings.h"
+#include "Paths.h"
+#include "parsers/SettingsFile.h"
+#include "providers/Provider.h"
+#include "types/GamepadKeyId.h"
+
+
+namespace {
+constexpr KeyEvent CONFIG_KEY_EVENTS[] {
+    KeyEvent::ACCEPT,
+    KeyEvent::CANCEL,
+    KeyEvent::DETAILS,
+    KeyEvent::FILTERS,
+    KeyEvent::NEXT_PAGE,
+    KeyEvent::PREV_PAGE,
+    KeyEvent::PAGE_UP,
+    KeyEvent::PAGE_DOWN,
+    KeyEvent::MAIN_MENU,
+};
+
+void reset_settings()
+{
+    AppSettings::general.fullscreen = false;
+    AppSettings::general.mouse_support = true;
+    AppSettings::general.pregen_thumbnails = true;
+    AppSettings::general.startup_hook_timeout_ms = 30000;
+    AppSettings::general.script_timeout_ms = 0;
+    AppSettings::general.locale.clear();
+    AppSettings::general.theme = AppSettings::general.DEFAULT_THEME;
+    AppSettings::keys.resetAll();
+}
+} // namespace
+
+
+class test_SettingsFile : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void empty();
+    void comments();
+    void byte_order_mark();
+    void multiline();
+    void multiline_provider();
+    void value_missing();
+    void unknown_option();
+    void unknown_option_data();
+    void error_lines();
+    void save_load();
+
+private:
+    QTemporaryDir m_tmpdir;
+    QString m_config_path;
+
+    void load_text(const QByteArray& utf8);
+    void expect_error(size_t lineno, const QString& msg);
+};
+
+void test_SettingsFile::initTestCase()
+{
+    QVERIFY(m_tmpdir.isValid());
+    m_config_path = m_tmpdir.path() + QStringLiteral("/settings.txt");
+}
+
+void test_SettingsFile::init()
+{
+    reset_settings();
+}
+
+void test_SettingsFile::load_text(const QByteArray& utf8)
+{
+    QFile file(m_config_path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(utf8), static_cast<qint64>(utf8.size()));
+    file.close();
+
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Program settings loaded .*"));
+    appsettings::LoadContext(m_config_path).load();
+}
+
+void test_SettingsFile::expect_error(size_t lineno, const QString& msg)
+{
+    QTest::ignoreMessage(QtWarningMsg, qPrintable(QStringLiteral("`%1`, line %2: %3")
+        .arg(m_config_path, QString::number(lineno), msg)));
+}
+
+
+void test_SettingsFile::empty()
+{
+    load_text(QByteArray());
+
+    QCOMPARE(AppSettings::general.fullscreen, false);
+    QCOMPARE(AppSettings::general.theme, AppSettings::general.DEFAULT_THEME);
+}
+
+void test_SettingsFile::comments()
+{
+    load_text(
+        "# general.fullscreen: true\n"
+        "general.input-mouse-support: false\n"
+        "#general.locale: hu\n"
+        "general.pregenerate-thumbnails: false\n"
+        "# the end\n");
+
+    QCOMPARE(AppSettings::general.fullscreen, false);
+    QCOMPARE(AppSettings::general.mouse_support, false);
+    QCOMPARE(AppSettings::general.pregen_thumbnails, false);
+    QCOMPARE(AppSettings::general.locale, QString());
+}
+
+void test_SettingsFile::byte_order_mark()
+{
+    // the BOM is directly before the first key
+    load_text(
+        "\xEF\xBB\xBF" "general.fullscreen: true\n"
+        "general.locale: hu\n");
+
+    QCOMPARE(AppSettings::general.fullscreen, true);
+    QCOMPARE(AppSettings::general.locale, QStringLiteral("hu"));
+}
+
+void test_SettingsFile::multiline()
+{
+    load_text(
+        "general.locale:\n"
+        "  first\n"
+        "  .\n"
+        "\tsecond\n"
+        "    third\n"
+        "general.fullscreen: true\n");
+
+    QCOMPARE(AppSettings::general.locale, QStringLiteral("first\n\nsecond third"));
+    QCOMPARE(AppSettings::general.fullscreen, true);
+}
+
+void test_SettingsFile::multiline_provider()
+{
+    // NOTE: every provider in this tree is internal, so their options are
+    // rejected; the lines of the entry must be skipped as a whole though
+    const auto provider_it = std::find_if(
+        AppSettings::providers.cbegin(),
+        AppSettings::providers.cend(),
+        [](const decltype(AppSettings::providers)::value_type& p){
+            return p->codename() == QLatin1String("pegasus_favorites");
+        });
+    QVERIFY(provider_it != AppSettings::providers.cend());
+
+    expect_error(1, QStringLiteral("unrecognized option `providers.pegasus_favorites.paths`, ignored"));
+    load_text(
+        "providers.pegasus_favorites.paths:\n"
+        "  first\n"
+        "  .\n"
+        "  second\n"
+        "general.fullscreen: true\n");
+
+    QVERIFY((*provider_it)->options().empty());
+    QCOMPARE(AppSettings::general.fullscreen, true);
+}
+
+void test_SettingsFile::value_missing()
+{
+    expect_error(1, QStringLiteral("attribute value missing, entry ignored"));
+    expect_error(4, QStringLiteral("attribute value missing, entry ignored"));
+    load_text(
+        "general.locale:\n"
+        "\n"
+        "general.fullscreen: true\n"
+        "general.theme:");
+
+    QCOMPARE(AppSettings::general.locale, QString());
+    QCOMPARE(AppSettings::general.fullscreen, true);
+    QCOMPARE(AppSettings::general.theme, AppSettings::general.DEFAULT_THEME);
+}
+
+void test_SettingsFile::unknown_option_data()
+{
+    QTest::addColumn<QByteArray>("line");
+    QTest::addColumn<QString>("key");
+
+    QTest::newRow("no category")
+        << QByteArray("fullscreen: true") << QStringLiteral("fullscreen");
+    QTest::newRow("unknown category")
+        << QByteArray("display.fullscreen: true") << QStringLiteral("display.fullscreen");
+    QTest::newRow("unknown general option")
+        << QByteArray("general.fullscreenx: true") << QStringLiteral("general.fullscreenx");
+    QTest::newRow("unknown key event")
+        << QByteArray("keys.jump: Space") << QStringLiteral("keys.jump");
+    QTest::newRow("unknown provider")
+        << QByteArray("providers.nope.enabled: false") << QStringLiteral("providers.nope.enabled");
+    QTest::newRow("internal provider")
+        << QByteArray("providers.pegasus_favorites.enabled: false") << QStringLiteral("providers.pegasus_favorites.enabled");
+    // these have the same FNV-1a hash as `pregenerate-thumbnails` and `page-down`
+    QTest::newRow("general option hash collision")
+        << QByteArray("general.ylvgfh: false") << QStringLiteral("general.ylvgfh");
+    QTest::newRow("key event hash collision")
+        << QByteArray("keys.blilxyz: none") << QStringLiteral("keys.blilxyz");
+}
+
+void test_SettingsFile::unknown_option()
+{
+    QFETCH(QByteArray, line);
+    QFETCH(QString, key);
+
+    const QVector<QKeySequence> page_down_keys = AppSettings::keys.at(KeyEvent::PAGE_DOWN);
+
+    expect_error(1, QStringLiteral("unrecognized option `%1`, ignored").arg(key));
+    load_text(line + '\n');
+
+    QCOMPARE(AppSettings::general.fullscreen, false);
+    QCOMPARE(AppSettings::general.pregen_thumbnails, true);
+    QCOMPARE(AppSettings::keys.at(KeyEvent::PAGE_DOWN), page_down_keys);
+    for (const auto& provider : AppSettings::providers)
+        QCOMPARE(provider->enabled(), true);
+}
+
+void test_SettingsFile::error_lines()
+{
+    expect_error(2, QStringLiteral("line starts with whitespace, but no attribute has been defined yet"));
+    expect_error(3, QStringLiteral("line invalid, skipped"));
+    expect_error(4, QStringLiteral("line invalid, skipped"));
+    expect_error(5, QStringLiteral("this option (`general.fullscreen`) must be a boolean (true/false) value"));
+    expect_error(7, QStringLiteral("this option (`general.script-timeout`) must be a whole number"));
+    expect_error(11, QStringLiteral("unrecognized option `general.unknown`, ignored"));
+    load_text(
+        "# comment\n"
+        "  value before any key\n"
+        "no colon here\n"
+        ": no key\n"
+        "general.fullscreen: maybe\n"
+        "\n"
+        "general.script-timeout:\n"
+        "  12\n"
+        "  seconds\n"
+        "general.startup-hook-timeout: 500\n"
+        "general.unknown: 1\n");
+
+    QCOMPARE(AppSettings::general.fullscreen, false);
+    QCOMPARE(AppSettings::general.script_timeout_ms, 0);
+    QCOMPARE(AppSettings::general.startup_hook_timeout_ms, 500);
+}
+
+void test_SettingsFile::save_load()
+{
+    AppSettings::general.fullscreen = true;
+    AppSettings::general.mouse_support = false;
+    AppSettings::general.pregen_thumbnails = false;
+    AppSettings::general.startup_hook_timeout_ms = 1234;
+    AppSettings::general.script_timeout_ms = 5678;
+    AppSettings::general.locale = QStringLiteral("hu");
+    AppSettings::general.theme = paths::writableConfigDir() + QStringLiteral("/themes/mine");
+
+    AppSettings::keys.clear(KeyEvent::ACCEPT);
+    AppSettings::keys.add_key(KeyEvent::ACCEPT, QKeySequence(Qt::Key_Space));
+    AppSettings::keys.add_key(KeyEvent::ACCEPT, QKeySequence(GamepadKeyId::A));
+    AppSettings::keys.clear(KeyEvent::CANCEL);
+    AppSettings::keys.add_key(KeyEvent::DETAILS, QKeySequence(Qt::Key_Comma));
+    AppSettings::keys.add_key(KeyEvent::MAIN_MENU, QKeySequence(Qt::CTRL + Qt::Key_M));
+
+    std::vector<QVector<QKeySequence>> expected_keys;
+    for (const KeyEvent event : CONFIG_KEY_EVENTS)
+        expected_keys.push_back(AppSettings::keys.at(event));
+
+    QTest::ignoreMessage(QtInfoMsg, "Program settings saved");
+    appsettings::SaveContext(m_config_path).save();
+
+    reset_settings();
+    QTest::ignoreMessage(QtInfoMsg, QRegularExpression("Program settings loaded .*"));
+    appsettings::LoadContext(m_config_path).load();
+
+    QCOMPARE(AppSettings::general.fullscreen, true);
+    QCOMPARE(AppSettings::general.mouse_support, false);
+    QCOMPARE(AppSettings::general.pregen_thumbnails, false);
+    QCOMPARE(AppSettings::general.startup_hook_timeout_ms, 1234);
+    QCOMPARE(AppSettings::general.script_timeout_ms, 5678);
+    QCOMPARE(AppSettings::general.locale, QStringLiteral("hu"));
+    QCOMPARE(AppSettings::general.theme, paths::writableConfigDir() + QStringLiteral("/themes/mine"));
+
+    for (size_t i = 0; i < expected_keys.size(); i++)
+        QCOMPARE(AppSettings::keys.at(CONFIG_KEY_EVENTS[i]), expected_keys.at(i));
+}
+
+
+QTEST_MAIN(test_SettingsFile)
+#include "test_SettingsFile.moc"
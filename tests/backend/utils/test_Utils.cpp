@@ -17,6 +17,7 @@
 
 #include <QtTest/QtTest>
 
+#include "utils/CommandTemplate.h"
 #include "utils/CommandTokenizer.h"
 #include "utils/PathCheck.h"
 #include "utils/StdStringHelpers.h"
@@ -36,6 +37,9 @@ private slots:
     void escape_command();
     void escape_command_data();
 
+    void command_template();
+    void command_template_data();
+
     void trimmed_str();
     void trimmed_str_data();
 };
@@ -106,6 +110,46 @@ void test_Utils::escape_command_data()
     QTest::newRow("mixed") << "test's \"my\" cmd" << "test's \"my\" cmd"; // no change
 }
 
+void test_Utils::command_template()
+{
+    QFETCH(QString, str);
+    QFETCH(QStringList, expected);
+    QFETCH(QStringList, unknown);
+
+    const QFileInfo finfo(QStringLiteral("/some/dir/my game.v1.zip"));
+    const auto tmpl = utils::CommandTemplate::fromCommand(str);
+    QCOMPARE(tmpl.expand(finfo), expected);
+    QCOMPARE(tmpl.unknownPlaceholders(), unknown);
+}
+
+void test_Utils::command_template_data()
+{
+    qputenv("PEGASUS_TEST_VAR", "val");
+
+    const QFileInfo finfo(QStringLiteral("/some/dir/my game.v1.zip"));
+    const QString path = QDir::toNativeSeparators(finfo.absoluteFilePath());
+    const QString dir = QDir::toNativeSeparators(finfo.absolutePath());
+
+    QTest::addColumn<QString>("str");
+    QTest::addColumn<QStringList>("expected");
+    QTest::addColumn<QStringList>("unknown");
+
+    QTest::newRow("null") << QString() << QStringList() << QStringList();
+    QTest::newRow("no placeholders") << "test a 'b c'" << QStringList({"test","a","b c"}) << QStringList();
+    QTest::newRow("file") << "test {file.path}"
+        << QStringList({"test", path}) << QStringList();
+    QTest::newRow("file parts") << "test {file.name} {file.basename} {file.dir}"
+        << QStringList({"test", "my game.v1.zip", "my game.v1", dir}) << QStringList();
+    QTest::newRow("in arg") << "test --rom={file.basename}.bin x{file.name}{file.name}"
+        << QStringList({"test", "--rom=my game.v1.bin", "xmy game.v1.zipmy game.v1.zip"}) << QStringList();
+    QTest::newRow("env") << "test {env.PEGASUS_TEST_VAR}/x {env.PEGASUS_TEST_MISSING}"
+        << QStringList({"test", "val/x", ""}) << QStringList();
+    QTest::newRow("unknown") << "test {file.size} {other} {{file.name}"
+        << QStringList({"test", "{file.size}", "{other}", "{my game.v1.zip"}) << QStringList({"{file.size}"});
+    QTest::newRow("unclosed") << "test {file.path {env.PEGASUS_TEST_VAR"
+        << QStringList({"test", "{file.path", "{env.PEGASUS_TEST_VAR"}) << QStringList();
+}
+
 void test_Utils::trimmed_str()
 {
     QFETCH(QString, str);
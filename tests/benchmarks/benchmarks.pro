@@ -3,3 +3,4 @@ TEMPLATE = subdirs
 SUBDIRS += \
     configfile \
     pegasus_provider \
+    scan_pipeline \
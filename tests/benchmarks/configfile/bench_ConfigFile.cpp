@@ -18,6 +18,7 @@
 #include <QtTest/QtTest>
 
 #include "parsers/MetaFile.h"
+#include "parsers/SettingsFile.h"
 
 
 class bench_ConfigFile : public QObject {
@@ -27,7 +28,13 @@ private slots:
     void empty();
     void file();
 
+    void settings_load();
+    void settings_save();
+    void settings_roundtrip();
+
 private:
+    QTemporaryDir m_tmp_dir;
+
     std::vector<metafile::Entry> m_entries;
 
     void onAttributeFound(const metafile::Entry&);
@@ -79,6 +86,41 @@ void bench_ConfigFile::file()
     }
 }
 
+void bench_ConfigFile::settings_load()
+{
+    const appsettings::LoadContext loader(QStringLiteral(":/settings.txt"));
+
+    QBENCHMARK {
+        loader.load();
+    }
+}
+
+void bench_ConfigFile::settings_save()
+{
+    QVERIFY(m_tmp_dir.isValid());
+    const appsettings::SaveContext saver(m_tmp_dir.filePath(QStringLiteral("settings_save.txt")));
+
+    QBENCHMARK {
+        saver.save();
+    }
+}
+
+void bench_ConfigFile::settings_roundtrip()
+{
+    QVERIFY(m_tmp_dir.isValid());
+    const QString path = m_tmp_dir.filePath(QStringLiteral("settings_roundtrip.txt"));
+    QVERIFY(QFile::copy(QStringLiteral(":/settings.txt"), path));
+    QVERIFY(QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner));
+
+    const appsettings::LoadContext loader(path);
+    const appsettings::SaveContext saver(path);
+
+    QBENCHMARK {
+        loader.load();
+        saver.save();
+    }
+}
+
 
 QTEST_MAIN(bench_ConfigFile)
 #include "bench_ConfigFile.moc"
@@ -0,0 +1,244 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "LibraryGenerator.h"
+
+#include "providers/pegasus_playtime/PlaytimeSchema.h"
+#include "utils/SqliteDb.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QTextStream>
+
+
+namespace {
+// every Nth game gets a favorite, whitelist or play time entry
+static constexpr int FAVORITE_EVERY = 10;
+static constexpr int WHITELIST_EVERY = 20;
+static constexpr int PLAYED_EVERY = 5;
+static constexpr int PLAYS_PER_GAME = 3;
+
+const QString MEDIA_FILES[] {
+    QStringLiteral("boxFront.png"),
+    QStringLiteral("screenshot.jpg"),
+    QStringLiteral("logo.png"),
+    QStringLiteral("video.mp4"),
+    QStringLiteral("background.jpg"),
+    QStringLiteral("boxBack.png"),
+    QStringLiteral("marquee.png"),
+    QStringLiteral("titlescreen.png"),
+};
+constexpr int MEDIA_FILE_CNT = sizeof(MEDIA_FILES) / sizeof(MEDIA_FILES[0]);
+
+
+bool touch(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().noquote() << QStringLiteral("could not create `%1`").arg(path);
+        return false;
+    }
+    return true;
+}
+
+QString game_basename(int coll_idx, int game_idx)
+{
+    return QStringLiteral("game_%1_%2")
+        .arg(coll_idx, 3, 10, QLatin1Char('0'))
+        .arg(game_idx, 5, 10, QLatin1Char('0'));
+}
+
+QString game_title(int coll_idx, int game_idx)
+{
+    return QStringLiteral("Game %1-%2").arg(coll_idx).arg(game_idx);
+}
+
+bool is_listed(const LibraryConfig& config, int game_idx)
+{
+    return config.unlisted_every <= 0
+        || game_idx % config.unlisted_every != config.unlisted_every - 1;
+}
+
+void write_game_entry(QTextStream& stream, int coll_idx, int game_idx,
+                      const QStringList& files, int& entry_cnt)
+{
+    stream << "game: " << game_title(coll_idx, game_idx) << '\n';
+    if (files.size() == 1) {
+        stream << "file: " << files.first() << '\n';
+    }
+    else {
+        stream << "files:\n";
+        for (const QString& file : files)
+            stream << "  " << file << '\n';
+    }
+    stream << "developer: Developer " << (game_idx % 97) << '\n'
+           << "publisher: Publisher " << (game_idx % 31) << '\n'
+           << "genre: Genre " << (game_idx % 13) << ", Genre " << (game_idx % 7) << '\n'
+           << "release: " << (1980 + game_idx % 40) << '-'
+               << QString::number(1 + game_idx % 12).rightJustified(2, QLatin1Char('0')) << '-'
+               << QString::number(1 + game_idx % 28).rightJustified(2, QLatin1Char('0')) << '\n'
+           << "players: 1-" << (1 + game_idx % 4) << '\n'
+           << "rating: " << (game_idx % 101) << "%\n"
+           << "description: A synthetic game, number " << game_idx
+               << " of collection " << coll_idx << ".\n"
+           << "  It has a second paragraph of description too, to make the entry\n"
+           << "  about as long as the ones found in scraped metafiles.\n"
+           << '\n';
+    entry_cnt += 9;
+}
+
+void write_path_list(const QString& path, const QStringList& lines)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning().noquote() << QStringLiteral("could not create `%1`").arg(path);
+        return;
+    }
+
+    QTextStream stream(&file);
+    for (const QString& line : lines)
+        stream << line << '\n';
+}
+
+void write_playtime_db(const QString& db_path, const QStringList& played_paths)
+{
+    SqliteDb channel(db_path, QStringLiteral("library_generator"));
+    if (!channel.open() || !providers::playtime::ensure_schema(channel)) {
+        qWarning().noquote() << QStringLiteral("could not create `%1`").arg(db_path);
+        return;
+    }
+
+    channel.startTransaction();
+
+    QSqlQuery insert_path(channel.handle());
+    insert_path.prepare(QStringLiteral("INSERT INTO paths(path) VALUES(?);"));
+    QSqlQuery insert_play(channel.handle());
+    insert_play.prepare(QStringLiteral("INSERT INTO plays VALUES(null, ?, ?, ?);"));
+
+    qint64 start_time = 1500000000;
+    for (const QString& path : played_paths) {
+        insert_path.addBindValue(path);
+        if (!insert_path.exec())
+            continue;
+
+        const QVariant path_id = insert_path.lastInsertId();
+        for (int i = 0; i < PLAYS_PER_GAME; i++) {
+            insert_play.addBindValue(path_id);
+            insert_play.addBindValue(start_time);
+            insert_play.addBindValue(600 + i * 60);
+            insert_play.exec();
+            start_time += 3600;
+        }
+    }
+
+    channel.commit();
+}
+} // namespace
+
+
+GeneratedLibrary generate_library(const QString& root_dir, const LibraryConfig& config)
+{
+    GeneratedLibrary library;
+
+    const QDir root(QFileInfo(root_dir).canonicalFilePath());
+    const int media_per_game = qBound(0, config.media_per_game, MEDIA_FILE_CNT);
+
+    QStringList favorites;
+    QStringList whitelists;
+    QStringList played;
+    int game_serial = 0;
+
+    for (int coll_idx = 0; coll_idx < config.collections; coll_idx++) {
+        const QString coll_dirname = QStringLiteral("collection_%1").arg(coll_idx, 3, 10, QLatin1Char('0'));
+        root.mkpath(coll_dirname + QStringLiteral("/media"));
+
+        const QDir coll_dir(root.filePath(coll_dirname));
+        const QString metafile_path = coll_dir.filePath(QStringLiteral("metadata.txt"));
+        library.game_dirs.push_back(coll_dir.path());
+        library.metafiles.push_back(metafile_path);
+
+        QFile metafile(metafile_path);
+        if (!metafile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning().noquote() << QStringLiteral("could not create `%1`").arg(metafile_path);
+            continue;
+        }
+        QTextStream stream(&metafile);
+
+        stream << "collection: Collection " << coll_idx << '\n'
+               << "shortname: coll" << coll_idx << '\n'
+               << "extension: bin\n"
+               << "launch: emulator --fullscreen {file.path}\n"
+               << '\n';
+        library.metafile_entry_cnt += 4;
+
+        for (int game_idx = 0; game_idx < config.games_per_collection; game_idx++, game_serial++) {
+            const QString basename = game_basename(coll_idx, game_idx);
+            const bool listed = is_listed(config, game_idx);
+
+            // only the listed games can have multiple files, the others
+            // would be found as separate games
+            QStringList files;
+            if (listed && config.files_per_game > 1) {
+                for (int disc = 1; disc <= config.files_per_game; disc++)
+                    files << QStringLiteral("%1_disc%2.bin").arg(basename).arg(disc);
+            }
+            else {
+                files << basename + QStringLiteral(".bin");
+            }
+
+            for (const QString& file : qAsConst(files))
+                touch(coll_dir.filePath(file));
+
+            // the media of the listed games is matched by the title,
+            // the rest by the file name
+            const QString media_dir = coll_dir.filePath(QStringLiteral("media/")
+                + (listed ? game_title(coll_idx, game_idx) : basename));
+            if (media_per_game > 0)
+                coll_dir.mkpath(media_dir);
+            for (int i = 0; i < media_per_game; i++)
+                touch(media_dir + QLatin1Char('/') + MEDIA_FILES[i]);
+
+            if (listed)
+                write_game_entry(stream, coll_idx, game_idx, files, library.metafile_entry_cnt);
+
+            const QString first_path = coll_dir.filePath(files.first());
+            if (game_serial % FAVORITE_EVERY == 0)
+                favorites << first_path;
+            if (game_serial % WHITELIST_EVERY == 0)
+                whitelists << first_path;
+            if (game_serial % PLAYED_EVERY == 0)
+                played << first_path;
+
+            library.game_cnt++;
+            library.file_cnt += files.size();
+            library.media_cnt += media_per_game;
+        }
+    }
+
+    library.favorites_path = root.filePath(QStringLiteral("favorites.txt"));
+    library.whitelists_path = root.filePath(QStringLiteral("whitelists.txt"));
+    library.playtime_path = root.filePath(QStringLiteral("stats.db"));
+
+    write_path_list(library.favorites_path, favorites);
+    write_path_list(library.whitelists_path, whitelists);
+    write_playtime_db(library.playtime_path, played);
+
+    return library;
+}
@@ -0,0 +1,57 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QString>
+#include <vector>
+
+
+/// The shape of a synthetic game library
+struct LibraryConfig {
+    int collections;
+    int games_per_collection;
+    /// Games listed in the metafile have this many files (eg. discs)
+    int files_per_game;
+    /// Number of media files per game, at most 8
+    int media_per_game;
+    /// Every Nth game of a collection has no metafile entry, and is only
+    /// found by the extension filter; 0 means every game is listed
+    int unlisted_every;
+};
+
+/// A library written to the disk by `generate_library`
+struct GeneratedLibrary {
+    /// The collection directories, each with its own metafile
+    std::vector<QString> game_dirs;
+    std::vector<QString> metafiles;
+
+    QString favorites_path;
+    QString whitelists_path;
+    QString playtime_path;
+
+    int game_cnt = 0;
+    int file_cnt = 0;
+    int media_cnt = 0;
+    int metafile_entry_cnt = 0;
+};
+
+/// Creates a library under the (existing) root directory. The game files
+/// and media are empty, the metafiles contain the usual game fields, and
+/// favorites, whitelists and play time entries are added for a part of the
+/// games. Returns the paths of the created files.
+GeneratedLibrary generate_library(const QString& root_dir, const LibraryConfig&);
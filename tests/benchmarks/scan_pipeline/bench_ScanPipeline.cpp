@@ -0,0 +1,385 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QtTest/QtTest>
+
+#include "LibraryGenerator.h"
+
+#include "model/gaming/Collection.h"
+#include "model/gaming/Facets.h"
+#include "model/gaming/Game.h"
+#include "parsers/MetaFile.h"
+#include "providers/DynamicData.h"
+#include "providers/SearchContext.h"
+#include "providers/pegasus_favorites/Favorites.h"
+#include "providers/pegasus_metadata/PegasusMedia.h"
+#include "providers/pegasus_metadata/PegasusMetadataConstants.h"
+#include "providers/pegasus_metadata/PegasusMetadataFilter.h"
+#include "providers/pegasus_metadata/PegasusMetadataParser.h"
+#include "providers/pegasus_playtime/PlaytimeStats.h"
+#include "providers/pegasus_whitelists/Whitelists.h"
+#include "utils/HashMap.h"
+
+#include "QtQmlTricks/QQmlObjectListModel.h"
+#include <QElapsedTimer>
+#include <map>
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#endif
+
+using namespace providers::pegasus;
+
+
+namespace {
+// The steps of the scanning, in the order they run in the app
+enum class Stage : unsigned char {
+    PARSE_METAFILES,
+    WALK_FILTERS,
+    FINALIZE_LISTS,
+    FIND_ASSETS,
+    CONSUME,
+    FACET_INDEX,
+    STATIC_DATA_HANDOVER,
+    DYNAMIC_DATA,
+};
+
+struct PipelineState {
+    providers::SearchContext sctx;
+    std::vector<parser::FileFilter> filters;
+
+    QVector<model::Collection*> collections;
+    QVector<model::Game*> games;
+    model::FacetIndex facets;
+
+    // the objects filled by ApiObject::onStaticDataLoaded
+    QObject api;
+    QQmlObjectListModel<model::Collection> collection_model;
+    QQmlObjectListModel<model::Game> game_model;
+    model::Facets facet_model;
+
+    ~PipelineState()
+    {
+        // the consumed objects are only owned by the Api after the handover
+        for (model::Collection* const coll : qAsConst(collections)) {
+            if (!coll->parent())
+                delete coll;
+        }
+        for (model::Game* const game : qAsConst(games)) {
+            if (!game->parent())
+                delete game;
+        }
+    }
+};
+
+
+// Same as `collect_metadata`, without the global metafiles
+void parse_metafiles(const GeneratedLibrary& library, PipelineState& state)
+{
+    const parser::Constants constants;
+
+    for (size_t i = 0; i < library.game_dirs.size(); i++) {
+        state.sctx.add_game_root_dir(library.game_dirs.at(i));
+
+        const QString& metafile_path = library.metafiles.at(i);
+        parser::Parser parser(metafile_path, constants);
+        metafile::read_file(metafile_path,
+            [&](const metafile::Entry& entry){ parser.parse_entry(entry, state.sctx, state.filters); },
+            [&](const metafile::Error& error){ parser.print_error(error.line, error.message); });
+    }
+}
+
+void walk_filters(PipelineState& state)
+{
+    parser::tidy_filters(state.filters);
+    parser::process_filters(state.filters, state.sctx);
+
+    for (parser::FileFilter& filter : state.filters) {
+        for (QString& dir : filter.directories)
+            state.sctx.add_game_root_dir(std::move(dir));
+    }
+}
+
+// Same as ApiObject::onStaticDataLoaded, with the Api slots replaced
+void static_data_handover(PipelineState& state)
+{
+    QObject* const api = &state.api;
+
+    for (model::Game* const game : qAsConst(state.games)) {
+        game->setParent(api);
+
+        QObject::connect(game, &model::Game::launchFileSelectorRequested, api, []{});
+        QObject::connect(game, &model::Game::favoriteChanged, api, []{});
+        QObject::connect(game, &model::Game::whitelistChanged, api, []{});
+
+        for (model::GameFile* const gamefile : game->filesConst())
+            QObject::connect(gamefile, &model::GameFile::launchRequested, api, []{});
+    }
+    for (model::Collection* const coll : qAsConst(state.collections))
+        coll->setParent(api);
+
+    state.game_model.append(state.games);
+    state.collection_model.append(state.collections);
+    state.facet_model.setIndex(std::move(state.facets));
+}
+
+// Same as ProviderManager::startDynamicSearch and onDynamicDataFound
+void find_dynamic_data(const GeneratedLibrary& library, PipelineState& state)
+{
+    providers::favorites::Favorites favorites;
+    favorites.load_with_dbpath(library.favorites_path);
+    providers::whitelists::Whitelists whitelists;
+    whitelists.load_with_dbpath(library.whitelists_path);
+    providers::playtime::PlaytimeStats playtime;
+    playtime.load_with_dbpath(library.playtime_path);
+
+    HashMap<QString, model::GameFile*> path_map;
+    for (model::Game* const game : qAsConst(state.games)) {
+        for (model::GameFile* const gamefile : game->filesConst()) {
+            QString path = gamefile->fileinfo().canonicalFilePath();
+            if (Q_LIKELY(!path.isEmpty()))
+                path_map.emplace(std::move(path), gamefile);
+        }
+    }
+
+    providers::DynamicData data;
+    favorites.findDynamicData(state.collections, state.games, path_map, data);
+    whitelists.findDynamicData(state.collections, state.games, path_map, data);
+    playtime.findDynamicData(state.collections, state.games, path_map, data);
+
+    providers::apply_dynamic_data(data);
+}
+
+void run_stage(Stage stage, const GeneratedLibrary& library, PipelineState& state)
+{
+    switch (stage) {
+        case Stage::PARSE_METAFILES:
+            parse_metafiles(library, state);
+            break;
+        case Stage::WALK_FILTERS:
+            walk_filters(state);
+            break;
+        case Stage::FINALIZE_LISTS:
+            state.sctx.finalize_lists();
+            break;
+        case Stage::FIND_ASSETS:
+            find_assets(state.sctx.game_root_dirs(), state.sctx);
+            break;
+        case Stage::CONSUME:
+            std::tie(state.collections, state.games) = state.sctx.consume();
+            break;
+        case Stage::FACET_INDEX:
+            state.facets = model::build_facet_index(state.games);
+            break;
+        case Stage::STATIC_DATA_HANDOVER:
+            static_data_handover(state);
+            break;
+        case Stage::DYNAMIC_DATA:
+            find_dynamic_data(library, state);
+            break;
+    }
+}
+
+
+#if defined(Q_OS_LINUX)
+qint64 status_field_kb(const QByteArray& field)
+{
+    QFile file(QStringLiteral("/proc/self/status"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    for (QByteArray line = file.readLine(); !line.isEmpty(); line = file.readLine()) {
+        if (line.startsWith(field))
+            return line.mid(field.size()).simplified().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+#endif
+
+// Returns -1 where it is not available
+qint64 current_rss_kb()
+{
+#if defined(Q_OS_LINUX)
+    return status_field_kb(QByteArrayLiteral("VmRSS:"));
+#else
+    return -1;
+#endif
+}
+
+// The peak memory use is reset before each measured stage where possible,
+// otherwise it is the peak of the whole process so far
+qint64 peak_rss_kb()
+{
+#if defined(Q_OS_LINUX)
+    return status_field_kb(QByteArrayLiteral("VmHWM:"));
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(Q_OS_DARWIN)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+void reset_peak_rss()
+{
+#if defined(Q_OS_LINUX)
+    QFile file(QStringLiteral("/proc/self/clear_refs"));
+    if (file.open(QIODevice::WriteOnly))
+        file.write("5");
+#endif
+}
+
+QString to_mib(qint64 kb)
+{
+    return kb < 0
+        ? QStringLiteral("n/a")
+        : QString::number(static_cast<double>(kb) / 1024.0, 'f', 1) + QStringLiteral(" MiB");
+}
+} // namespace
+
+
+class bench_ScanPipeline : public QObject {
+    Q_OBJECT
+
+private slots:
+    void parse_metafiles_data() { library_rows(); }
+    void parse_metafiles() { bench_stage(Stage::PARSE_METAFILES); }
+    void walk_filters_data() { library_rows(); }
+    void walk_filters() { bench_stage(Stage::WALK_FILTERS); }
+    void finalize_lists_data() { library_rows(); }
+    void finalize_lists() { bench_stage(Stage::FINALIZE_LISTS); }
+    void find_assets_data() { library_rows(); }
+    void find_assets() { bench_stage(Stage::FIND_ASSETS); }
+    void consume_data() { library_rows(); }
+    void consume() { bench_stage(Stage::CONSUME); }
+    void facet_index_data() { library_rows(); }
+    void facet_index() { bench_stage(Stage::FACET_INDEX); }
+    void static_data_handover_data() { library_rows(); }
+    void static_data_handover() { bench_stage(Stage::STATIC_DATA_HANDOVER); }
+    void dynamic_data_data() { library_rows(); }
+    void dynamic_data() { bench_stage(Stage::DYNAMIC_DATA); }
+
+private:
+    QTemporaryDir m_tmp_dir;
+    std::map<QString, GeneratedLibrary> m_libraries;
+
+    void library_rows();
+    const GeneratedLibrary& library();
+    void bench_stage(Stage);
+};
+
+
+// The custom row can be set as `collections,games,files,media,unlisted_every`
+// in the PEGASUS_BENCH_LIBRARY environment variable
+void bench_ScanPipeline::library_rows()
+{
+    QTest::addColumn<int>("collections");
+    QTest::addColumn<int>("games_per_collection");
+    QTest::addColumn<int>("files_per_game");
+    QTest::addColumn<int>("media_per_game");
+    QTest::addColumn<int>("unlisted_every");
+
+    QTest::newRow("small") << 4 << 250 << 1 << 2 << 4;
+    QTest::newRow("many collections") << 64 << 100 << 1 << 1 << 4;
+    QTest::newRow("multi-file games") << 8 << 500 << 3 << 3 << 4;
+    QTest::newRow("media heavy") << 4 << 1000 << 1 << 8 << 4;
+    // 9 entries per game, ~100k entries in total
+    QTest::newRow("large metafile") << 1 << 11000 << 1 << 1 << 0;
+
+    const QStringList custom = qEnvironmentVariable("PEGASUS_BENCH_LIBRARY")
+        .split(QLatin1Char(','), QString::SkipEmptyParts);
+    if (custom.size() == 5) {
+        QTest::newRow("custom")
+            << custom.at(0).toInt() << custom.at(1).toInt() << custom.at(2).toInt()
+            << custom.at(3).toInt() << custom.at(4).toInt();
+    }
+}
+
+const GeneratedLibrary& bench_ScanPipeline::library()
+{
+    const QString tag = QString::fromUtf8(QTest::currentDataTag());
+
+    const auto it = m_libraries.find(tag);
+    if (it != m_libraries.cend())
+        return it->second;
+
+    QFETCH(int, collections);
+    QFETCH(int, games_per_collection);
+    QFETCH(int, files_per_game);
+    QFETCH(int, media_per_game);
+    QFETCH(int, unlisted_every);
+    const LibraryConfig config {
+        collections,
+        games_per_collection,
+        files_per_game,
+        media_per_game,
+        unlisted_every,
+    };
+
+    const QString root_dir = m_tmp_dir.filePath(QStringLiteral("library_%1").arg(m_libraries.size()));
+    QDir().mkpath(root_dir);
+
+    QElapsedTimer timer;
+    timer.start();
+    GeneratedLibrary library = generate_library(root_dir, config);
+
+    qInfo().noquote() << QStringLiteral("Generated `%1` in %2ms: %3 games, %4 files, %5 media files, %6 metafile entries")
+        .arg(tag, QString::number(timer.elapsed()))
+        .arg(library.game_cnt).arg(library.file_cnt).arg(library.media_cnt).arg(library.metafile_entry_cnt);
+
+    return m_libraries.emplace(tag, std::move(library)).first->second;
+}
+
+void bench_ScanPipeline::bench_stage(Stage measured_stage)
+{
+    QVERIFY(m_tmp_dir.isValid());
+    const GeneratedLibrary& lib = library();
+
+    PipelineState state;
+    for (unsigned char s = 0; s < static_cast<unsigned char>(measured_stage); s++)
+        run_stage(static_cast<Stage>(s), lib, state);
+
+    reset_peak_rss();
+    const qint64 rss_before = current_rss_kb();
+
+    QBENCHMARK_ONCE {
+        run_stage(measured_stage, lib, state);
+    }
+
+    const qint64 peak_rss = peak_rss_kb();
+    qInfo().noquote() << QStringLiteral("%1 (%2): peak RSS %3, %4 at the start of the stage")
+        .arg(QString::fromLatin1(QTest::currentTestFunction()),
+             QString::fromUtf8(QTest::currentDataTag()),
+             to_mib(peak_rss),
+             to_mib(rss_before));
+
+    // every generated game should be found once the files are walked
+    if (measured_stage >= Stage::CONSUME)
+        QCOMPARE(state.games.size(), lib.game_cnt);
+    else if (measured_stage >= Stage::WALK_FILTERS)
+        QCOMPARE(static_cast<int>(state.sctx.games().size()), lib.game_cnt);
+}
+
+
+QTEST_MAIN(bench_ScanPipeline)
+#include "bench_ScanPipeline.moc"
@@ -0,0 +1,8 @@
+TARGET = bench_ScanPipeline
+SOURCES = \
+    $${TARGET}.cpp \
+    LibraryGenerator.cpp
+HEADERS = \
+    LibraryGenerator.h
+
+include($${TOP_SRCDIR}/tests/cxxtest_common.pri)
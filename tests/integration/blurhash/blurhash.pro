@@ -3,6 +3,7 @@ SOURCES = $${TARGET}.cpp
 RESOURCES += data.qrc
 
 OTHER_FILES += \
+    tst_benchmark.qml \
     tst_render.qml
 
 include($${TOP_SRCDIR}/tests/qmltest_common.pri)
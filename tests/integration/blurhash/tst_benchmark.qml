@@ -0,0 +1,78 @@
+// Pegasus Frontend
+// Copyright (C) 2017-2020  Mátyás Mustoha
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+
+import QtQuick 2.0
+import QtTest 1.11
+
+
+Item {
+    id: root
+
+    readonly property var hashes: [
+        "LEHV6nWB2yk8pyoJadR*.7kCMdnj",
+        "LGF5]+Yk^6#M@-5c,1J5@[or[Q6.",
+        "L6Pj0^i_.AyE_3t7t7R**0o#DgR4",
+        "LKO2?U%2Tw=w]~RBVZRi};RPxuwH",
+    ]
+    // every run uses a new size, so the decoded images are not reused
+    property int sizeOffset: 0
+
+    width: 256
+    height: 256
+
+    Image {
+        id: image
+        cache: false
+    }
+
+    SignalSpy {
+        id: statusSpy
+        target: image
+        signalName: "statusChanged"
+    }
+
+
+    TestCase {
+        when: windowShown
+
+        function load(hash, size) {
+            image.sourceSize = Qt.size(size, size);
+            image.source = "image://blurhash/" + encodeURIComponent(hash);
+            while (image.status === Image.Loading)
+                statusSpy.wait(1000);
+
+            compare(image.status, Image.Ready);
+        }
+
+        function benchmark_decode_small() {
+            sizeOffset = (sizeOffset + 1) % 256;
+            for (let i = 0; i < hashes.length; i++)
+                load(hashes[i], 24 + sizeOffset);
+        }
+
+        function benchmark_decode_large() {
+            sizeOffset = (sizeOffset + 1) % 256;
+            for (let i = 0; i < hashes.length; i++)
+                load(hashes[i], 256 + sizeOffset);
+        }
+
+        function benchmark_cached() {
+            for (let i = 0; i < hashes.length; i++)
+                load(hashes[i], 128);
+        }
+    }
+}